@@ -192,6 +192,7 @@ public:
         }
       },
       .indexBuffer = indexBuffer,
+      .indexFormat = WGPUIndexFormat_Uint16,
       .count = static_cast<uint32_t>(indices.size()),
       },
     pipeline(ctx, {
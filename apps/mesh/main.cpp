@@ -1,14 +1,35 @@
 #include <SDL3/SDL.h>
+#include <map>
 #include "common.hpp"
 #include "primitive.hpp"
 #include "math.hpp"
-#include "read_off.hpp"
+#include "asset.hpp"
+#include "read_mesh.hpp"
+#include "mesh_cache.hpp"
+#include "triangulate.hpp"
+#include "weld.hpp"
+#include "vertex_cache.hpp"
+#include "overdraw.hpp"
+#include "vertex_fetch.hpp"
+#include "simplify.hpp"
+#include "normals.hpp"
+#include "mesh_stats.hpp"
+#include "bvh.hpp"
+#include "occlusion.hpp"
+#include "quantize.hpp"
 
 struct CameraUniform {
   std::array<float, 16> view;
   std::array<float, 16> proj;
 };
 
+// Model matrix of the mesh with the dequantization of its positions folded
+// in, and the plain one for its normals.
+struct MeshUniform {
+  std::array<float, 16> position;
+  std::array<float, 16> normal;
+};
+
 class GnomonGeometry {
 private:
   std::vector<float> vertices;
@@ -122,31 +143,215 @@ public:
   }
 };
 
+// Version of what loadMesh writes into the cache. Bump it whenever the
+// streams or how they are computed change (welding, ordering, levels of
+// detail, quantization, ...), so caches written before are rebuilt.
+constexpr uint32_t meshPipeline = 3;
+
+// Returns the normalized mesh, its normals and its colors from the binary
+// cache at `path`, rebuilding the cache from the OFF, PLY or STL source when
+// it is stale. Normals and colors come from the file when it has them;
+// otherwise normals are smoothed over the triangles and colors are derived
+// from positions. Polygons are triangulated for the triangle list pipeline. Meshes without
+// per-vertex attributes have repeated positions welded, and triangles are
+// reordered for the post-transform vertex cache and then for less overdraw;
+// vertices are then renumbered in the order the triangles use them. The
+// index stream also holds a chain of simplified levels of detail.
+MeshCache loadMesh(const std::string& source, const std::string& path) {
+  MeshCache cache;
+  if (cache.open(path) && cache.isFresh(source) && cache.header->pipeline == meshPipeline)
+    return cache;
+
+  std::vector<float> vertices;
+  std::vector<uint32_t> faces;
+  MeshAttributes<float> attributes;
+  if (!readMesh(source, vertices, faces, &attributes)) throw std::runtime_error("readMesh failed");
+
+  if (!isTriangleMesh(attributes.faceSizes)) {
+    std::vector<uint32_t> triangles, faceTriangles;
+    triangulate(vertices, faces, attributes.faceSizes, triangles, faceTriangles);
+    faces.swap(triangles);
+  }
+  if (attributes.normals.empty() && attributes.colors.empty()) {
+    auto welded = weldVertices(vertices, faces);
+    if (welded.removed()) printf("welded %zu of %zu vertices\n", welded.removed(), welded.vertices);
+  }
+  auto acmr = [&] { return vcache::analyze(faces, vertices.size() / 3).acmr; };
+  auto shaded = [&] { return overdraw::analyze(vertices, faces, 256, false).overdraw; };
+  auto fetch = [&] { return vfetch::analyze(faces, vertices.size() / 3); };
+  double acmrBefore = acmr(), overdrawBefore = shaded();
+  vfetch::Statistics fetchBefore = fetch();
+  optimizeVertexCache(faces, vertices.size() / 3);
+  optimizeOverdraw(faces, vertices);
+  bool renumbered = optimizeVertexFetch(faces, vertices, &attributes);
+  vfetch::Statistics fetchAfter = fetch();
+  printf("vertex cache ACMR %.3f -> %.3f, overdraw %.3f -> %.3f, overfetch %.2f -> %.2f, fetch distance %.1f -> %.1f%s\n",
+    acmrBefore, acmr(), overdrawBefore, shaded(), fetchBefore.overfetch, fetchAfter.overfetch,
+    fetchBefore.distance, fetchAfter.distance, renumbered ? "" : ", vertex order kept");
+  // on the calling thread: computeNormals has yet to beat it where measured
+  if (attributes.normals.empty()) computeNormalsSerial(vertices, faces, attributes.normals);
+
+  // centered on the centroid and scaled by the largest coordinate from it
+  MeshStats stats = computeMeshStats(vertices, { { attributes.normals.data(), 3 } });
+  float scale = 0;
+  for (int k = 0; k < 3; k++) scale = std::max(scale, stats.positions.max[k] - stats.positions.mean[k]);
+  float center[3] = { stats.positions.mean[0], stats.positions.mean[1], stats.positions.mean[2] };
+  Eigen::Index n = vertices.size() / 3;
+  Eigen::Map<Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> mat(vertices.data(), n, 3);
+  mat = (mat.rowwise() - Eigen::Map<Eigen::RowVector3f>(center)) / scale;
+  stats.normalize(center, scale);
+
+  // simplified after normalizing, so the errors are in the units drawn
+  std::vector<meshcache::Level> levels;
+  std::vector<uint32_t> chain;
+  for (auto& lod : buildLods(vertices, faces)) {
+    levels.push_back({ uint32_t(chain.size()), uint32_t(lod.indices.size()), lod.error, 0 });
+    chain.insert(chain.end(), lod.indices.begin(), lod.indices.end());
+    printf("level of detail %zu: %zu triangles, error %.2g\n", levels.size() - 1, lod.indices.size() / 3, lod.error);
+  }
+  IndexStream indices;
+  indices.assign(std::move(chain), n);
+
+  // baked once per geometry, so a cache rebuilt for any other reason keeps it
+  std::vector<float> occlusion;
+  uint64_t key = occlusion::key(vertices, attributes.normals, faces, 64, .5f);
+  if (!occlusion::read(path + ".ao", key, occlusion)) {
+    bvh::Tree tree;
+    buildBvh(vertices, faces, tree);
+    bakeOcclusion(vertices, attributes.normals, faces, tree, occlusion, 64, .5f);
+    occlusion::write(path + ".ao", key, occlusion);
+  }
+
+  std::vector<meshcache::Range> ranges(2);
+  auto record = [](meshcache::Range& out, meshcache::Semantic semantic, const meshstats::Range& range) {
+    out = { semantic, 3, {}, {}, {}, {}, {} };
+    std::copy_n(range.min, 4, out.min), std::copy_n(range.max, 4, out.max), std::copy_n(range.mean, 4, out.mean);
+  };
+  record(ranges[0], meshcache::Position, stats.positions);
+  std::copy_n(stats.sphere.center, 3, ranges[0].sphere);
+  ranges[0].sphere[3] = stats.sphere.radius;
+  record(ranges[1], meshcache::Normal, stats.attributes[0]);
+  // colored by position unless the file has colors
+  std::vector<float> colors;
+  if (attributes.colors.empty()) {
+    colors.resize(n * 3);
+    Eigen::Map<Eigen::RowVector3f> low(stats.positions.min), high(stats.positions.max);
+    Eigen::Map<Eigen::Array<float, Eigen::Dynamic, 3, Eigen::RowMajor>>(colors.data(), n, 3) =
+      (mat.rowwise() - low).array().rowwise() / (high - low).array();
+  }
+
+  // packed into the formats the GPU fetches, positions over the box of the stats
+  meshcodec::Bounds box;
+  std::copy_n(stats.positions.min, 3, box.v), std::copy_n(stats.positions.max, 3, box.v + 3);
+  quantize::Packed packed;
+  quantizeVertices(vertices, box, attributes.normals, colors, 3, packed);
+  std::vector<meshcache::StreamData> streams = packed.streams();
+  streams.insert(streams.end(), {
+    {
+      .semantic = meshcache::Index,
+      .format = indices.isWide() ? meshcache::Uint32 : meshcache::Uint16,
+      .components = 1,
+      .data = indices.data(),
+      .count = indices.size()
+    },
+    {.semantic = meshcache::Levels, .format = meshcache::Uint32, .components = 4, .data = levels.data(), .count = levels.size() },
+    {.semantic = meshcache::Stats, .format = meshcache::Float32, .components = 20, .data = ranges.data(), .count = ranges.size() },
+    {.semantic = meshcache::Occlusion, .format = meshcache::Float32, .components = 1, .data = occlusion.data(), .count = uint64_t(n) },
+    });
+  if (colors.empty())
+    streams.push_back({ .semantic = meshcache::Color, .format = meshcache::Unorm8, .components = 4, .data = attributes.colors.data(), .count = uint64_t(n) });
+
+  // bytes per vertex over the streams as written, against the same streams
+  // with positions, normals and derived colors as Float32 x 3
+  auto bytesPerVertex = [&](const std::vector<meshcache::StreamData>& list) {
+    size_t bytes = 0;
+    for (const auto& s : list)
+      if (s.semantic != meshcache::Index && s.count == uint64_t(n)) bytes += s.components * meshcache::formatSize(s.format);
+    return bytes;
+  };
+  std::vector<meshcache::StreamData> floats = streams;
+  for (auto& s : floats)
+    if (s.semantic == meshcache::Position || s.semantic == meshcache::Normal || (s.semantic == meshcache::Color && !colors.empty()))
+      s.format = meshcache::Float32, s.components = 3;
+  printf("vertex streams %zu -> %zu bytes per vertex, error: position %.2g, normal %.3f degrees, color %.2f / 255\n",
+    bytesPerVertex(floats), bytesPerVertex(streams), packed.error.position, packed.error.normal * 180 / M_PI, packed.error.color * 255);
+
+  meshcache::Source stamp;
+  if (!meshcache::Source::of(source, stamp) || !meshcache::write(path, stamp, streams, meshPipeline) || !cache.open(path))
+    throw std::runtime_error("failed to write mesh cache");
+  return cache;
+}
+
+// The vertex format a cache stream is uploaded and fetched as.
+WGPUVertexFormat vertexFormat(const meshcache::Stream& stream) {
+  static const std::map<std::pair<uint32_t, uint32_t>, WGPUVertexFormat> formats{
+    { { meshcache::Float32, 1 }, WGPUVertexFormat_Float32 },
+    { { meshcache::Float32, 2 }, WGPUVertexFormat_Float32x2 },
+    { { meshcache::Float32, 3 }, WGPUVertexFormat_Float32x3 },
+    { { meshcache::Float32, 4 }, WGPUVertexFormat_Float32x4 },
+    { { meshcache::Unorm16, 2 }, WGPUVertexFormat_Unorm16x2 },
+    { { meshcache::Unorm16, 4 }, WGPUVertexFormat_Unorm16x4 },
+    { { meshcache::Snorm16, 2 }, WGPUVertexFormat_Snorm16x2 },
+    { { meshcache::Snorm16, 4 }, WGPUVertexFormat_Snorm16x4 },
+    { { meshcache::Unorm8, 2 }, WGPUVertexFormat_Unorm8x2 },
+    { { meshcache::Unorm8, 4 }, WGPUVertexFormat_Unorm8x4 },
+    { { meshcache::Snorm8, 2 }, WGPUVertexFormat_Snorm8x2 },
+    { { meshcache::Snorm8, 4 }, WGPUVertexFormat_Snorm8x4 },
+  };
+  auto format = formats.find({ stream.format, stream.components });
+  if (format == formats.end()) throw std::runtime_error("no vertex format for mesh stream");
+  return format->second;
+}
+
 class MeshGeometry {
 private:
-  std::vector<float> vertices;
-  std::vector<uint16_t> indices;
+  MeshCache cache;
 
-  const char* shaderSource = R"(
+  // Positions in any format come out of the vertex fetch as floats in model
+  // units once model.position has the dequantization folded in; normals
+  // stored on the octahedron are unfolded here.
+  std::string shaderSource = std::string("const octahedral = ") +
+    (cache.find(meshcache::Normal)->format == meshcache::Snorm16 ? "true" : "false") + ";\n" + R"(
   struct Camera {
     view : mat4x4f,
     proj : mat4x4f,
   }
 
+  struct Model {
+    position : mat4x4f,
+    normal : mat4x4f,
+  }
+
   struct VSOutput {
     @builtin(position) position: vec4f,
-    @location(0) normal: vec3f,
+    @location(0) color: vec3f,
   };
 
   @group(0) @binding(0) var<uniform> camera : Camera;
-  @group(0) @binding(1) var<uniform> model : mat4x4f;
+  @group(0) @binding(1) var<uniform> model : Model;
+
+  // meshcodec::octDecode
+  fn octDecode(e: vec2f) -> vec3f {
+    var n = vec3f(e, 1 - abs(e.x) - abs(e.y));
+    let t = max(-n.z, 0.);
+    n.x += select(t, -t, n.x >= 0.);
+    n.y += select(t, -t, n.y >= 0.);
+    return normalize(n);
+  }
 
   @vertex fn vs(
     @location(0) position: vec3f,
-    @location(1) color: vec3f) -> VSOutput {
-
-    var pos = camera.proj * camera.view * model * vec4f(position, 1);
-    return VSOutput(pos, color);
+    @location(1) color: vec3f,
+    @location(2) normal: vec3f,
+    @location(3) occlusion: f32) -> VSOutput {
+
+    var pos = camera.proj * camera.view * model.position * vec4f(position, 1);
+    // a light over the viewer's shoulder, in view space, dimmed where the
+    // baked occlusion closes the surface in
+    let unit = select(normal, octDecode(normal.xy), octahedral);
+    let n = (camera.view * model.normal * vec4f(unit, 0)).xyz;
+    let light = .25 + .75 * max(dot(n, normalize(vec3f(.3, .5, 1))), 0.);
+    return VSOutput(pos, color * light * occlusion);
   }
 
   @fragment fn fs(@location(0) color: vec3f) -> @location(0) vec4f {
@@ -154,31 +359,57 @@ private:
   }
   )";
 public:
+  std::vector<meshcache::Level> levels;
+  std::vector<float> errors;
+  float radius = 0;
+  // from the positions as stored to model units
+  Eigen::Matrix4f dequantize = Eigen::Matrix4f::Identity();
+
+  // the finest level on the CPU, for picking
+  std::vector<float> positions;
+  std::vector<uint32_t> triangles;
+  bvh::Tree bvh;
+
   WGPU::Buffer vertexBuffer0;
   WGPU::Buffer vertexBuffer1;
+  WGPU::Buffer vertexBuffer2;
+  WGPU::Buffer vertexBuffer3;
   WGPU::Buffer indexBuffer;
   WGPU::IndexedGeometry geom;
 
   WGPU::RenderPipeline pipeline;
 
-  MeshGeometry(WGPU::Context& ctx, const std::vector<WGPU::RenderPipeline::BindGroupEntry>& bindGroups) :
-    vertices(3395 * 3),
-    indices(6786 * 3),
+  // Waits for the asset only here, after the device exists, so parsing and
+  // device creation overlap.
+  MeshGeometry(WGPU::Context& ctx, Asset<MeshCache>& asset, const std::vector<WGPU::RenderPipeline::BindGroupEntry>& bindGroups) :
+    cache(asset.get()),
     vertexBuffer0(ctx, {
       .label = "vertex",
-      .size = vertices.size() * sizeof(float),
+      .size = cache.find(meshcache::Position)->size,
       .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Vertex,
       .mappedAtCreation = false
       }),
     vertexBuffer1(ctx, {
       .label = "vertex",
-      .size = vertices.size() * sizeof(float),
+      .size = cache.find(meshcache::Color)->size,
+      .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Vertex,
+      .mappedAtCreation = false
+      }),
+    vertexBuffer2(ctx, {
+      .label = "vertex",
+      .size = cache.find(meshcache::Normal)->size,
+      .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Vertex,
+      .mappedAtCreation = false
+      }),
+    vertexBuffer3(ctx, {
+      .label = "vertex",
+      .size = cache.find(meshcache::Occlusion)->size,
       .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Vertex,
       .mappedAtCreation = false
       }),
     indexBuffer(ctx, {
       .label = "index",
-      .size = (indices.size() * sizeof(uint16_t) + 3) & ~3, // round up to the next multiple of 4
+      .size = (cache.find(meshcache::Index)->size + 3) & ~3, // round up to the next multiple of 4
       .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Index,
       .mappedAtCreation = false
       }),
@@ -193,25 +424,42 @@ public:
         {
           .buffer = vertexBuffer0,
           .attributes = {
-            {.shaderLocation = 0, .format = WGPUVertexFormat_Float32x3, .offset = 0 },
+            {.shaderLocation = 0, .format = vertexFormat(*cache.find(meshcache::Position)), .offset = 0 },
           },
-          .arrayStride = 3 * sizeof(float),
+          .arrayStride = cache.find(meshcache::Position)->stride,
           .stepMode = WGPUVertexStepMode_Vertex
         },
         {
           .buffer = vertexBuffer1,
           .attributes = {
-            {.shaderLocation = 1, .format = WGPUVertexFormat_Float32x3, .offset = 0 },
+            {.shaderLocation = 1, .format = vertexFormat(*cache.find(meshcache::Color)), .offset = 0 },
+          },
+          .arrayStride = cache.find(meshcache::Color)->stride,
+          .stepMode = WGPUVertexStepMode_Vertex
+        },
+        {
+          .buffer = vertexBuffer2,
+          .attributes = {
+            {.shaderLocation = 2, .format = vertexFormat(*cache.find(meshcache::Normal)), .offset = 0 },
+          },
+          .arrayStride = cache.find(meshcache::Normal)->stride,
+          .stepMode = WGPUVertexStepMode_Vertex
+        },
+        {
+          .buffer = vertexBuffer3,
+          .attributes = {
+            {.shaderLocation = 3, .format = vertexFormat(*cache.find(meshcache::Occlusion)), .offset = 0 },
           },
-          .arrayStride = 3 * sizeof(float),
+          .arrayStride = cache.find(meshcache::Occlusion)->stride,
           .stepMode = WGPUVertexStepMode_Vertex
         }
       },
       .indexBuffer = indexBuffer,
-      .count = static_cast<uint32_t>(indices.size()),
+      .indexFormat = cache.find(meshcache::Index)->format == meshcache::Uint32 ? WGPUIndexFormat_Uint32 : WGPUIndexFormat_Uint16,
+      .count = static_cast<uint32_t>(cache.header->indexCount),
       },
     pipeline(ctx, {
-      .source = shaderSource,
+      .source = shaderSource.c_str(),
       .bindGroups = bindGroups,
       .vertex = {
         .entryPoint = "vs",
@@ -247,22 +495,60 @@ public:
       }
     )
   {
-    readOFF("../../data/screwdriver.off", vertices, indices);
+    {
+      Timeline::Scope scope("upload mesh");
+      // the cache pads every stream to 16 bytes, so these reads stay inside the mapping
+      geom.vertexBuffers[0].buffer.write(cache.data(*cache.find(meshcache::Position)));
+      geom.vertexBuffers[1].buffer.write(cache.data(*cache.find(meshcache::Color)));
+      geom.vertexBuffers[2].buffer.write(cache.data(*cache.find(meshcache::Normal)));
+      geom.vertexBuffers[3].buffer.write(cache.data(*cache.find(meshcache::Occlusion)));
+      geom.indexBuffer.write(cache.data(*cache.find(meshcache::Index)));
+    }
 
-    Eigen::Map<Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> mat(vertices.data(), 3395, 3);
-    mat = (mat.rowwise() - mat.colwise().mean()) / mat.maxCoeff();
-    geom.vertexBuffers[0].buffer.write(vertices.data());
+    auto table = cache.find(meshcache::Levels);
+    auto first = static_cast<const meshcache::Level*>(cache.data(*table));
+    levels.assign(first, first + table->size / sizeof(meshcache::Level));
+    for (auto& level : levels) errors.push_back(level.error);
+    // the bounding sphere, grown to be centered on the origin
+    auto sphere = static_cast<const meshcache::Range*>(cache.data(*cache.find(meshcache::Stats)))->sphere;
+    radius = Eigen::Map<const Eigen::Vector3f>(sphere).norm() + sphere[3];
+
+    auto position = cache.find(meshcache::Position);
+    meshcodec::Bounds box;
+    std::copy_n(cache.header->boundsMin, 3, box.v), std::copy_n(cache.header->boundsMax, 3, box.v + 3);
+    if (position->format == meshcache::Unorm16) quantize::dequantization(box, dequantize.data());
+
+    Timeline::Scope scope("build bvh");
+    positions.resize(cache.header->vertexCount * 3);
+    if (position->format == meshcache::Unorm16)
+      meshcodec::dequantizePositions(static_cast<const uint16_t*>(cache.data(*position)), cache.header->vertexCount, box,
+        positions.data(), position->components);
+    else std::memcpy(positions.data(), cache.data(*position), positions.size() * sizeof(float));
+    auto indices = cache.find(meshcache::Index);
+    auto copy = [&](auto* first) {
+      triangles.assign(first + levels[0].firstIndex, first + levels[0].firstIndex + levels[0].indexCount);
+    };
+    if (indices->format == meshcache::Uint32) copy(static_cast<const uint32_t*>(cache.data(*indices)));
+    else copy(static_cast<const uint16_t*>(cache.data(*indices)));
+    buildBvh(positions, triangles, bvh);
+  }
 
-    auto colors = (mat.rowwise() - mat.colwise().minCoeff()).array().rowwise() /
-      (mat.colwise().maxCoeff() - mat.colwise().minCoeff()).array();
-    geom.vertexBuffers[1].buffer.write(colors.eval().data());
+  // The closest point of the finest level along `ray`, in model space.
+  bool pick(const bvh::Ray& ray, bvh::Hit& hit) const {
+    return bvh::intersect(bvh, positions.data(), triangles.data(), ray, hit);
+  }
 
-    geom.indexBuffer.write(indices.data());
+  // Coarsest level whose error stays under `pixels` on a viewport
+  // `height` pixels tall, for the mesh at the origin.
+  size_t selectLevel(const Camera& camera, float height, float pixels = 1) const {
+    float distance = camera.object.position.norm() - radius;
+    return simplify::selectLod(errors, distance, camera.perspective.fov, height, pixels);
   }
 
-  void draw(WGPU::RenderPass& pass) {
+  void draw(WGPU::RenderPass& pass, size_t level = 0) {
+    geom.count = levels[level].indexCount;
     pass.setPipeline(pipeline);
-    pass.draw(geom);
+    pass.draw(geom, 1, levels[level].firstIndex);
   }
 };
 
@@ -270,6 +556,7 @@ class Application : public WGPUApplication {
 public:
   WGPU::Buffer uCamera;
   WGPU::Buffer uModel;
+  WGPU::Buffer uMesh;
 
   GnomonGeometry gnomon;
   MeshGeometry mesh;
@@ -293,11 +580,14 @@ public:
 
   struct {
     bool isDown = false;
+    // the point the camera orbits, on the surface where the drag began
+    Eigen::Vector3f target = { 0, 0, 0 };
 
     Eigen::Vector3f dir = { 0, M_PI_2,1 };
+    float pixelError = 1;
   } state;
 
-  Application() : WGPUApplication(1280, 720),
+  Application(Asset<MeshCache>& meshAsset) : WGPUApplication(1280, 720),
     uCamera(ctx, {
       .label = "camera",
       .size = sizeof(CameraUniform),
@@ -310,6 +600,12 @@ public:
         .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Uniform,
         .mappedAtCreation = false,
         }),
+      uMesh(ctx, {
+        .label = "mesh model",
+        .size = sizeof(MeshUniform),
+        .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Uniform,
+        .mappedAtCreation = false,
+        }),
         gnomon(ctx, {
             {
               .label = "camera",
@@ -339,7 +635,7 @@ public:
               }
             }
           }),
-    mesh(ctx, {
+    mesh(ctx, meshAsset, {
       {
         .label = "camera",
         .entries = {
@@ -356,13 +652,13 @@ public:
           },
           {
             .binding = 1,
-            .buffer = &uModel,
+            .buffer = &uMesh,
             .offset = 0,
             .visibility = WGPUShaderStage_Vertex,
             .layout = {
               .type = WGPUBufferBindingType_Uniform,
               .hasDynamicOffset = false,
-              .minBindingSize = uModel.size,
+              .minBindingSize = uMesh.size,
             }
           }
         }
@@ -389,12 +685,37 @@ public:
     wgpuTextureRelease(depthTexture);
   }
 
+  Eigen::Matrix4f model = Eigen::Matrix4f::Identity();
+
+  // Casts a ray from the camera through `mouse` (as OrbitControl takes it)
+  // and moves the orbit target to where it meets the mesh; a miss keeps the
+  // previous target.
+  void pick(const Eigen::Vector2f& mouse) {
+    Eigen::Matrix4f proj, view;
+    math::perspective(proj, camera.perspective.fov, camera.perspective.aspect, camera.perspective.near, camera.perspective.far);
+    lookAt(view, camera.object);
+    Eigen::Matrix4f inverse = (proj * view * model).inverse();
+    Eigen::Vector4f point = inverse * Eigen::Vector4f(mouse.x() / ctx.aspect, -mouse.y(), .5f, 1);
+    Eigen::Vector4f eye = model.inverse() * camera.object.position.homogeneous();
+    Eigen::Vector3f origin = eye.head<3>(), direction = point.head<3>() / point.w() - origin;
+
+    bvh::Ray ray;
+    Eigen::Map<Eigen::Vector3f>(ray.origin) = origin;
+    Eigen::Map<Eigen::Vector3f>(ray.direction) = direction;
+    bvh::Hit hit;
+    if (mesh.pick(ray, hit))
+      state.target = (model * (origin + direction * hit.distance).homogeneous()).head<3>();
+  }
+
   void render() {
     Eigen::Vector3f vec;
     Eigen::Quaternionf rot;
-    Eigen::Matrix4f m;
-    math::rotation(m, math::betweenZ(rot, math::sph2cart(vec, state.dir)));
-    uModel.write(m.data());
+    math::rotation(model, math::betweenZ(rot, math::sph2cart(vec, state.dir)));
+    uModel.write(model.data());
+    MeshUniform meshUniform;
+    Eigen::Map<Eigen::Matrix4f>(meshUniform.position.data()) = model * mesh.dequantize;
+    Eigen::Map<Eigen::Matrix4f>(meshUniform.normal.data()) = model;
+    uMesh.write(&meshUniform);
 
     CameraUniform uniformData{};
     math::perspective(Eigen::Map<Eigen::Matrix4f>(uniformData.proj.data()),
@@ -404,6 +725,8 @@ public:
     lookAt(Eigen::Map<Eigen::Matrix4f>(uniformData.view.data()), camera.object);
     uCamera.write(&uniformData);
 
+    size_t level = mesh.selectLevel(camera, std::get<1>(ctx.size), state.pixelError);
+
     WGPUTextureView view = ctx.surfaceTextureCreateView();
     std::vector<WGPUCommandBuffer> commands;
 
@@ -448,7 +771,7 @@ public:
       };
       WGPU::RenderPass pass = encoder.renderPass(&passDescriptor);
       gnomon.draw(pass);
-      mesh.draw(pass);
+      mesh.draw(pass, level);
       pass.end();
 
       WGPUCommandBufferDescriptor commandDescriptor{};
@@ -467,10 +790,12 @@ public:
       mouse *= 2.;
       mouse.array() -= 1.;
       mouse.x() *= ctx.aspect;
-      if (state.isDown != ImGui::IsMouseDown(0) && !state.isDown)
+      if (state.isDown != ImGui::IsMouseDown(0) && !state.isDown) {
+        pick(mouse);
         orbit.begin(mouse);
+      }
       if ((state.isDown = ImGui::IsMouseDown(0)))
-        orbit.end(mouse, Eigen::Vector3f(0, 0, 0));
+        orbit.end(mouse, state.target);
     }
 
     {
@@ -479,6 +804,8 @@ public:
       ImGui::Begin("Controls");
       ImGui::SliderFloat("phi", &state.dir.x(), 0.0f, M_PI * 2.);
       ImGui::SliderFloat("theta", &state.dir.y(), -M_PI_2, M_PI_2);
+      ImGui::SliderFloat("pixel error", &state.pixelError, .25f, 64.f, "%.2f", ImGuiSliderFlags_Logarithmic);
+      ImGui::Text("level %zu, %u triangles", level, mesh.levels[level].indexCount / 3);
 
       ImGui::End();
     }
@@ -495,7 +822,10 @@ public:
 };
 
 int main(int argc, char** argv) try {
-  Application app;
+  // start parsing before SDL and the device are initialized
+  Asset<MeshCache> meshAsset("load mesh", [] { return loadMesh("../../data/screwdriver.off", "screwdriver.mesh"); });
+  Application app(meshAsset);
+  Timeline::shared().print();
 
   SDL_Event event;
   for (bool running = true; running;) {
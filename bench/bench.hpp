@@ -0,0 +1,232 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+#ifndef BENCH_COMMIT
+#define BENCH_COMMIT "unknown"
+#endif
+
+namespace bench {
+  // Heap allocations through operator new, counted by the replacements below.
+  inline std::atomic<uint64_t> allocations{ 0 };
+  inline std::atomic<uint64_t> allocatedBytes{ 0 };
+
+  // Peak resident set size of the process, in bytes. On Linux this is
+  // VmHWM, which resetPeakRSS() can lower again; elsewhere it is the peak
+  // of the whole process.
+  inline double peakRSS() {
+#ifdef __linux__
+    if (FILE* status = fopen("/proc/self/status", "r")) {
+      char line[256];
+      double kb = -1;
+      while (fgets(line, sizeof(line), status))
+        if (std::strncmp(line, "VmHWM:", 6) == 0) kb = std::atof(line + 6);
+      fclose(status);
+      if (kb >= 0) return kb * 1024.;
+    }
+#endif
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    return usage.ru_maxrss * 1024.;
+#endif
+  }
+
+  // Starts a new peak RSS measurement where the platform allows it.
+  inline void resetPeakRSS() {
+#ifdef __linux__
+    if (FILE* refs = fopen("/proc/self/clear_refs", "w")) {
+      fputs("5", refs);
+      fclose(refs);
+    }
+#endif
+  }
+
+  // Cost of the last run(): peak RSS during it and heap allocations per
+  // iteration. Memory mapped files are not heap allocations.
+  struct Measurement {
+    double peakRSS = 0;
+    double allocations = 0;
+    double allocatedBytes = 0;
+  };
+
+  inline Measurement last;
+
+  // Runs f `iterations` times and returns the best wall time in seconds.
+  template <typename F>
+  inline double run(int iterations, F&& f) {
+    resetPeakRSS();
+    uint64_t count = allocations, bytes = allocatedBytes;
+    double best = 1e300;
+    for (int i = 0; i < iterations; i++) {
+      auto t0 = std::chrono::steady_clock::now();
+      f();
+      auto t1 = std::chrono::steady_clock::now();
+      best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+    }
+    last.peakRSS = peakRSS();
+    last.allocations = double(allocations - count) / iterations;
+    last.allocatedBytes = double(allocatedBytes - bytes) / iterations;
+    return best;
+  }
+
+  struct Result {
+    std::string name;
+    double seconds;
+    double bytes;
+    double items;
+    std::string unit;
+    Measurement cost;
+  };
+
+  inline std::vector<Result> results;
+
+  // Prints a result of the last run() and keeps it for writeJSON.
+  inline void report(const char* name, double seconds, double bytes, double items, const char* unit) {
+    printf("%-40s %10.2f ms %10.1f MB/s %14.0f %s/s %8.1f MB peak %10.0f allocs\n",
+      name, seconds * 1e3, bytes / seconds / 1e6, items / seconds, unit, last.peakRSS / 1e6, last.allocations);
+    results.push_back({ name, seconds, bytes, items, unit, last });
+  }
+
+  // Command line shared by the benchmarks: [grid] [--large] [--json path].
+  struct Options {
+    int grid = 3163; // ~10M vertices, ~0.8 GB of OFF
+    bool large = false;
+    std::string json;
+
+    Options(int argc, char** argv) {
+      for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--json" && i + 1 < argc) json = argv[++i];
+        else if (arg == "--large") large = true, grid = 6000; // ~36M vertices, ~3 GB of OFF
+        else grid = std::atoi(argv[i]);
+      }
+    }
+  };
+
+  inline void writeJSONString(FILE* file, const std::string& s) {
+    fputc('"', file);
+    for (char c : s) {
+      if (c == '"' || c == '\\') fputc('\\', file);
+      if (static_cast<unsigned char>(c) >= 0x20) fputc(c, file);
+    }
+    fputc('"', file);
+  }
+
+  // Writes every reported result with the commit and machine it ran on.
+  inline bool writeJSON(const std::string& path, const char* benchmark) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+      printf("bench::writeJSON() failed, cannot open %s\n", path.c_str());
+      return false;
+    }
+    fprintf(file, "{\n  \"benchmark\": ");
+    writeJSONString(file, benchmark);
+    fprintf(file, ",\n  \"commit\": ");
+    writeJSONString(file, BENCH_COMMIT);
+    fprintf(file, ",\n  \"time\": %lld,\n  \"threads\": %u,\n  \"results\": [", (long long)std::time(nullptr), std::thread::hardware_concurrency());
+    for (size_t i = 0; i < results.size(); i++) {
+      auto& r = results[i];
+      fprintf(file, "%s\n    {\"name\": ", i ? "," : "");
+      writeJSONString(file, r.name);
+      fprintf(file, ", \"seconds\": %.9g, \"bytes\": %.17g, \"items\": %.17g, \"unit\": ", r.seconds, r.bytes, r.items);
+      writeJSONString(file, r.unit);
+      fprintf(file, ", \"bytes_per_second\": %.9g, \"items_per_second\": %.9g", r.bytes / r.seconds, r.items / r.seconds);
+      fprintf(file, ", \"peak_rss\": %.17g, \"allocations\": %.17g, \"allocated_bytes\": %.17g}",
+        r.cost.peakRSS, r.cost.allocations, r.cost.allocatedBytes);
+    }
+    fprintf(file, "\n  ]\n}\n");
+    return fclose(file) == 0;
+  }
+
+  inline int finish(const Options& options, const char* benchmark) {
+    return options.json.empty() || writeJSON(options.json, benchmark) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  // Writes an n x n vertex grid triangulated into 2 (n - 1)^2 faces.
+  inline void writeGrid(const std::string& path, int n) {
+    FILE* file = fopen(path.c_str(), "w");
+    fprintf(file, "OFF\n%d %d 0\n", n * n, 2 * (n - 1) * (n - 1));
+    for (int j = 0; j < n; j++)
+      for (int i = 0; i < n; i++)
+        fprintf(file, "%.6f %.6f %.6f\n", i / float(n), j / float(n), std::sin(i * .01f) * std::cos(j * .01f));
+    for (int j = 0; j < n - 1; j++)
+      for (int i = 0; i < n - 1; i++) {
+        int a = j * n + i, b = a + 1, c = a + n, d = c + 1;
+        fprintf(file, "3 %d %d %d\n3 %d %d %d\n", a, b, d, a, d, c);
+      }
+    fclose(file);
+  }
+
+  // Path of a synthetic n x n grid OFF in the working directory, written on first use.
+  inline std::string syntheticOFF(int n) {
+    std::string path = "synthetic_" + std::to_string(n) + ".off";
+    if (!std::filesystem::exists(path)) writeGrid(path, n);
+    return path;
+  }
+}
+
+namespace bench {
+  // Behind every replaced operator new: counted, and from malloc, or from
+  // aligned_alloc for over-aligned types, so that free releases all of it.
+  inline void* allocate(std::size_t size, std::size_t alignment = 0) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    size = size ? size : 1;
+    if (!alignment) return std::malloc(size);
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+  }
+
+  // Out of line, so GCC does not pair an inlined free() with the operator
+  // new that returned the pointer (-Wmismatched-new-delete).
+  [[gnu::noinline]] inline void release(void* p) noexcept { std::free(p); }
+}
+
+// Counting replacements of the global allocation functions. Every benchmark
+// is a single translation unit, so these are defined exactly once.
+void* operator new(std::size_t size) {
+  if (void* p = bench::allocate(size)) return p;
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  if (void* p = bench::allocate(size, std::size_t(alignment))) return p;
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return bench::allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return bench::allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return bench::allocate(size, std::size_t(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return bench::allocate(size, std::size_t(alignment));
+}
+
+void operator delete(void* p) noexcept { bench::release(p); }
+void operator delete[](void* p) noexcept { bench::release(p); }
+void operator delete(void* p, std::size_t) noexcept { bench::release(p); }
+void operator delete[](void* p, std::size_t) noexcept { bench::release(p); }
+void operator delete(void* p, std::align_val_t) noexcept { bench::release(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { bench::release(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { bench::release(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { bench::release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { bench::release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { bench::release(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { bench::release(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { bench::release(p); }
@@ -0,0 +1,51 @@
+#include <cstdio>
+#include <string>
+#include "bench.hpp"
+#include "bvh.hpp"
+#include "generate.hpp"
+#include "hash.hpp"
+
+// Rays from points around the mesh towards points inside its box, as a
+// camera orbiting it would cast.
+static std::vector<bvh::Ray> rays(size_t count) {
+  std::vector<bvh::Ray> out(count);
+  auto random = [](uint64_t i) { return float(hashMix(i) % 20001) / 10000 - 1; };
+  for (size_t i = 0; i < count; i++)
+    for (int k = 0; k < 3; k++) {
+      out[i].origin[k] = random(i * 6 + k) * 4;
+      out[i].direction[k] = random(i * 6 + 3 + k) - out[i].origin[k];
+    }
+  return out;
+}
+
+static void build(const std::string& name, uint64_t triangles, int iterations) {
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  prim::generate(prim::Torus::withTriangles(triangles), V, F);
+  double bytes = V.size() * 4. + F.size() * 4., count = F.size() / 3.;
+
+  bvh::Tree tree;
+  double seconds = bench::run(iterations, [&] { buildBvh(V, F, tree); });
+  bench::report((name + " build").c_str(), seconds, bytes, count, "triangles");
+
+  auto queries = rays(1 << 16);
+  std::vector<bvh::Hit> hits(queries.size());
+  size_t found = 0;
+  seconds = bench::run(3, [&] {
+    parallelFor(queries.size(), 256, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) bvh::intersect(tree, V.data(), F.data(), queries[i], hits[i]);
+    });
+  });
+  for (auto& hit : hits) found += hit.triangle != bvh::none;
+  bench::report((name + " closest hit").c_str(), seconds, queries.size() * sizeof(bvh::Ray), queries.size(), "rays");
+  printf("%-40s %zu nodes, %zu of %zu rays hit, %u threads, %zu lanes\n", "", tree.nodes.size(), found, queries.size(),
+    ThreadPool::shared().size(), simd::width);
+}
+
+int main(int argc, char** argv) {
+  bench::Options options(argc, argv);
+  build("torus 1M", 1000000, 3);
+  uint64_t triangles = uint64_t(options.grid) * options.grid;
+  build("torus " + std::to_string(triangles / 1000000) + "M", triangles, 1);
+  return bench::finish(options, "bench_bvh");
+}
@@ -0,0 +1,79 @@
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "bench.hpp"
+#include "mesh_cache.hpp"
+#include "read_off.hpp"
+
+#ifndef DATA_DIR
+#define DATA_DIR "../../data"
+#endif
+
+// What apps/mesh does on a cold start: parse, normalize, derive colors.
+static void process(std::vector<float>& V, std::vector<float>& C) {
+  size_t n = V.size() / 3;
+  double mean[3] = {};
+  for (size_t i = 0; i < n; i++)
+    for (int k = 0; k < 3; k++) mean[k] += V[i * 3 + k];
+  float maxCoeff = -1e30f;
+  for (auto v : V) maxCoeff = std::max(maxCoeff, v);
+  for (size_t i = 0; i < n; i++)
+    for (int k = 0; k < 3; k++) V[i * 3 + k] = (V[i * 3 + k] - float(mean[k] / n)) / maxCoeff;
+
+  float lo[3] = { 1e30f, 1e30f, 1e30f }, hi[3] = { -1e30f, -1e30f, -1e30f };
+  for (size_t i = 0; i < n; i++)
+    for (int k = 0; k < 3; k++) lo[k] = std::min(lo[k], V[i * 3 + k]), hi[k] = std::max(hi[k], V[i * 3 + k]);
+  C.resize(V.size());
+  for (size_t i = 0; i < n; i++)
+    for (int k = 0; k < 3; k++) C[i * 3 + k] = (V[i * 3 + k] - lo[k]) / (hi[k] - lo[k]);
+}
+
+static void compare(const std::string& name, const std::string& path, int iterations) {
+  // in the temp directory, so runs leave nothing behind in data/
+  std::string cachePath = (std::filesystem::temp_directory_path() / std::filesystem::path(path).filename()).string() + ".mesh";
+  std::vector<char> staging; // stands in for the queue write of WGPU::Buffer::write
+  auto upload = [&](const void* data, size_t size) {
+    staging.resize(size);
+    std::memcpy(staging.data(), data, size);
+  };
+
+  std::vector<float> V, C;
+  std::vector<uint32_t> F;
+  double cold = bench::run(iterations, [&] {
+    readOFF(path, V, F);
+    process(V, C);
+    upload(V.data(), V.size() * 4);
+    upload(C.data(), C.size() * 4);
+    upload(F.data(), F.size() * 4);
+  });
+  double bytes = std::filesystem::file_size(path), vertices = V.size() / 3;
+  bench::report((name + " cold OFF").c_str(), cold, bytes, vertices, "vertices");
+
+  meshcache::Source source;
+  meshcache::Source::of(path, source);
+  meshcache::write(cachePath, source, {
+    {.semantic = meshcache::Position, .format = meshcache::Float32, .components = 3, .data = V.data(), .count = V.size() / 3 },
+    {.semantic = meshcache::Color, .format = meshcache::Float32, .components = 3, .data = C.data(), .count = C.size() / 3 },
+    {.semantic = meshcache::Index, .format = meshcache::Uint32, .components = 1, .data = F.data(), .count = F.size() },
+    });
+
+  double warm = bench::run(iterations, [&] {
+    MeshCache cache;
+    if (!cache.open(cachePath) || !cache.isFresh(path)) std::abort();
+    for (uint32_t i = 0; i < cache.header->streamCount; i++)
+      upload(cache.data(cache.streams[i]), cache.streams[i].size);
+  });
+
+  bench::report((name + " warm cache").c_str(), warm, bytes, vertices, "vertices");
+  printf("%-40s %10.2fx\n", (name + " speedup").c_str(), cold / warm);
+  std::remove(cachePath.c_str());
+}
+
+int main(int argc, char** argv) {
+  bench::Options options(argc, argv);
+
+  compare("screwdriver.off", DATA_DIR "/screwdriver.off", 20);
+  compare("synthetic", bench::syntheticOFF(options.grid), 3);
+
+  return bench::finish(options, "bench_mesh_cache");
+}
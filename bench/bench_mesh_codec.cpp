@@ -0,0 +1,111 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "bench.hpp"
+#include "mesh_cache.hpp"
+#include "mesh_codec.hpp"
+#include "read_off.hpp"
+
+#ifndef DATA_DIR
+#define DATA_DIR "../../data"
+#endif
+
+// Area-weighted vertex normals, so the encoded cache carries a normal stream.
+static std::vector<float> normals(const std::vector<float>& V, const std::vector<uint32_t>& F) {
+  std::vector<float> N(V.size(), 0.f);
+  for (size_t f = 0; f < F.size(); f += 3) {
+    const float* a = &V[F[f] * 3], * b = &V[F[f + 1] * 3], * c = &V[F[f + 2] * 3];
+    float u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] }, v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    float n[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+    for (int j = 0; j < 3; j++)
+      for (int k = 0; k < 3; k++) N[F[f + j] * 3 + k] += n[k];
+  }
+  for (size_t i = 0; i < N.size(); i += 3) {
+    float l = std::sqrt(N[i] * N[i] + N[i + 1] * N[i + 1] + N[i + 2] * N[i + 2]);
+    for (int k = 0; k < 3; k++) N[i + k] = l > 0 ? N[i + k] / l : 0.f;
+  }
+  return N;
+}
+
+static void compare(const std::string& name, const std::string& path, int iterations) {
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  if (!readOFF(path, V, F)) std::abort();
+  std::vector<float> N = normals(V, F);
+  size_t n = V.size() / 3;
+
+  IndexStream indices;
+  indices.assign(std::vector<uint32_t>(F), n);
+  meshcache::Source source;
+  meshcache::Source::of(path, source);
+  // in the temp directory, so runs leave nothing behind in data/
+  std::string tempPath = (std::filesystem::temp_directory_path() / std::filesystem::path(path).filename()).string();
+  std::string rawPath = tempPath + ".raw.mesh", encodedPath = tempPath + ".encoded.mesh";
+  auto written = [](bool ok, const std::string& path) {
+    if (ok) return;
+    fprintf(stderr, "cannot write %s\n", path.c_str());
+    std::abort();
+  };
+  written(meshcache::write(rawPath, source, {
+    {.semantic = meshcache::Position, .format = meshcache::Float32, .components = 3, .data = V.data(), .count = n },
+    {.semantic = meshcache::Normal, .format = meshcache::Float32, .components = 3, .data = N.data(), .count = n },
+    {
+      .semantic = meshcache::Index,
+      .format = indices.isWide() ? meshcache::Uint32 : meshcache::Uint16,
+      .components = 1,
+      .data = indices.data(),
+      .count = indices.size()
+    },
+    }), rawPath);
+
+  meshcodec::Encoded encoded;
+  double encode = bench::run(1, [&] { meshcodec::encode(V.data(), n, N.data(), F.data(), F.size(), encoded); });
+  bench::report((name + " encode").c_str(), encode, n * 24 + F.size() * 4, n, "vertices");
+  written(meshcache::write(encodedPath, source, encoded.streams()), encodedPath);
+
+  double off = std::filesystem::file_size(path);
+  double raw = std::filesystem::file_size(rawPath);
+  double compact = std::filesystem::file_size(encodedPath);
+  printf("%-40s %10.1f MB\n", (name + " OFF").c_str(), off / 1e6);
+  printf("%-40s %10.1f MB %6.2fx smaller than OFF\n", (name + " binary cache").c_str(), raw / 1e6, off / raw);
+  printf("%-40s %10.1f MB %6.2fx smaller than binary, %.2fx than OFF\n", (name + " encoded cache").c_str(), compact / 1e6, raw / compact, off / compact);
+  printf("%-40s %10.2f bytes/index\n", (name + " encoded indices").c_str(), double(encoded.indices.size()) / F.size());
+
+  // output of every path is the same set of GPU-ready buffers
+  double gpuBytes = n * 24 + indices.bytes();
+  std::vector<char> staging;
+  auto upload = [&](const void* data, size_t size) {
+    staging.resize(size);
+    std::memcpy(staging.data(), data, size);
+  };
+
+  double parse = bench::run(iterations > 3 ? 3 : 1, [&] { readOFF(path, V, F); });
+  bench::report((name + " readOFF").c_str(), parse, gpuBytes, n, "vertices");
+  double copy = bench::run(iterations, [&] {
+    MeshCache cache;
+    if (!cache.open(rawPath)) std::abort();
+    for (uint32_t i = 0; i < cache.header->streamCount; i++)
+      upload(cache.data(cache.streams[i]), cache.streams[i].size);
+  });
+  bench::report((name + " binary cache copy").c_str(), copy, gpuBytes, n, "vertices");
+  meshcodec::Decoded decoded;
+  double decode = bench::run(iterations, [&] {
+    MeshCache cache;
+    if (!cache.open(encodedPath) || !meshcodec::decode(cache, decoded)) std::abort();
+  });
+  bench::report((name + " encoded cache decode").c_str(), decode, gpuBytes, n, "vertices");
+  std::remove(rawPath.c_str());
+  std::remove(encodedPath.c_str());
+}
+
+int main(int argc, char** argv) {
+  bench::Options options(argc, argv);
+
+  printf("MB/s is of decoded, GPU-ready output\n");
+  compare("screwdriver.off", DATA_DIR "/screwdriver.off", 20);
+  compare("synthetic", bench::syntheticOFF(options.grid), 3);
+
+  return bench::finish(options, "bench_mesh_codec");
+}
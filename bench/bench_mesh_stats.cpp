@@ -0,0 +1,48 @@
+#include <cstdio>
+#include <string>
+#include <Eigen/Core>
+#include "bench.hpp"
+#include "generate.hpp"
+#include "mesh_stats.hpp"
+#include "normals.hpp"
+
+using RowMajor = Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+// The passes loadMesh used to make: the mean and the largest centered
+// coordinate to normalize, then the box for colors, then the normal ranges.
+static float eigenPasses(std::vector<float>& V, std::vector<float>& N) {
+  Eigen::Index n = V.size() / 3;
+  Eigen::Map<RowMajor> mat(V.data(), n, 3), normals(N.data(), n, 3);
+  Eigen::RowVector3f mean = mat.colwise().mean();
+  float scale = (mat.rowwise() - mean).maxCoeff();
+  Eigen::RowVector3f min = mat.colwise().minCoeff(), max = mat.colwise().maxCoeff();
+  Eigen::RowVector3f normalMin = normals.colwise().minCoeff(), normalMax = normals.colwise().maxCoeff();
+  return scale + min.sum() + max.sum() + normalMin.sum() + normalMax.sum();
+}
+
+static void compare(const std::string& name, uint64_t triangles, int iterations) {
+  std::vector<float> V, N;
+  std::vector<uint32_t> F;
+  prim::generate(prim::Torus::withTriangles(triangles), V, F);
+  computeNormals(V, F, N);
+  double bytes = V.size() * 4. + N.size() * 4., count = V.size() / 3.;
+
+  volatile float sink = 0;
+  double seconds = bench::run(iterations, [&] { sink = eigenPasses(V, N); });
+  bench::report((name + " eigen passes").c_str(), seconds, bytes, count, "vertices");
+  MeshStats stats;
+  seconds = bench::run(iterations, [&] { stats = computeMeshStats(V, { { N.data(), 3 } }); });
+  bench::report((name + " computeMeshStats").c_str(), seconds, bytes, count, "vertices");
+  float diagonal = 0;
+  for (int k = 0; k < 3; k++) diagonal += std::pow(stats.positions.max[k] - stats.positions.min[k], 2.f);
+  printf("%-40s sphere radius %.4f of half the box diagonal, %u threads, %zu lanes\n", "",
+    stats.sphere.radius / (std::sqrt(diagonal) / 2), ThreadPool::shared().size(), simd::width);
+}
+
+int main(int argc, char** argv) {
+  bench::Options options(argc, argv);
+  compare("torus 1M", 1000000, 5);
+  uint64_t triangles = uint64_t(options.grid) * options.grid;
+  compare("torus " + std::to_string(triangles / 1000000) + "M", triangles, 3);
+  return bench::finish(options, "bench_mesh_stats");
+}
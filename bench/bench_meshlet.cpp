@@ -0,0 +1,33 @@
+#include <cstdio>
+#include <string>
+#include "bench.hpp"
+#include "generate.hpp"
+#include "meshlet.hpp"
+#include "vertex_cache.hpp"
+
+template <typename Surface>
+static void build(const std::string& name, const Surface& surface, int iterations) {
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  prim::generate(surface, V, F);
+  optimizeVertexCache(F, V.size() / 3);
+
+  meshlet::Meshlets meshlets;
+  double seconds = bench::run(iterations, [&] { buildMeshlets(V, F, meshlets); });
+  bench::report((name + " build").c_str(), seconds, F.size() * 4., F.size() / 3., "triangles");
+
+  auto stats = meshlets.statistics(V.size() / 3);
+  size_t cones = 0;
+  for (auto& b : meshlets.bounds) cones += b.cutoff < 1;
+  printf("%-40s %zu meshlets, fill %.3f vertices %.3f triangles, duplication %.3f, %.1f MB, %.1f%% cones\n", "",
+    stats.meshlets, stats.vertexFill, stats.triangleFill, stats.duplication, stats.bytes / 1e6,
+    stats.meshlets ? 100. * cones / stats.meshlets : 0.);
+}
+
+int main(int argc, char** argv) {
+  bench::Options options(argc, argv);
+  uint64_t triangles = uint64_t(options.grid) * options.grid;
+  build("sphere", prim::Sphere::withTriangles(triangles), 3);
+  build("torus", prim::Torus::withTriangles(triangles), 3);
+  return bench::finish(options, "bench_meshlet");
+}
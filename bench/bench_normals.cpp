@@ -0,0 +1,41 @@
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include "bench.hpp"
+#include "generate.hpp"
+#include "hash.hpp"
+#include "normals.hpp"
+
+static void compute(const std::string& name, uint64_t triangles, int iterations) {
+  std::vector<float> V, N;
+  std::vector<uint32_t> F;
+  prim::generate(prim::Torus::withTriangles(triangles), V, F);
+  double bytes = V.size() * 4. + F.size() * 4., count = F.size() / 3.;
+
+  double seconds = bench::run(iterations, [&] { computeNormalsSerial(V, F, N, normals::Area); });
+  bench::report((name + " serial area").c_str(), seconds, bytes, count, "triangles");
+  seconds = bench::run(iterations, [&] { computeNormals(V, F, N, normals::Area); });
+  bench::report((name + " area").c_str(), seconds, bytes, count, "triangles");
+  seconds = bench::run(iterations, [&] { computeNormalsSerial(V, F, N, normals::Angle); });
+  bench::report((name + " serial angle").c_str(), seconds, bytes, count, "triangles");
+  seconds = bench::run(iterations, [&] { computeNormals(V, F, N, normals::Angle); });
+  bench::report((name + " angle").c_str(), seconds, bytes, count, "triangles");
+
+  // vertices numbered at random, so that every chunk shares most blocks
+  std::vector<uint32_t> remap(V.size() / 3);
+  for (uint32_t i = 0; i < remap.size(); i++) remap[i] = i;
+  for (size_t i = remap.size(); i > 1; i--) std::swap(remap[i - 1], remap[hashMix(i) % i]);
+  for (uint32_t& v : F) v = remap[v];
+  seconds = bench::run(iterations, [&] { computeNormalsSerial(V, F, N, normals::Area); });
+  bench::report((name + " shuffled serial area").c_str(), seconds, bytes, count, "triangles");
+  seconds = bench::run(iterations, [&] { computeNormals(V, F, N, normals::Area); });
+  bench::report((name + " shuffled area").c_str(), seconds, bytes, count, "triangles");
+  printf("%-40s %zu vertices, %u threads\n", "", V.size() / 3, ThreadPool::shared().size());
+}
+
+int main(int argc, char** argv) {
+  bench::Options options(argc, argv);
+  compute("torus 1M", 1000000, 5);
+  compute("torus 50M", 50000000, 1);
+  return bench::finish(options, "bench_normals");
+}
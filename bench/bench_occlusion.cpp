@@ -0,0 +1,52 @@
+#include <cstdio>
+#include <string>
+#include <thread>
+#include "bench.hpp"
+#include "generate.hpp"
+#include "normals.hpp"
+#include "occlusion.hpp"
+
+// Bakes the occlusion of a terrain on 1, 2, 4, ... threads up to the
+// machine's, then reads the bake back from its cache.
+static void bake(const std::string& name, uint64_t triangles, uint32_t rays) {
+  std::vector<float> V, N;
+  std::vector<uint32_t> F;
+  prim::generate(prim::Terrain::withTriangles(triangles), V, F);
+  computeNormals(V, F, N);
+  bvh::Tree tree;
+  buildBvh(V, F, tree);
+  size_t n = V.size() / 3;
+  double count = double(n) * rays;
+
+  std::vector<float> AO;
+  double single = 0;
+  unsigned hardware = std::max(std::thread::hardware_concurrency(), 1u);
+  for (unsigned threads = 1;; threads = std::min(threads * 2, hardware)) {
+    ThreadPool pool(threads);
+    double seconds = bench::run(1, [&] { bakeOcclusion(V, N, F, tree, AO, rays, .25f, pool); });
+    if (threads == 1) single = seconds;
+    bench::report((name + " bake x" + std::to_string(threads)).c_str(), seconds, n * sizeof(float), count, "rays");
+    printf("%-40s %.2fx over one thread\n", "", single / seconds);
+    if (threads == hardware) break;
+  }
+  double sum = 0;
+  for (float ao : AO) sum += ao;
+  printf("%-40s %zu vertices, %u rays each, mean %.3f, %zu lanes\n", "", n, rays, sum / n, simd::width);
+
+  std::string path = "bench_occlusion.ao";
+  uint64_t key = 0;
+  double seconds = bench::run(3, [&] { key = occlusion::key(V, N, F, rays, .25f); });
+  bench::report((name + " key").c_str(), seconds, (V.size() + N.size() + F.size()) * 4., n, "vertices");
+  occlusion::write(path, key, AO);
+  std::vector<float> cached;
+  seconds = bench::run(3, [&] { occlusion::read(path, key, cached); });
+  bench::report((name + " cache read").c_str(), seconds, n * sizeof(float), n, "vertices");
+  std::remove(path.c_str());
+}
+
+int main(int argc, char** argv) {
+  bench::Options options(argc, argv);
+  bake("terrain 250K", 250000, 32);
+  if (options.large) bake("terrain 2M", 2000000, 32);
+  return bench::finish(options, "bench_occlusion");
+}
@@ -0,0 +1,48 @@
+#include <cstdlib>
+#include <string>
+#include "bench.hpp"
+#include "generate.hpp"
+#include "overdraw.hpp"
+#include "read_off.hpp"
+
+#ifndef DATA_DIR
+#define DATA_DIR "../../data"
+#endif
+
+static void compare(const std::string& name, const std::vector<float>& V, std::vector<uint32_t> F, int iterations) {
+  size_t n = V.size() / 3;
+  optimizeVertexCache(F, n);
+
+  overdraw::Statistics before;
+  double estimate = bench::run(iterations, [&] { before = overdraw::analyze(V, F); });
+  bench::report((name + " estimate").c_str(), estimate, F.size() * 4., F.size() / 3., "triangles");
+
+  for (float threshold : { 1.f, 1.05f, 1.2f }) {
+    std::vector<uint32_t> G;
+    double seconds = bench::run(iterations, [&] {
+      G = F;
+      optimizeOverdraw(G, V, threshold);
+    });
+    char label[64];
+    snprintf(label, sizeof(label), " optimize %.2f", threshold);
+    bench::report((name + label).c_str(), seconds, F.size() * 4., F.size() / 3., "triangles");
+    auto after = overdraw::analyze(V, G);
+    printf("%-40s overdraw %.3f -> %.3f, ACMR %.3f -> %.3f\n", "", before.overdraw, after.overdraw,
+      vcache::analyze(F, n).acmr, vcache::analyze(G, n).acmr);
+  }
+}
+
+int main(int argc, char** argv) {
+  bench::Options options(argc, argv);
+
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  if (!readOFF(DATA_DIR "/screwdriver.off", V, F)) std::abort();
+  compare("screwdriver.off", V, F, 20);
+
+  // a torus overlaps itself from most directions
+  prim::generate(prim::Torus::withTriangles(uint64_t(options.grid) * options.grid / 10), V, F);
+  compare("torus", V, F, 1);
+
+  return bench::finish(options, "bench_overdraw");
+}
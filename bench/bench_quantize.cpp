@@ -0,0 +1,48 @@
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include "bench.hpp"
+#include "generate.hpp"
+#include "normals.hpp"
+#include "quantize.hpp"
+#include "read_off.hpp"
+
+#ifndef DATA_DIR
+#define DATA_DIR "../../data"
+#endif
+
+// Packs positions, normals and colors, colored by position as apps/mesh
+// does, and compares the bytes fetched per vertex against Float32 x 3.
+static void pack(const std::string& name, const std::vector<float>& V, const std::vector<uint32_t>& F, int iterations) {
+  std::vector<float> N;
+  computeNormals(V, F, N);
+  size_t n = V.size() / 3;
+  auto bounds = meshcodec::bounds(V.data(), n);
+  std::vector<float> C(n * 3);
+  for (size_t i = 0; i < C.size(); i++)
+    C[i] = (V[i] - bounds.v[i % 3]) / std::max(bounds.v[i % 3 + 3] - bounds.v[i % 3], 1e-6f);
+
+  quantize::Packed packed;
+  double floats = n * 36.;
+  double seconds = bench::run(iterations, [&] { quantizeVertices(V, bounds, N, C, 3, packed); });
+  bench::report((name + " quantize").c_str(), seconds, floats, n, "vertices");
+
+  float extent = 0;
+  for (int k = 0; k < 3; k++) extent = std::max(extent, bounds.v[k + 3] - bounds.v[k]);
+  printf("%-40s %zu -> %zu bytes per vertex, %.2fx less to fetch\n", "", size_t(36), packed.stride(), 36. / packed.stride());
+  printf("%-40s position %.3g (%.3g of the box), normal %.4f degrees, color %.3f / 255\n", "",
+    packed.error.position, packed.error.position / extent, packed.error.normal * 180 / M_PI, packed.error.color * 255);
+}
+
+int main(int argc, char** argv) {
+  bench::Options options(argc, argv);
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  if (!readOFF(DATA_DIR "/screwdriver.off", V, F)) std::abort();
+  pack("screwdriver.off", V, F, 20);
+
+  uint64_t triangles = uint64_t(options.grid) * options.grid;
+  prim::generate(prim::Terrain::withTriangles(triangles), V, F);
+  pack("terrain " + std::to_string(triangles / 1000000) + "M", V, F, 3);
+  return bench::finish(options, "bench_quantize");
+}
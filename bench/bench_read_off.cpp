@@ -0,0 +1,70 @@
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include "bench.hpp"
+#include "read_off.hpp"
+#include "read_off_legacy.hpp"
+
+#ifndef DATA_DIR
+#define DATA_DIR "../../data"
+#endif
+
+// Streams the file in 64k element chunks; its peak RSS stays bounded by the
+// chunk size whatever the file size.
+static void stream(const std::string& name, const std::string& path) {
+  double bytes = std::filesystem::file_size(path);
+  double vertices = 0;
+  double seconds = bench::run(1, [&] {
+    streamOFF<float, uint32_t>(path, 1 << 16,
+      [&](const std::vector<float>& V, int64_t) { vertices += V.size() / 3; },
+      [&](const std::vector<uint32_t>&, int64_t) {});
+  });
+  bench::report((name + " streamOFF").c_str(), seconds, bytes, vertices, "vertices");
+}
+
+// The legacy reader is skipped on multi-GB inputs, where it takes minutes.
+static void compare(const std::string& name, const std::string& path, int iterations, bool legacy = true) {
+  double bytes = std::filesystem::file_size(path);
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+
+  double mapped = bench::run(iterations, [&] {
+    std::vector<float>().swap(V);
+    std::vector<uint32_t>().swap(F);
+    readOFF(path, V, F);
+  });
+  double vertices = V.size() / 3;
+  bench::report((name + " readOFF").c_str(), mapped, bytes, vertices, "vertices");
+
+  double parallel = bench::run(iterations, [&] {
+    std::vector<float>().swap(V);
+    std::vector<uint32_t>().swap(F);
+    readOFFParallel(path, V, F);
+  });
+  std::string label = name + " readOFFParallel x" + std::to_string(ThreadPool::shared().size());
+  bench::report(label.c_str(), parallel, bytes, vertices, "vertices");
+
+  if (!legacy) return;
+  double baseline = bench::run(iterations, [&] {
+    std::vector<float>().swap(V);
+    std::vector<uint32_t>().swap(F);
+    readOFFLegacy(path, V, F);
+  });
+  bench::report((name + " legacy").c_str(), baseline, bytes, vertices, "vertices");
+  printf("%-40s %10.2fx %10.2fx\n", (name + " speedup").c_str(), baseline / mapped, baseline / parallel);
+}
+
+// small: screwdriver.off, medium: 1000^2 grid (~75 MB), large: the [grid]
+// argument, ~0.8 GB by default and ~3 GB with --large.
+int main(int argc, char** argv) {
+  bench::Options options(argc, argv);
+  std::string medium = bench::syntheticOFF(1000);
+  std::string large = bench::syntheticOFF(options.grid);
+
+  compare("small", DATA_DIR "/screwdriver.off", 20);
+  compare("medium", medium, 5);
+  stream("large", large);
+  compare("large", large, options.large ? 1 : 3, !options.large);
+
+  return bench::finish(options, "bench_read_off");
+}
@@ -0,0 +1,29 @@
+#include <cstdio>
+#include <string>
+#include "bench.hpp"
+#include "generate.hpp"
+#include "simplify.hpp"
+
+template <typename Surface>
+static void chain(const std::string& name, const Surface& surface) {
+  std::vector<float> V;
+  std::vector<uint32_t> F, G;
+  prim::generate(surface, V, F);
+
+  float error = 0;
+  double seconds = bench::run(1, [&] { error = simplifyMesh(V, F, G, F.size() / 3 / 2); });
+  bench::report((name + " simplify 50%").c_str(), seconds, F.size() * 4., F.size() / 3., "triangles");
+  printf("%-40s %zu triangles, error estimate %.3g\n", "", G.size() / 3, error);
+
+  std::vector<simplify::Lod<uint32_t>> lods;
+  seconds = bench::run(1, [&] { lods = buildLods(V, F); });
+  bench::report((name + " lod chain").c_str(), seconds, F.size() * 4., F.size() / 3., "triangles");
+  for (size_t i = 1; i < lods.size(); i++)
+    printf("%-40s lod %zu: %zu triangles, error %.3g\n", "", i, lods[i].indices.size() / 3, lods[i].error);
+}
+
+int main(int argc, char** argv) {
+  bench::Options options(argc, argv);
+  chain("torus", prim::Torus::withTriangles(uint64_t(options.grid) * options.grid));
+  return bench::finish(options, "bench_simplify");
+}
@@ -0,0 +1,36 @@
+#include <cstdio>
+#include <string>
+#include "bench.hpp"
+#include "generate.hpp"
+#include "tangents.hpp"
+
+static void compute(const std::string& name, uint64_t triangles, int iterations) {
+  auto torus = prim::Torus::withTriangles(triangles);
+  std::vector<float> V, N, T, UV;
+  std::vector<uint32_t> F, G, splits;
+  std::vector<int8_t> packed;
+  prim::generate(torus, V, F);
+  UV.resize(V.size() / 3 * 2);
+  for (size_t i = 0; i < V.size() / 3; i++) {
+    UV[i * 2] = float(i % torus.lattice.nx) / torus.lattice.nx;
+    UV[i * 2 + 1] = float(i / torus.lattice.nx) / torus.lattice.ny;
+  }
+  computeNormals(V, F, N);
+  double bytes = V.size() * 4. + N.size() * 4. + UV.size() * 4. + F.size() * 4., count = F.size() / 3.;
+
+  double seconds = bench::run(iterations, [&] {
+    G = F;
+    computeTangents(V, N, UV, G, T, splits);
+  });
+  bench::report((name + " tangents").c_str(), seconds, bytes, count, "triangles");
+  seconds = bench::run(iterations, [&] { tangent::pack(T, packed); });
+  bench::report((name + " pack Snorm8x4").c_str(), seconds, T.size() * 4., T.size() / 4., "vertices");
+  printf("%-40s %zu vertices, %zu split, %u threads\n", "", V.size() / 3, splits.size(), ThreadPool::shared().size());
+}
+
+int main(int argc, char** argv) {
+  bench::Options options(argc, argv);
+  compute("torus 1M", 1000000, 5);
+  compute("torus " + std::to_string(uint64_t(options.grid) * options.grid / 1000000) + "M", uint64_t(options.grid) * options.grid, 1);
+  return bench::finish(options, "bench_tangents");
+}
@@ -0,0 +1,66 @@
+#include <cstdlib>
+#include <string>
+#include "bench.hpp"
+#include "generate.hpp"
+#include "read_off.hpp"
+#include "vertex_cache.hpp"
+#include "vertex_fetch.hpp"
+
+#ifndef DATA_DIR
+#define DATA_DIR "../../data"
+#endif
+
+static void compare(const std::string& name, std::vector<float> V, const std::vector<uint32_t>& F, int iterations) {
+  size_t n = V.size() / 3;
+  std::vector<uint32_t> G;
+  double seconds = bench::run(iterations, [&] {
+    G = F;
+    optimizeVertexCache(G, n);
+  });
+  bench::report((name + " tipsify").c_str(), seconds, F.size() * 4., F.size() / 3., "triangles");
+  for (unsigned cacheSize : { 16u, 32u }) {
+    auto before = vcache::analyze(F, n, cacheSize), after = vcache::analyze(G, n, cacheSize);
+    printf("%-40s ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", (name + " cache " + std::to_string(cacheSize)).c_str(),
+      before.acmr, after.acmr, before.atvr, after.atvr);
+  }
+
+  std::vector<uint32_t> R;
+  std::vector<float> W;
+  bool renumbered = false;
+  double fetch = bench::run(iterations, [&] {
+    R = G, W = V;
+    renumbered = optimizeVertexFetch(R, W);
+  });
+  bench::report((name + " fetch order").c_str(), fetch, V.size() * 4. + F.size() * 4., n, "vertices");
+  // input -> cache order -> fetch order, which keeps the cache order when
+  // renumbering would not lower the overfetch
+  auto before = vfetch::analyze(F, n), cached = vfetch::analyze(G, n), after = vfetch::analyze(R, n);
+  printf("%-40s fetch distance %.1f -> %.1f -> %.1f vertices, overfetch %.2f -> %.2f -> %.2f%s\n", "",
+    before.distance, cached.distance, after.distance, before.overfetch, cached.overfetch, after.overfetch,
+    renumbered ? "" : ", cache order kept");
+}
+
+// Triangles in random order, like the output of many scanners.
+static void shuffle(std::vector<uint32_t>& F) {
+  for (size_t f = F.size() / 3 - 1; f > 0; f--) {
+    size_t g = hashMix(f) % (f + 1);
+    std::swap_ranges(&F[f * 3], &F[f * 3 + 3], &F[g * 3]);
+  }
+}
+
+int main(int argc, char** argv) {
+  bench::Options options(argc, argv);
+
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  if (!readOFF(DATA_DIR "/screwdriver.off", V, F)) std::abort();
+  compare("screwdriver.off", V, F, 50);
+
+  auto sphere = prim::Sphere::withTriangles(uint64_t(options.grid) * options.grid);
+  prim::generate(sphere, V, F);
+  compare("sphere", V, F, 1);
+  shuffle(F);
+  compare("shuffled sphere", V, F, 1);
+
+  return bench::finish(options, "bench_vertex_cache");
+}
@@ -0,0 +1,42 @@
+#include <cstdlib>
+#include "bench.hpp"
+#include "generate.hpp"
+#include "weld.hpp"
+
+// Triangle soup: every triangle with its own three corners, as STL stores it.
+template <typename Surface>
+static void soup(const Surface& surface, std::vector<float>& V, std::vector<uint32_t>& F) {
+  std::vector<float> P;
+  std::vector<uint32_t> I;
+  prim::generate(surface, P, I);
+  V.resize(I.size() * 3);
+  F.resize(I.size());
+  parallelFor(I.size(), 1 << 16, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      std::copy_n(&P[size_t(I[i]) * 3], 3, &V[i * 3]);
+      F[i] = uint32_t(i);
+    }
+  });
+}
+
+int main(int argc, char** argv) {
+  bench::Options options(argc, argv);
+  uint64_t triangles = uint64_t(options.grid) * options.grid;
+
+  std::vector<float> V, W;
+  std::vector<uint32_t> F, G;
+  soup(prim::Sphere::withTriangles(triangles), V, F);
+  size_t n = V.size() / 3;
+  printf("%zu corners, %u threads\n", n, ThreadPool::shared().size());
+
+  for (float epsilon : { 0.f, 1e-6f }) {
+    weld::Stats stats;
+    W = V, G = F;
+    double seconds = bench::run(1, [&] { stats = weldVertices(W, G, epsilon); });
+    std::string name = epsilon > 0 ? "weld sphere soup 1e-6" : "weld sphere soup exact";
+    bench::report(name.c_str(), seconds, n * 12, n, "vertices");
+    printf("%-40s %10zu -> %zu vertices, %.1f%% removed\n", "", stats.vertices, stats.welded, (1 - stats.ratio()) * 100);
+  }
+
+  return bench::finish(options, "bench_weld");
+}
@@ -0,0 +1,52 @@
+#include <cstdlib>
+#include <string>
+#include "bench.hpp"
+#include "read_off.hpp"
+#include "write_off.hpp"
+
+#ifndef DATA_DIR
+#define DATA_DIR "../../data"
+#endif
+
+// Baseline: one fprintf per record.
+static void writeOFFPrintf(const std::string& path, const std::vector<float>& V, const std::vector<uint32_t>& F) {
+  FILE* file = fopen(path.c_str(), "w");
+  fprintf(file, "OFF\n%zu %zu 0\n", V.size() / 3, F.size() / 3);
+  for (size_t i = 0; i < V.size(); i += 3) fprintf(file, "%.9g %.9g %.9g\n", V[i], V[i + 1], V[i + 2]);
+  for (size_t i = 0; i < F.size(); i += 3) fprintf(file, "3 %u %u %u\n", F[i], F[i + 1], F[i + 2]);
+  fclose(file);
+}
+
+static void compare(const std::string& name, const std::string& path, int iterations) {
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  readOFF(path, V, F);
+  double vertices = V.size() / 3;
+  std::string out = "bench_write.off";
+
+  double baseline = bench::run(iterations, [&] { writeOFFPrintf(out, V, F); });
+  bench::report((name + " fprintf").c_str(), baseline, std::filesystem::file_size(out), vertices, "vertices");
+
+  ThreadPool serial(1);
+  double text = bench::run(iterations, [&] { writeOFF(out, V, F, nullptr, false, 1 << 16, serial); });
+  bench::report((name + " writeOFF serial").c_str(), text, std::filesystem::file_size(out), vertices, "vertices");
+
+  double parallel = bench::run(iterations, [&] { writeOFF(out, V, F); });
+  std::string label = name + " writeOFF x" + std::to_string(ThreadPool::shared().size());
+  bench::report(label.c_str(), parallel, std::filesystem::file_size(out), vertices, "vertices");
+
+  double binary = bench::run(iterations, [&] { writeOFF(out, V, F, nullptr, true); });
+  bench::report((name + " writeOFF binary").c_str(), binary, std::filesystem::file_size(out), vertices, "vertices");
+
+  printf("%-40s %10.2fx %10.2fx\n", (name + " speedup").c_str(), baseline / text, baseline / parallel);
+  std::filesystem::remove(out);
+}
+
+int main(int argc, char** argv) {
+  bench::Options options(argc, argv);
+
+  compare("screwdriver.off", DATA_DIR "/screwdriver.off", 20);
+  compare("synthetic", bench::syntheticOFF(options.grid), 3);
+
+  return bench::finish(options, "bench_write_off");
+}
@@ -0,0 +1,77 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "generate.hpp"
+#include "index_stream.hpp"
+#include "mesh_cache.hpp"
+
+// generate <sphere|torus|grid|terrain> <triangles> <out.off|out.mesh> [--binary] [--seed n]
+//
+// Writes a parametric mesh of about the requested triangle count. OFF output
+// is streamed, so it can be far larger than memory; .mesh output is a cache
+// with positions and indices, built in memory.
+
+template <typename Surface>
+static bool emit(const Surface& surface, const std::string& path, bool binary) {
+  if (!path.ends_with(".mesh")) return prim::writeOFF(path, surface, binary);
+
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  prim::generate(surface, V, F);
+  uint64_t n = surface.vertexCount();
+  IndexStream indices;
+  indices.assign(std::move(F), n);
+  return meshcache::write(path, {}, {
+    {.semantic = meshcache::Position, .format = meshcache::Float32, .components = 3, .data = V.data(), .count = n },
+    {
+      .semantic = meshcache::Index,
+      .format = indices.isWide() ? meshcache::Uint32 : meshcache::Uint16,
+      .components = 1,
+      .data = indices.data(),
+      .count = indices.size()
+    },
+    });
+}
+
+template <typename Surface>
+static int run(const Surface& surface, const std::string& path, bool binary) {
+  if (surface.vertexCount() > UINT32_MAX) {
+    printf("generate: %llu vertices do not fit 32-bit indices\n", (unsigned long long)surface.vertexCount());
+    return EXIT_FAILURE;
+  }
+  auto t0 = std::chrono::steady_clock::now();
+  if (!emit(surface, path, binary)) return EXIT_FAILURE;
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  printf("%s: %llu vertices, %llu triangles in %.2f s (%.1f M triangles/s, %u threads)\n", path.c_str(),
+    (unsigned long long)surface.vertexCount(), (unsigned long long)surface.triangleCount(), seconds,
+    surface.triangleCount() / seconds / 1e6, ThreadPool::shared().size());
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 4) {
+    printf("usage: %s <sphere|torus|grid|terrain> <triangles> <out.off|out.mesh> [--binary] [--seed n]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  std::string shape = argv[1], path = argv[3];
+  uint64_t triangles = std::strtoull(argv[2], nullptr, 10);
+  bool binary = false;
+  uint32_t seed = 1;
+  for (int i = 4; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--binary") binary = true;
+    else if (arg == "--seed" && i + 1 < argc) seed = uint32_t(std::atoi(argv[++i]));
+  }
+
+  if (shape == "sphere") return run(prim::Sphere::withTriangles(triangles), path, binary);
+  if (shape == "torus") return run(prim::Torus::withTriangles(triangles), path, binary);
+  if (shape == "grid") return run(prim::Grid::withTriangles(triangles), path, binary);
+  if (shape == "terrain") {
+    auto terrain = prim::Terrain::withTriangles(triangles);
+    terrain.seed = seed;
+    return run(terrain, path, binary);
+  }
+  printf("generate: unknown shape %s\n", shape.c_str());
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <utility>
+#include "timeline.hpp"
+
+// Value produced on a worker thread, started at construction so loading and
+// preprocessing overlap whatever the caller does next (window and device
+// creation). get() waits for the value and hands it over once.
+template <typename T>
+class Asset {
+public:
+  template <typename F>
+  Asset(const char* name, F&& load) {
+    future = std::async(std::launch::async, [name, load = std::forward<F>(load)]() mutable {
+      Timeline::Scope scope(name);
+      return load();
+    });
+  }
+
+  bool ready() const {
+    return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  }
+
+  // Rethrows any exception thrown by the loader.
+  T get() {
+    Timeline::Scope scope("wait asset");
+    return future.get();
+  }
+
+private:
+  std::future<T> future;
+};
@@ -0,0 +1,612 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "parallel.hpp"
+#include "simd.hpp"
+
+// Bounding volume hierarchy over the triangles of a mesh, for ray queries on
+// the CPU such as picking the surface under the cursor.
+//
+// The tree is built top-down as a binary tree, each node split where the
+// surface area heuristic is lowest over `bins` buckets of triangle centroids
+// per axis (Wald 2007), and then collapsed into nodes of four children whose
+// boxes a ray is tested against together, simd::width at a time. Nodes with
+// many triangles are binned and partitioned in parallel over fixed chunks;
+// below that, subtrees are built as independent tasks. Neither depends on
+// the thread count, so the tree is the same for any pool.
+namespace bvh {
+  constexpr size_t bins = 16;
+  constexpr size_t arity = 4;
+  // leaves take up to maxLeaf triangles, and always take minLeaf or fewer
+  constexpr uint32_t minLeaf = 4, maxLeaf = 8;
+  // nodes with more triangles are split in parallel, in chunks of this size
+  constexpr size_t parallelTriangles = 1 << 16;
+  // cost of visiting a node, relative to testing a triangle
+  constexpr float traversalCost = 1;
+  constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+  constexpr float inf = std::numeric_limits<float>::infinity();
+
+  // Four children with their boxes, one array per bound and axis for the
+  // SIMD slab test. A child with `count` triangles is a leaf of
+  // Tree::triangles[first, first + count); with count 0 it is the node
+  // `first`, or an empty slot when first is 0 too, as the root is nobody's
+  // child.
+  struct Node {
+    float min[3][arity];
+    float max[3][arity];
+    uint32_t first[arity];
+    uint32_t count[arity];
+  };
+
+  struct Tree {
+    std::vector<Node> nodes;         // the root first
+    std::vector<uint32_t> triangles; // triangle numbers, in leaf order
+  };
+
+  struct Ray {
+    float origin[3];
+    float direction[3];
+    float tmax = inf;
+  };
+
+  // The closest triangle along a ray, at `distance` in units of the ray
+  // direction, and the barycentric weights u and v of its second and third
+  // vertex at the hit point.
+  struct Hit {
+    uint32_t triangle = none;
+    float distance = inf;
+    float u = 0, v = 0;
+  };
+
+  // xyz bounds with a fourth lane that only pads them to a SIMD register.
+  struct Box {
+    alignas(16) float min[4] = { inf, inf, inf, inf };
+    alignas(16) float max[4] = { -inf, -inf, -inf, -inf };
+
+    // lo and hi have four floats
+    void grow(const float* lo, const float* hi) {
+      if constexpr (simd::width == 4) {
+        simd::store(min, simd::min(simd::load(min), simd::load(lo)));
+        simd::store(max, simd::max(simd::load(max), simd::load(hi)));
+      }
+      else
+        for (int k = 0; k < 3; k++) min[k] = std::min(min[k], lo[k]), max[k] = std::max(max[k], hi[k]);
+    }
+    void grow(const Box& b) { grow(b.min, b.max); }
+    float area() const {
+      float d[3] = { max[0] - min[0], max[1] - min[1], max[2] - min[2] };
+      return d[0] < 0 ? 0 : 2 * (d[0] * d[1] + d[1] * d[2] + d[2] * d[0]);
+    }
+  };
+
+  // A node of the binary tree; with count 0 its children are first and
+  // first + 1. While it waits to be split, first and count are its range of
+  // the triangles being partitioned.
+  struct Binary {
+    Box box;
+    uint32_t first, count;
+  };
+
+  // A node waiting to be split, with the box of its triangle centroids.
+  struct Task {
+    uint32_t node;
+    Box centroids;
+  };
+
+  struct Bin {
+    Box box;
+    uint32_t count = 0;
+  };
+  using Bins = std::array<std::array<Bin, bins>, 3>;
+
+  // A triangle while the tree is built: its box, with the triangle number
+  // in the fourth lane of the minimum, moved around as the ranges of the
+  // nodes are partitioned.
+  struct alignas(16) Ref {
+    float min[4];
+    float max[4];
+
+    uint32_t triangle() const {
+      uint32_t t;
+      std::memcpy(&t, &min[3], sizeof(t));
+      return t;
+    }
+    void centroid(float* c) const {
+      for (int k = 0; k < 3; k++) c[k] = (min[k] + max[k]) / 2;
+      c[3] = 0;
+    }
+  };
+
+  // Bucket of a centroid along every axis of the box around the centroids.
+  struct Binning {
+    float min[3], scale[3];
+
+    explicit Binning(const Box& centroids) {
+      for (int k = 0; k < 3; k++) {
+        float extent = centroids.max[k] - centroids.min[k];
+        min[k] = centroids.min[k], scale[k] = extent > 0 ? bins / extent : 0;
+      }
+    }
+    int operator()(const float* c, int k) const {
+      return std::min(int(bins) - 1, std::max(0, int((c[k] - min[k]) * scale[k])));
+    }
+  };
+
+  inline void bin(const Ref* refs, size_t begin, size_t end, const Binning& binning, Bins& out) {
+    for (size_t i = begin; i < end; i++) {
+      float c[4];
+      refs[i].centroid(c);
+      for (int k = 0; k < 3; k++) {
+        Bin& b = out[k][binning(c, k)];
+        b.box.grow(refs[i].min, refs[i].max), b.count++;
+      }
+    }
+  }
+
+  struct Split {
+    int axis = -1;
+    size_t bin = 0; // first bin on the right
+    float cost = inf;
+    Box left, right;
+  };
+
+  // Cheapest split between bins of a node with surface `area`, with the
+  // boxes of both sides; axis -1 when all centroids share a bin.
+  inline Split choose(const Bins& b, float area) {
+    Split best;
+    float scale = 1 / std::max(area, FLT_MIN);
+    for (int k = 0; k < 3; k++) {
+      // area times count of the bins from i on
+      float right[bins];
+      Box box;
+      uint32_t count = 0, total = 0;
+      for (size_t i = bins; i-- > 1;) {
+        box.grow(b[k][i].box), count += b[k][i].count;
+        right[i] = box.area() * count;
+      }
+      total = count + b[k][0].count;
+      box = {}, count = 0;
+      for (size_t i = 1; i < bins; i++) {
+        box.grow(b[k][i - 1].box), count += b[k][i - 1].count;
+        if (count == 0 || count == total) continue;
+        float cost = traversalCost + (box.area() * count + right[i]) * scale;
+        if (cost < best.cost) best.axis = k, best.bin = i, best.cost = cost;
+      }
+    }
+    for (size_t i = 0; best.axis >= 0 && i < bins; i++) (i < best.bin ? best.left : best.right).grow(b[best.axis][i].box);
+    return best;
+  }
+
+  // Boxes of the triangles refs[begin, end) and of their centroids.
+  inline void bound(const Ref* refs, size_t begin, size_t end, Box& box, Box& centroids) {
+    for (size_t i = begin; i < end; i++) {
+      float c[4];
+      refs[i].centroid(c);
+      box.grow(refs[i].min, refs[i].max), centroids.grow(c, c);
+    }
+  }
+
+  // Where node n splits: the ranges and boxes of its two children, or false
+  // for a leaf. Ranges of at most parallelTriangles are split on the calling
+  // thread.
+  inline bool split(Ref* refs, std::vector<Ref>& scratch, const Binary& n,
+    const Box& centroids, Binary* children, Box* childCentroids, ThreadPool& pool) {
+    if (n.count <= minLeaf) return false;
+    Ref* range = refs + n.first;
+    Binning binning(centroids);
+    Bins histogram{};
+    size_t chunks = (n.count + parallelTriangles - 1) / parallelTriangles;
+    if (chunks == 1)
+      bin(range, 0, n.count, binning, histogram);
+    else {
+      std::vector<Bins> parts(chunks);
+      parallelFor(n.count, parallelTriangles, [&](size_t begin, size_t end) {
+        bin(range, begin, end, binning, parts[begin / parallelTriangles]);
+      }, pool);
+      for (auto& part : parts)
+        for (int k = 0; k < 3; k++)
+          for (size_t i = 0; i < bins; i++) histogram[k][i].box.grow(part[k][i].box), histogram[k][i].count += part[k][i].count;
+    }
+
+    Split s = choose(histogram, n.box.area());
+    uint32_t mid = 0;
+    childCentroids[0] = childCentroids[1] = {};
+    if (s.axis >= 0 && (n.count > maxLeaf || s.cost < n.count)) {
+      // the side of a triangle, growing the box of the centroids on it
+      auto side = [&](const Ref& r, Box* boxes) {
+        float c[4];
+        r.centroid(c);
+        bool right = size_t(binning(c, s.axis)) >= s.bin;
+        boxes[right].grow(c, c);
+        return right;
+      };
+      if (chunks == 1)
+        for (Ref* l = range, * r = range + n.count; l < r;) {
+          if (!side(*l, childCentroids)) l++, mid++;
+          else std::swap(*l, *--r);
+        }
+      else {
+        // stable, through scratch: every chunk counts its left side, then
+        // writes both sides at their offsets
+        std::vector<size_t> offsets(chunks + 1, 0);
+        std::vector<Box> sides(chunks * 2);
+        parallelFor(n.count, parallelTriangles, [&](size_t begin, size_t end) {
+          size_t c = begin / parallelTriangles;
+          for (size_t i = begin; i < end; i++) offsets[c + 1] += !side(range[i], &sides[c * 2]);
+        }, pool);
+        for (size_t c = 0; c < chunks; c++) offsets[c + 1] += offsets[c];
+        mid = uint32_t(offsets[chunks]);
+        scratch.resize(n.count);
+        parallelFor(n.count, parallelTriangles, [&](size_t begin, size_t end) {
+          size_t c = begin / parallelTriangles, l = offsets[c], r = mid + begin - l;
+          Box ignored[2];
+          for (size_t i = begin; i < end; i++) scratch[side(range[i], ignored) ? r++ : l++] = range[i];
+        }, pool);
+        parallelFor(n.count, parallelTriangles, [&](size_t begin, size_t end) {
+          std::copy(scratch.begin() + begin, scratch.begin() + end, range + begin);
+        }, pool);
+        for (size_t c = 0; c < chunks * 2; c++) childCentroids[c % 2].grow(sides[c]);
+      }
+      children[0] = { s.left, n.first, mid }, children[1] = { s.right, n.first + mid, n.count - mid };
+    }
+    else if (n.count > maxLeaf) {
+      // centroids too close to bin: halves in their current order
+      mid = n.count / 2;
+      children[0] = { {}, n.first, mid }, children[1] = { {}, n.first + mid, n.count - mid };
+      for (int c = 0; c < 2; c++)
+        bound(refs, children[c].first, children[c].first + children[c].count, children[c].box, childCentroids[c]);
+    }
+    else
+      return false;
+    return true;
+  }
+
+  // Splits nodes[task.node] and everything below it on the calling thread.
+  inline void buildSubtree(Ref* refs, std::vector<Binary>& nodes, Task task, ThreadPool& pool) {
+    std::vector<Task> stack{ task };
+    std::vector<Ref> scratch;
+    while (!stack.empty()) {
+      Task t = stack.back();
+      stack.pop_back();
+      Binary children[2];
+      Box centroids[2];
+      if (!split(refs, scratch, nodes[t.node], t.centroids, children, centroids, pool)) continue;
+      uint32_t first = uint32_t(nodes.size());
+      nodes.push_back(children[0]), nodes.push_back(children[1]);
+      nodes[t.node].first = first, nodes[t.node].count = 0;
+      stack.push_back({ first + 1, centroids[1] }), stack.push_back({ first, centroids[0] });
+    }
+  }
+
+  // Appends the four-wide node over binary node b and those below it;
+  // returns its index.
+  inline uint32_t collapse(const std::vector<Binary>& binary, uint32_t b, std::vector<Node>& nodes) {
+    uint32_t self = uint32_t(nodes.size());
+    nodes.emplace_back();
+    uint32_t children[arity] = { b };
+    size_t count = 1;
+    if (binary[b].count == 0) children[0] = binary[b].first, children[1] = binary[b].first + 1, count = 2;
+    // open the largest interior child until all four slots are taken
+    while (count < arity) {
+      size_t widest = arity;
+      for (size_t c = 0; c < count; c++)
+        if (binary[children[c]].count == 0 &&
+          (widest == arity || binary[children[c]].box.area() > binary[children[widest]].box.area()))
+          widest = c;
+      if (widest == arity) break;
+      uint32_t opened = binary[children[widest]].first;
+      children[widest] = opened, children[count++] = opened + 1;
+    }
+
+    Node node;
+    for (size_t c = 0; c < arity; c++) {
+      const Binary* child = c < count ? &binary[children[c]] : nullptr;
+      for (int k = 0; k < 3; k++) {
+        node.min[k][c] = child ? child->box.min[k] : inf;
+        node.max[k][c] = child ? child->box.max[k] : -inf;
+      }
+      node.first[c] = child && child->count ? child->first : 0;
+      node.count[c] = child ? child->count : 0;
+    }
+    for (size_t c = 0; c < count; c++)
+      if (binary[children[c]].count == 0) node.first[c] = collapse(binary, children[c], nodes);
+    nodes[self] = node;
+    return self;
+  }
+
+  // Möller-Trumbore, from both sides.
+  inline bool intersectTriangle(const float* o, const float* d, const float* p0, const float* p1, const float* p2,
+    float& t, float& u, float& v) {
+    float e1[3], e2[3], s[3];
+    for (int k = 0; k < 3; k++) e1[k] = p1[k] - p0[k], e2[k] = p2[k] - p0[k], s[k] = o[k] - p0[k];
+    float p[3] = { d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0] };
+    float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+    if (det == 0) return false;
+    float inverse = 1 / det;
+    u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverse;
+    if (u < 0 || u > 1) return false;
+    float q[3] = { s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0] };
+    v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) * inverse;
+    if (v < 0 || u + v > 1) return false;
+    t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inverse;
+    return t >= 0;
+  }
+
+  // Walks the nodes along `ray` for the closest triangle, or with `any` for
+  // the first one found.
+  template <bool any, typename Scalar, typename Index>
+  inline bool traverse(const Tree& tree, const Scalar* V, const Index* F, const Ray& ray, Hit& hit) {
+    using simd::Float, simd::splat;
+    constexpr size_t width = simd::width;
+    hit = {};
+    hit.distance = ray.tmax;
+    if (tree.nodes.empty()) return false;
+
+    Float origin[3], inverse[3];
+    for (int k = 0; k < 3; k++) origin[k] = splat(ray.origin[k]), inverse[k] = splat(1 / ray.direction[k]);
+    // nodes to visit with the distance at which the ray enters them
+    static thread_local std::vector<std::pair<uint32_t, float>> stack;
+    stack.assign(1, { 0, 0.f });
+    while (!stack.empty()) {
+      auto [index, entry] = stack.back();
+      stack.pop_back();
+      if (entry > hit.distance) continue;
+      const Node& node = tree.nodes[index];
+
+      alignas(16) float near[arity];
+      int mask = 0;
+      for (size_t c = 0; c < arity; c += width) {
+        Float lo = splat(0), hi = splat(hit.distance);
+        for (int k = 0; k < 3; k++) {
+          Float t1 = (simd::load(&node.min[k][c]) - origin[k]) * inverse[k];
+          Float t2 = (simd::load(&node.max[k][c]) - origin[k]) * inverse[k];
+          lo = simd::max(lo, simd::min(t1, t2)), hi = simd::min(hi, simd::max(t1, t2));
+        }
+        mask |= simd::lessEqual(lo, hi) << c;
+        simd::store(&near[c], lo);
+      }
+
+      // leaves now, nodes onto the stack farthest first
+      uint32_t order[arity];
+      size_t hits = 0;
+      for (size_t c = 0; c < arity; c++) {
+        if (!(mask >> c & 1) || (node.count[c] == 0 && node.first[c] == 0)) continue;
+        size_t i = hits++;
+        for (; i > 0 && near[order[i - 1]] > near[c]; i--) order[i] = order[i - 1];
+        order[i] = uint32_t(c);
+      }
+      for (size_t i = 0; i < hits; i++) {
+        uint32_t c = order[i];
+        for (uint32_t j = node.first[c]; j < node.first[c] + node.count[c]; j++) {
+          uint32_t t = tree.triangles[j];
+          float p[3][3], distance, u, v;
+          for (int corner = 0; corner < 3; corner++)
+            for (int k = 0; k < 3; k++) p[corner][k] = float(V[size_t(F[size_t(t) * 3 + corner]) * 3 + k]);
+          if (intersectTriangle(ray.origin, ray.direction, p[0], p[1], p[2], distance, u, v) && distance < hit.distance) {
+            hit = { t, distance, u, v };
+            if (any) return true;
+          }
+        }
+      }
+      for (size_t i = hits; i-- > 0;) {
+        uint32_t c = order[i];
+        if (node.count[c] == 0) stack.push_back({ node.first[c], near[c] });
+      }
+    }
+    return hit.triangle != none;
+  }
+
+  // Finds the closest triangle of the list F over the positions V (xyz
+  // triples) that the tree was built for along `ray`, closer than
+  // ray.tmax; false when there is none.
+  template <typename Scalar, typename Index>
+  inline bool intersect(const Tree& tree, const Scalar* V, const Index* F, const Ray& ray, Hit& hit) {
+    return traverse<false>(tree, V, F, ray, hit);
+  }
+
+  // Whether any triangle lies along `ray` closer than ray.tmax, as for
+  // shadow and occlusion rays. Stops at the first one found.
+  template <typename Scalar, typename Index>
+  inline bool occluded(const Tree& tree, const Scalar* V, const Index* F, const Ray& ray) {
+    Hit hit;
+    return traverse<true>(tree, V, F, ray, hit);
+  }
+
+  // Squared distance from p to the triangle p0 p1 p2, by the region of the
+  // triangle p falls in (Ericson 2004, 5.1.5).
+  inline float squaredDistance(const float* p, const float* p0, const float* p1, const float* p2) {
+    float ab[3], ac[3], ap[3];
+    for (int k = 0; k < 3; k++) ab[k] = p1[k] - p0[k], ac[k] = p2[k] - p0[k], ap[k] = p[k] - p0[k];
+    auto dot = [](const float* a, const float* b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; };
+    // the closest point p0 + ab * v + ac * w
+    auto at = [&](float v, float w) {
+      float d = 0;
+      for (int k = 0; k < 3; k++) {
+        float e = ap[k] - ab[k] * v - ac[k] * w;
+        d += e * e;
+      }
+      return d;
+    };
+    float d1 = dot(ab, ap), d2 = dot(ac, ap);
+    if (d1 <= 0 && d2 <= 0) return at(0, 0);
+    float bp[3];
+    for (int k = 0; k < 3; k++) bp[k] = p[k] - p1[k];
+    float d3 = dot(ab, bp), d4 = dot(ac, bp);
+    if (d3 >= 0 && d4 <= d3) return at(1, 0);
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0) return at(d1 / (d1 - d3), 0);
+    float cp[3];
+    for (int k = 0; k < 3; k++) cp[k] = p[k] - p2[k];
+    float d5 = dot(ab, cp), d6 = dot(ac, cp);
+    if (d6 >= 0 && d5 <= d6) return at(0, 1);
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0) return at(0, d2 / (d2 - d6));
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) {
+      float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+      return at(1 - w, w);
+    }
+    float denominator = va + vb + vc;
+    if (denominator == 0) return at(0, 0);
+    return at(vb / denominator, vc / denominator);
+  }
+
+  // A triangle close to a point, at `distance` from it.
+  struct Nearest {
+    uint32_t triangle = none;
+    float distance = inf;
+  };
+
+  // Finds the closest triangle of the list F over the positions V (xyz
+  // triples) that the tree was built for to `point`; false when there is
+  // none. When `out` already holds a triangle, it starts from that one at
+  // out.distance, which must be its distance to the point, such as the
+  // closest triangle to a point nearby. With `enough` it may stop at the
+  // first triangle found within that distance instead, as when only
+  // distances above `enough` matter.
+  template <typename Scalar, typename Index>
+  inline bool nearest(const Tree& tree, const Scalar* V, const Index* F, const float* point, Nearest& out, float enough = 0) {
+    using simd::Float, simd::splat;
+    constexpr size_t width = simd::width;
+    float best = out.triangle == none ? inf : out.distance * out.distance, start = best, stop = enough * enough;
+    if (tree.nodes.empty()) {
+      out = {};
+      return false;
+    }
+
+    Float p[3];
+    for (int k = 0; k < 3; k++) p[k] = splat(point[k]);
+    // nodes to visit with the squared distance to their box
+    static thread_local std::vector<std::pair<uint32_t, float>> stack;
+    stack.assign(1, { 0, 0.f });
+    while (!stack.empty()) {
+      auto [index, entry] = stack.back();
+      stack.pop_back();
+      if (entry >= best) continue;
+      const Node& node = tree.nodes[index];
+
+      alignas(16) float near[arity];
+      for (size_t c = 0; c < arity; c += width) {
+        Float d = splat(0);
+        for (int k = 0; k < 3; k++) {
+          Float e = simd::max(simd::max(simd::load(&node.min[k][c]) - p[k], p[k] - simd::load(&node.max[k][c])), splat(0));
+          d = d + e * e;
+        }
+        simd::store(&near[c], d);
+      }
+
+      // leaves now, nodes onto the stack farthest first
+      uint32_t order[arity];
+      size_t hits = 0;
+      for (size_t c = 0; c < arity; c++) {
+        if (near[c] >= best || (node.count[c] == 0 && node.first[c] == 0)) continue;
+        size_t i = hits++;
+        for (; i > 0 && near[order[i - 1]] > near[c]; i--) order[i] = order[i - 1];
+        order[i] = uint32_t(c);
+      }
+      for (size_t i = 0; i < hits; i++) {
+        uint32_t c = order[i];
+        for (uint32_t j = node.first[c]; j < node.first[c] + node.count[c]; j++) {
+          uint32_t t = tree.triangles[j];
+          float q[3][3];
+          for (int corner = 0; corner < 3; corner++)
+            for (int k = 0; k < 3; k++) q[corner][k] = float(V[size_t(F[size_t(t) * 3 + corner]) * 3 + k]);
+          float d = squaredDistance(point, q[0], q[1], q[2]);
+          if (d < best) best = d, out.triangle = t;
+        }
+        if (best <= stop) break;
+      }
+      if (best <= stop) break;
+      for (size_t i = hits; i-- > 0;) {
+        uint32_t c = order[i];
+        if (node.count[c] == 0 && near[c] < best) stack.push_back({ node.first[c], near[c] });
+      }
+    }
+    if (best < start) out.distance = std::sqrt(best);
+    return true;
+  }
+}
+
+// Builds the tree over the triangle list F over the positions V (xyz
+// triples).
+template <typename Scalar, typename Index>
+inline void buildBvh(const std::vector<Scalar>& V, const std::vector<Index>& F, bvh::Tree& out,
+  ThreadPool& pool = ThreadPool::shared()) {
+  using namespace bvh;
+  size_t triangles = F.size() / 3;
+  out.nodes.clear();
+  out.triangles.resize(triangles);
+  if (triangles == 0) return;
+
+  std::vector<Ref> refs(triangles);
+  size_t chunks = (triangles + parallelTriangles - 1) / parallelTriangles;
+  std::vector<Box> boxes(chunks), centroids(chunks);
+  parallelFor(triangles, parallelTriangles, [&](size_t begin, size_t end) {
+    for (size_t t = begin; t < end; t++) {
+      Ref& r = refs[t];
+      uint32_t triangle = uint32_t(t);
+      std::memcpy(&r.min[3], &triangle, sizeof(triangle));
+      r.max[3] = 0;
+      for (int k = 0; k < 3; k++) r.min[k] = inf, r.max[k] = -inf;
+      for (int c = 0; c < 3; c++)
+        for (int k = 0; k < 3; k++) {
+          float x = float(V[size_t(F[t * 3 + c]) * 3 + k]);
+          r.min[k] = std::min(r.min[k], x), r.max[k] = std::max(r.max[k], x);
+        }
+    }
+    bound(refs.data(), begin, end, boxes[begin / parallelTriangles], centroids[begin / parallelTriangles]);
+  }, pool);
+
+  // large nodes level by level, each split in parallel, then the subtrees
+  // below them as tasks of their own
+  std::vector<Binary> binary(1, { {}, 0, uint32_t(triangles) });
+  Box rootCentroids;
+  for (size_t c = 0; c < chunks; c++) binary[0].box.grow(boxes[c]), rootCentroids.grow(centroids[c]);
+  std::vector<Task> level{ { 0, rootCentroids } }, subtrees;
+  std::vector<Ref> scratch;
+  while (!level.empty()) {
+    std::vector<Task> next;
+    for (const Task& t : level) {
+      Binary children[2];
+      Box childCentroids[2];
+      if (binary[t.node].count <= parallelTriangles) subtrees.push_back(t);
+      else if (split(refs.data(), scratch, binary[t.node], t.centroids, children, childCentroids, pool)) {
+        uint32_t first = uint32_t(binary.size());
+        binary.push_back(children[0]), binary.push_back(children[1]);
+        binary[t.node].first = first, binary[t.node].count = 0;
+        next.push_back({ first, childCentroids[0] }), next.push_back({ first + 1, childCentroids[1] });
+      }
+    }
+    level.swap(next);
+  }
+
+  std::vector<std::vector<Binary>> parts(subtrees.size());
+  pool.run(subtrees.size(), [&](size_t s, unsigned) {
+    parts[s].push_back(binary[subtrees[s].node]);
+    buildSubtree(refs.data(), parts[s], { 0, subtrees[s].centroids }, pool);
+  });
+  parallelFor(triangles, parallelTriangles, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) out.triangles[i] = refs[i].triangle();
+  }, pool);
+  // subtree nodes after the top ones, their root in place of the top node
+  for (size_t s = 0; s < subtrees.size(); s++) {
+    uint32_t base = uint32_t(binary.size()) - 1;
+    for (Binary& n : parts[s])
+      if (n.count == 0) n.first += base;
+    binary[subtrees[s].node] = parts[s][0];
+    binary.insert(binary.end(), parts[s].begin() + 1, parts[s].end());
+    parts[s] = {};
+  }
+
+  out.nodes.reserve(binary.size() / 2 + 1);
+  collapse(binary, 0, out.nodes);
+}
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "hash.hpp"
+#include "parallel.hpp"
+#include "write_off.hpp"
+
+// Parametric meshes of any size. Every surface computes vertex i and
+// triangle t on its own, so any range can be produced on any thread and
+// written out without holding the whole mesh in memory. Triangles are wound
+// counter-clockwise seen from outside (from +y for grids and terrains).
+namespace prim {
+  // Triangles of an nx x ny vertex lattice starting at vertex `first`,
+  // optionally wrapping around in x and/or y.
+  struct Lattice {
+    uint32_t nx, ny;
+    bool wrapX = false, wrapY = false;
+    uint64_t first = 0;
+
+    uint64_t quadsX() const { return wrapX ? nx : nx - 1; }
+    uint64_t quadsY() const { return wrapY ? ny : ny - 1; }
+    uint64_t vertexCount() const { return uint64_t(nx) * ny; }
+    uint64_t triangleCount() const { return quadsX() * quadsY() * 2; }
+
+    void triangle(uint64_t t, uint32_t* f) const {
+      uint64_t q = t / 2, i = q % quadsX(), j = q / quadsX();
+      uint64_t i1 = (i + 1) % nx, j1 = (j + 1) % ny;
+      uint32_t a = uint32_t(first + j * nx + i), b = uint32_t(first + j * nx + i1);
+      uint32_t c = uint32_t(first + j1 * nx + i), d = uint32_t(first + j1 * nx + i1);
+      if (t & 1) f[0] = b, f[1] = c, f[2] = d;
+      else f[0] = a, f[1] = c, f[2] = b;
+    }
+  };
+
+  // Lattice resolution giving about `triangles` triangles for an aspect of
+  // `ratio` quads in x per quad in y.
+  inline uint32_t quadsFor(uint64_t triangles, double ratio = 1) {
+    return uint32_t(std::max(1., std::round(std::sqrt(triangles / 2. / ratio))));
+  }
+
+  // Flat square of nx x ny vertices in the xz plane, centered at the origin.
+  struct Grid {
+    Lattice lattice;
+    float size = 2;
+
+    static Grid withTriangles(uint64_t triangles) {
+      uint32_t n = quadsFor(triangles) + 1;
+      return { { n, n } };
+    }
+
+    uint64_t vertexCount() const { return lattice.vertexCount(); }
+    uint64_t triangleCount() const { return lattice.triangleCount(); }
+    void triangle(uint64_t t, uint32_t* f) const { lattice.triangle(t, f); }
+
+    void vertex(uint64_t i, float* v) const {
+      v[0] = (float(i % lattice.nx) / (lattice.nx - 1) - .5f) * size;
+      v[1] = 0;
+      v[2] = (float(i / lattice.nx) / (lattice.ny - 1) - .5f) * size;
+    }
+  };
+
+  // Value noise on the integer lattice, smoothly interpolated, in [-1, 1].
+  inline float valueNoise(float x, float z, uint32_t seed) {
+    float fx = std::floor(x), fz = std::floor(z);
+    int64_t ix = int64_t(fx), iz = int64_t(fz);
+    auto corner = [&](int64_t a, int64_t b) {
+      uint64_t h = hashMix((uint64_t(a) * 0x9e3779b97f4a7c15ull) ^ (uint64_t(b) * 0xc2b2ae3d27d4eb4full) ^ seed);
+      return float(h >> 40) / float(1 << 23) - 1.f;
+    };
+    float tx = x - fx, tz = z - fz;
+    tx = tx * tx * (3 - 2 * tx);
+    tz = tz * tz * (3 - 2 * tz);
+    float a = corner(ix, iz) + (corner(ix + 1, iz) - corner(ix, iz)) * tx;
+    float b = corner(ix, iz + 1) + (corner(ix + 1, iz + 1) - corner(ix, iz + 1)) * tx;
+    return a + (b - a) * tz;
+  }
+
+  // Grid displaced along y by fractal value noise.
+  struct Terrain {
+    Grid grid;
+    float height = .25f;
+    float frequency = 4;
+    uint32_t octaves = 6;
+    uint32_t seed = 1;
+
+    static Terrain withTriangles(uint64_t triangles) {
+      return { Grid::withTriangles(triangles) };
+    }
+
+    uint64_t vertexCount() const { return grid.vertexCount(); }
+    uint64_t triangleCount() const { return grid.triangleCount(); }
+    void triangle(uint64_t t, uint32_t* f) const { grid.triangle(t, f); }
+
+    void vertex(uint64_t i, float* v) const {
+      grid.vertex(i, v);
+      float amplitude = height, f = frequency / grid.size, y = 0;
+      for (uint32_t o = 0; o < octaves; o++, amplitude *= .5f, f *= 2)
+        y += amplitude * valueNoise(v[0] * f, v[2] * f, seed + o);
+      v[1] = y;
+    }
+  };
+
+  // Torus around the y axis with `major` segments around the ring and
+  // `minor` around the tube.
+  struct Torus {
+    Lattice lattice;
+    float radius = 1;
+    float tube = .3f;
+
+    static Torus withTriangles(uint64_t triangles) {
+      uint32_t minor = quadsFor(triangles, 3);
+      return { { minor * 3, minor, true, true } };
+    }
+
+    uint64_t vertexCount() const { return lattice.vertexCount(); }
+    uint64_t triangleCount() const { return lattice.triangleCount(); }
+    void triangle(uint64_t t, uint32_t* f) const { lattice.triangle(t, f); }
+
+    void vertex(uint64_t i, float* v) const {
+      double u = 2 * M_PI * double(i % lattice.nx) / lattice.nx;
+      double w = 2 * M_PI * double(i / lattice.nx) / lattice.ny;
+      double r = radius + tube * std::cos(w);
+      v[0] = float(r * std::cos(u));
+      v[1] = float(tube * std::sin(w));
+      v[2] = float(r * std::sin(u));
+    }
+  };
+
+  // Unit sphere made of the six faces of a cube, each an (n + 1) x (n + 1)
+  // lattice, projected with an equal-angle warp so triangles are of similar
+  // size. Vertices along the cube edges are repeated per face.
+  struct Sphere {
+    uint32_t n;
+
+    static Sphere withTriangles(uint64_t triangles) {
+      return { quadsFor(triangles / 6) };
+    }
+
+    Lattice face(uint32_t f) const {
+      return { n + 1, n + 1, false, false, uint64_t(f) * (n + 1) * (n + 1) };
+    }
+
+    uint64_t vertexCount() const { return face(0).vertexCount() * 6; }
+    uint64_t triangleCount() const { return face(0).triangleCount() * 6; }
+
+    void triangle(uint64_t t, uint32_t* f) const {
+      uint64_t perFace = face(0).triangleCount();
+      face(uint32_t(t / perFace)).triangle(t % perFace, f);
+    }
+
+    void vertex(uint64_t i, float* v) const {
+      // face axes (u, v, normal) with u x v = -normal, as lattice triangles
+      // are counter-clockwise when seen from -(u x v)
+      static constexpr int8_t axes[6][9] = {
+        { 0, 1, 0, 0, 0, -1, 1, 0, 0 },  { 0, 1, 0, 0, 0, 1, -1, 0, 0 },
+        { 0, 0, -1, 1, 0, 0, 0, 1, 0 },  { 0, 0, 1, 1, 0, 0, 0, -1, 0 },
+        { 0, 1, 0, 1, 0, 0, 0, 0, 1 },   { 0, 1, 0, -1, 0, 0, 0, 0, -1 },
+      };
+      uint64_t perFace = face(0).vertexCount(), k = i % perFace;
+      const int8_t* a = axes[i / perFace];
+      double s = std::tan((double(k % (n + 1)) / n * 2 - 1) * M_PI_4);
+      double t = std::tan((double(k / (n + 1)) / n * 2 - 1) * M_PI_4);
+      double p[3];
+      for (int c = 0; c < 3; c++) p[c] = a[c] * s + a[3 + c] * t + a[6 + c];
+      double l = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+      for (int c = 0; c < 3; c++) v[c] = float(p[c] / l);
+    }
+  };
+
+  // Fills V and F with the whole surface, in parallel chunks.
+  template <typename Surface>
+  inline void generate(const Surface& surface, std::vector<float>& V, std::vector<uint32_t>& F,
+    ThreadPool& pool = ThreadPool::shared()) {
+    V.resize(surface.vertexCount() * 3);
+    F.resize(surface.triangleCount() * 3);
+    parallelFor(surface.vertexCount(), 1 << 16, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) surface.vertex(i, &V[i * 3]);
+    }, pool);
+    parallelFor(surface.triangleCount(), 1 << 16, [&](size_t begin, size_t end) {
+      for (size_t t = begin; t < end; t++) surface.triangle(t, &F[t * 3]);
+    }, pool);
+  }
+
+  // Writes the surface as text or binary OFF, generating and formatting
+  // chunks in parallel; memory use does not depend on the mesh size.
+  template <typename Surface>
+  inline bool writeOFF(const std::string& file_name, const Surface& surface, bool binary = false,
+    size_t grain = size_t(1) << 16, ThreadPool& pool = ThreadPool::shared()) {
+    FILE* file = fopen(file_name.c_str(), "wb");
+    if (!file) {
+      printf("prim::writeOFF() failed, cannot open %s\n", file_name.c_str());
+      return false;
+    }
+
+    TextWriter header;
+    if (binary) {
+      header.put("OFF BINARY\n", 11);
+      header.bigEndian32(surface.vertexCount());
+      header.bigEndian32(surface.triangleCount());
+      header.bigEndian32(0);
+    }
+    else {
+      header.put("OFF\n", 4);
+      header.number(surface.vertexCount());
+      header.put(' ');
+      header.number(surface.triangleCount());
+      header.put(" 0\n", 3);
+    }
+    bool ok = fwrite(header.buf.data(), 1, header.size, file) == header.size;
+
+    ok = ok && writeOFFChunks(file, surface.vertexCount(), grain, [&](size_t begin, size_t end, TextWriter& out) {
+      float v[3];
+      for (size_t i = begin; i < end; i++) {
+        surface.vertex(i, v);
+        if (binary) {
+          for (int k = 0; k < 3; k++) out.bigEndianFloat(v[k]);
+          continue;
+        }
+        out.number(v[0]); out.put(' '); out.number(v[1]); out.put(' '); out.number(v[2]);
+        out.put('\n');
+      }
+    }, pool);
+
+    ok = ok && writeOFFChunks(file, surface.triangleCount(), grain, [&](size_t begin, size_t end, TextWriter& out) {
+      uint32_t f[3];
+      for (size_t t = begin; t < end; t++) {
+        surface.triangle(t, f);
+        if (binary) {
+          out.bigEndian32(3);
+          for (int k = 0; k < 3; k++) out.bigEndian32(f[k]);
+          out.bigEndian32(0);
+          continue;
+        }
+        out.put("3 ", 2);
+        out.number(f[0]); out.put(' '); out.number(f[1]); out.put(' '); out.number(f[2]);
+        out.put('\n');
+      }
+    }, pool);
+
+    ok = fclose(file) == 0 && ok;
+    if (!ok) printf("prim::writeOFF() failed, cannot write %s\n", file_name.c_str());
+    return ok;
+  }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "mapped_file.hpp"
+
+// Fast non-cryptographic 64-bit hash for content fingerprints.
+inline uint64_t hashMix(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdull;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ull;
+  x ^= x >> 33;
+  return x;
+}
+
+inline uint64_t hash64(const void* data, size_t size, uint64_t seed = 0) {
+  constexpr uint64_t k = 0x9e3779b97f4a7c15ull;
+  auto round = [](uint64_t lane, uint64_t word) {
+    lane = (lane ^ word) * k;
+    return (lane << 31) | (lane >> 33);
+  };
+
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  const uint64_t length = size;
+  uint64_t lanes[4] = { seed, seed + k, seed - k, ~seed };
+  uint64_t words[4];
+  for (; size >= 32; p += 32, size -= 32) {
+    std::memcpy(words, p, 32);
+    for (int i = 0; i < 4; i++) lanes[i] = round(lanes[i], words[i]);
+  }
+
+  uint64_t h = hashMix(lanes[0]) ^ hashMix(lanes[1] + 1) ^ hashMix(lanes[2] + 2) ^ hashMix(lanes[3] + 3);
+  for (; size >= 8; p += 8, size -= 8) {
+    std::memcpy(words, p, 8);
+    h = round(h, words[0]);
+  }
+  uint64_t tail = 0;
+  if (size) std::memcpy(&tail, p, size);
+  return hashMix(round(h, tail) ^ length);
+}
+
+inline uint64_t hashFile(const std::string& path) {
+  MappedFile file(path);
+  return hash64(file.data, file.size);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Index buffer stored at the narrowest width that addresses every vertex:
+// 16-bit up to 65536 vertices, 32-bit beyond. The 16-bit storage is padded to
+// a multiple of 4 bytes as required for GPU buffer writes.
+class IndexStream {
+public:
+  std::vector<uint16_t> narrow;
+  std::vector<uint32_t> wide;
+  size_t count = 0;
+
+  static constexpr uint64_t narrowLimit = uint64_t(std::numeric_limits<uint16_t>::max()) + 1;
+
+  bool isWide() const { return wideIndices; }
+  uint32_t stride() const { return isWide() ? 4 : 2; }
+  size_t size() const { return count; }
+  uint64_t bytes() const { return uint64_t(count) * stride(); }
+  const void* data() const { return isWide() ? static_cast<const void*>(wide.data()) : narrow.data(); }
+
+  uint32_t operator[](size_t i) const { return isWide() ? wide[i] : narrow[i]; }
+
+  // Takes over 32-bit indices of a mesh with `vertexCount` vertices,
+  // narrowing them when possible.
+  void assign(std::vector<uint32_t>&& indices, uint64_t vertexCount) {
+    count = indices.size();
+    narrow.clear();
+    wide.clear();
+    wideIndices = vertexCount > narrowLimit;
+    if (wideIndices) {
+      wide = std::move(indices);
+      return;
+    }
+    narrow.resize((count + 1) & ~size_t(1));
+    for (size_t i = 0; i < count; i++) narrow[i] = static_cast<uint16_t>(indices[i]);
+  }
+
+  // Sizes the stream for `indices` indices of a mesh with `vertexCount`
+  // vertices, to be filled through narrow or wide.
+  void resize(size_t indices, uint64_t vertexCount) {
+    count = indices;
+    wideIndices = vertexCount > narrowLimit;
+    narrow.resize(wideIndices ? 0 : (count + 1) & ~size_t(1));
+    wide.resize(wideIndices ? count : 0);
+  }
+
+private:
+  bool wideIndices = false;
+};
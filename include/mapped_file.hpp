@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only view of a whole file mapped into memory.
+class MappedFile {
+public:
+  const char* data = nullptr;
+  size_t size = 0;
+
+  MappedFile() = default;
+
+  MappedFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0) {
+      opened = true;
+      if (st.st_size > 0) {
+        void* ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (ptr != MAP_FAILED) {
+          madvise(ptr, st.st_size, MADV_SEQUENTIAL);
+          data = static_cast<const char*>(ptr);
+          size = st.st_size;
+        }
+        else opened = false;
+      }
+    }
+    close(fd);
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+
+  MappedFile& operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+      unmap();
+      data = std::exchange(other.data, nullptr);
+      size = std::exchange(other.size, 0);
+      opened = std::exchange(other.opened, false);
+    }
+    return *this;
+  }
+
+  ~MappedFile() { unmap(); }
+
+  bool valid() const { return opened; }
+
+  const char* begin() const { return data; }
+  const char* end() const { return data + size; }
+
+private:
+  bool opened = false;
+
+  void unmap() {
+    if (data) munmap(const_cast<char*>(data), size);
+    data = nullptr;
+    size = 0;
+  }
+};
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "hash.hpp"
+#include "mapped_file.hpp"
+
+// Binary, GPU-ready mesh container:
+//
+//   meshcache::Header
+//   meshcache::Stream[streamCount]
+//   stream data, each stream 16-byte aligned and zero padded
+//
+// With a Levels stream, the index stream holds the index lists of every
+// level of detail one after another, finest first.
+//
+// Streams are stored exactly as they are uploaded, so a loaded cache can be
+// passed straight from the mapping to WGPU::Buffer::write. The padding also
+// covers index buffers whose size is rounded up to a multiple of 4.
+namespace meshcache {
+  constexpr char magic[8] = { 'W', 'G', 'P', 'U', 'M', 'E', 'S', 'H' };
+  constexpr uint32_t version = 2;
+  constexpr uint64_t alignment = 16;
+
+  enum Semantic : uint32_t {
+    Position = 0,
+    Normal = 1,
+    Color = 2,
+    TexCoord = 3,
+    Index = 4,
+    Levels = 5, // meshcache::Level records, as Uint32 x 4
+    Tangent = 6, // xyz and bitangent sign, as Snorm8 x 4
+    Stats = 7,   // meshcache::Range records, as Float32 x 20
+    Occlusion = 8, // bakeOcclusion, 0 closed to 1 open, as Float32 x 1
+  };
+
+  enum Format : uint32_t {
+    Float32 = 0,
+    Uint8 = 1,
+    Unorm8 = 2,
+    Uint16 = 3,
+    Uint32 = 4,
+    Unorm16 = 5,     // positions quantized to the header bounds
+    Snorm16 = 6,     // octahedral normals, 2 components
+    DeltaVarint = 7, // meshcodec::encodeIndices, one byte components
+    Snorm8 = 8,      // tangent::pack
+  };
+
+  inline uint32_t formatSize(Format format) {
+    switch (format) {
+    case Float32: case Uint32: return 4;
+    case Uint16: case Unorm16: case Snorm16: return 2;
+    default: return 1;
+    }
+  }
+
+  // A level of detail: its range of the index stream and its distance, in
+  // model units, to the full mesh.
+  struct Level {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;
+    uint32_t reserved;
+  };
+
+  // Range and mean of every component of a float vertex stream, as
+  // computeMeshStats finds them. The record of the positions also has their
+  // bounding sphere, center xyz and radius.
+  struct Range {
+    uint32_t semantic;
+    uint32_t components;
+    uint32_t reserved[2];
+    float min[4];
+    float max[4];
+    float mean[4];
+    float sphere[4];
+  };
+
+  // Identity of the file a cache was built from.
+  struct Source {
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    uint64_t hash = 0;
+
+    static bool stat(const std::string& path, Source& out) {
+      std::error_code ec;
+      out.size = std::filesystem::file_size(path, ec);
+      if (ec) return false;
+      out.mtime = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+      return !ec;
+    }
+
+    static bool of(const std::string& path, Source& out) {
+      if (!stat(path, out)) return false;
+      out.hash = hashFile(path);
+      return true;
+    }
+  };
+
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t streamCount;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    float boundsMin[3];
+    float boundsMax[3];
+    Source source;
+    uint64_t contentHash;
+    // version of the code that produced the streams, as passed to write(),
+    // so that a reader can reject caches an older pipeline wrote
+    uint32_t pipeline;
+    uint32_t reserved;
+  };
+
+  struct Stream {
+    uint32_t semantic;
+    uint32_t format;
+    uint32_t components;
+    uint32_t stride;
+    uint64_t offset;
+    uint64_t size;
+  };
+
+  static_assert(sizeof(Header) == 96 && sizeof(Stream) == 32 && sizeof(Level) == 16 && sizeof(Range) == 80,
+    "mesh cache layout changed, bump version");
+
+  // Input to write(): `count` elements of `components` values each. Quantized
+  // positions pass the box they were quantized to as `bounds` (min xyz, max
+  // xyz); float positions may pass their box to save a pass over them.
+  struct StreamData {
+    Semantic semantic;
+    Format format;
+    uint32_t components;
+    const void* data;
+    uint64_t count;
+    const float* bounds = nullptr;
+  };
+
+  inline uint64_t alignUp(uint64_t x) { return (x + alignment - 1) & ~(alignment - 1); }
+
+  // Writes the streams to `path` through a temporary file and a rename, so a
+  // crash never leaves a truncated cache behind.
+  inline bool write(const std::string& path, const Source& source, const std::vector<StreamData>& streams,
+    uint32_t pipeline = 0) {
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.pipeline = pipeline;
+    header.streamCount = streams.size();
+    header.source = source;
+
+    std::vector<Stream> table(streams.size());
+    uint64_t offset = alignUp(sizeof(Header) + sizeof(Stream) * streams.size());
+    uint64_t hash = 0;
+    for (size_t i = 0; i < streams.size(); i++) {
+      auto& s = streams[i];
+      uint32_t stride = formatSize(s.format) * s.components;
+      table[i] = { s.semantic, s.format, s.components, stride, offset, stride * s.count };
+      offset = alignUp(offset + table[i].size);
+      hash = hash64(s.data, table[i].size, hash);
+
+      if (s.semantic == Index) {
+        header.indexCount = s.count * s.components;
+        // encoded indices start with their decoded count
+        if (s.format == DeltaVarint) std::memcpy(&header.indexCount, s.data, sizeof(uint64_t));
+      }
+      if (s.semantic == Position) {
+        header.vertexCount = s.count;
+        if (s.bounds) {
+          std::memcpy(header.boundsMin, s.bounds, sizeof(header.boundsMin));
+          std::memcpy(header.boundsMax, s.bounds + 3, sizeof(header.boundsMax));
+        }
+        else if (s.format == Float32 && s.components == 3 && s.count) {
+          const float* v = static_cast<const float*>(s.data);
+          for (int k = 0; k < 3; k++) header.boundsMin[k] = header.boundsMax[k] = v[k];
+          for (uint64_t j = 0; j < s.count; j++)
+            for (int k = 0; k < 3; k++) {
+              header.boundsMin[k] = std::min(header.boundsMin[k], v[j * 3 + k]);
+              header.boundsMax[k] = std::max(header.boundsMax[k], v[j * 3 + k]);
+            }
+        }
+      }
+    }
+    header.contentHash = hash;
+
+    std::string tmp = path + ".tmp";
+    FILE* file = fopen(tmp.c_str(), "wb");
+    if (!file) {
+      printf("meshcache::write() failed, cannot open %s\n", tmp.c_str());
+      return false;
+    }
+
+    static const char zeros[alignment] = {};
+    bool ok = fwrite(&header, sizeof(Header), 1, file) == 1;
+    if (!table.empty()) ok = ok && fwrite(table.data(), sizeof(Stream), table.size(), file) == table.size();
+    uint64_t written = sizeof(Header) + sizeof(Stream) * table.size();
+    for (size_t i = 0; ok && i < streams.size(); i++) {
+      ok = fwrite(zeros, 1, table[i].offset - written, file) == table[i].offset - written;
+      ok = ok && fwrite(streams[i].data, 1, table[i].size, file) == table[i].size;
+      written = table[i].offset + table[i].size;
+    }
+    ok = ok && fwrite(zeros, 1, alignUp(written) - written, file) == alignUp(written) - written;
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+      printf("meshcache::write() failed, cannot write %s\n", path.c_str());
+      std::remove(tmp.c_str());
+      return false;
+    }
+    return true;
+  }
+}
+
+// A mapped mesh cache file. Stream data points directly into the mapping.
+class MeshCache {
+public:
+  MappedFile file;
+  const meshcache::Header* header = nullptr;
+  const meshcache::Stream* streams = nullptr;
+
+  bool open(const std::string& path) {
+    using namespace meshcache;
+    header = nullptr;
+    streams = nullptr;
+    file = MappedFile(path);
+    if (file.size < sizeof(Header)) return false;
+
+    auto h = reinterpret_cast<const Header*>(file.data);
+    if (std::memcmp(h->magic, magic, sizeof(magic)) != 0 || h->version != version) return false;
+    if (file.size < sizeof(Header) + sizeof(Stream) * uint64_t(h->streamCount)) return false;
+
+    auto s = reinterpret_cast<const Stream*>(file.data + sizeof(Header));
+    for (uint32_t i = 0; i < h->streamCount; i++)
+      if (s[i].offset > file.size || alignUp(s[i].size) > file.size - s[i].offset) {
+        printf("MeshCache::open() failed, %s is truncated\n", path.c_str());
+        return false;
+      }
+
+    header = h;
+    streams = s;
+    return true;
+  }
+
+  bool valid() const { return header != nullptr; }
+
+  const meshcache::Stream* find(meshcache::Semantic semantic) const {
+    for (uint32_t i = 0; valid() && i < header->streamCount; i++)
+      if (streams[i].semantic == semantic) return &streams[i];
+    return nullptr;
+  }
+
+  const void* data(const meshcache::Stream& stream) const {
+    return file.data + stream.offset;
+  }
+
+  // Recomputes the content hash of all streams.
+  bool verify() const {
+    uint64_t hash = 0;
+    for (uint32_t i = 0; valid() && i < header->streamCount; i++)
+      hash = hash64(data(streams[i]), streams[i].size, hash);
+    return valid() && hash == header->contentHash;
+  }
+
+  // Invalidation rule: the cache is fresh when the source has the recorded
+  // size and mtime. When only the mtime changed (touch, checkout, copy) the
+  // source is hashed and the cache is still fresh if the content is equal.
+  bool isFresh(const std::string& sourcePath) const {
+    meshcache::Source source;
+    if (!valid() || !meshcache::Source::stat(sourcePath, source)) return false;
+    if (source.size != header->source.size) return false;
+    if (source.mtime == header->source.mtime) return true;
+    return hashFile(sourcePath) == header->source.hash;
+  }
+};
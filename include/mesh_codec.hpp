@@ -0,0 +1,289 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "index_stream.hpp"
+#include "mesh_cache.hpp"
+#include "parallel.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Compact encodings of mesh streams, stored in a mesh cache with the
+// Unorm16, Snorm16 and DeltaVarint formats and decoded back to GPU-ready
+// float positions, float normals and 16/32-bit indices:
+//
+//   positions  16 bits per component relative to the bounds
+//   normals    octahedral projection, 2 x 16 bits
+//   indices    blocks of zigzag deltas between consecutive indices as
+//              LEB128 varints, with a block offset table so blocks decode
+//              in parallel
+namespace meshcodec {
+  constexpr uint32_t indexBlock = 1 << 14;
+
+  // Box the positions are quantized to, min xyz then max xyz.
+  struct Bounds {
+    float v[6];
+
+    const float* min() const { return v; }
+    const float* max() const { return v + 3; }
+  };
+
+  inline Bounds bounds(const float* V, size_t n) {
+    Bounds b{ { 0, 0, 0, 0, 0, 0 } };
+    for (size_t i = 0; i < n; i++)
+      for (int k = 0; k < 3; k++) {
+        float x = V[i * 3 + k];
+        if (i == 0 || x < b.v[k]) b.v[k] = x;
+        if (i == 0 || x > b.v[k + 3]) b.v[k + 3] = x;
+      }
+    return b;
+  }
+
+  // Step between quantized values of component k, the error bound is half of it.
+  inline float step(const Bounds& b, int k) {
+    return (b.v[k + 3] - b.v[k]) / 65535.f;
+  }
+
+  // Writes `stride` components per vertex, xyz and then padding that is left
+  // as it is.
+  inline void quantizePositions(const float* V, size_t n, const Bounds& b, uint16_t* Q, size_t stride = 3) {
+    for (int k = 0; k < 3; k++) {
+      float extent = b.v[k + 3] - b.v[k];
+      float scale = extent > 0 ? 65535.f / extent : 0.f;
+      for (size_t i = 0; i < n; i++)
+        Q[i * stride + k] = uint16_t(std::clamp((V[i * 3 + k] - b.v[k]) * scale + .5f, 0.f, 65535.f));
+    }
+  }
+
+  // V = min + Q * step, four vertices (twelve components) per vector
+  // iteration, in parallel chunks; Q with padding (`stride` over 3) is read
+  // one component at a time.
+  inline void dequantizePositions(const uint16_t* Q, size_t n, const Bounds& b, float* V, size_t stride = 3,
+    ThreadPool& pool = ThreadPool::shared()) {
+    float s[3] = { step(b, 0), step(b, 1), step(b, 2) };
+    const float* o = b.min();
+    parallelFor(n, 1 << 16, [&](size_t begin, size_t end) {
+      size_t i = begin;
+#if defined(__SSE2__) || defined(__ARM_NEON)
+      alignas(16) float scale[12] = { s[0], s[1], s[2], s[0], s[1], s[2], s[0], s[1], s[2], s[0], s[1], s[2] };
+      alignas(16) float offset[12] = { o[0], o[1], o[2], o[0], o[1], o[2], o[0], o[1], o[2], o[0], o[1], o[2] };
+#if defined(__SSE2__)
+      __m128 s0 = _mm_load_ps(scale), s1 = _mm_load_ps(scale + 4), s2 = _mm_load_ps(scale + 8);
+      __m128 o0 = _mm_load_ps(offset), o1 = _mm_load_ps(offset + 4), o2 = _mm_load_ps(offset + 8);
+      __m128i zero = _mm_setzero_si128();
+      for (; stride == 3 && i + 4 <= end; i += 4) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Q + i * 3));
+        __m128i c = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(Q + i * 3 + 8));
+        __m128 f0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(a, zero));
+        __m128 f1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(a, zero));
+        __m128 f2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(c, zero));
+        _mm_storeu_ps(V + i * 3, _mm_add_ps(o0, _mm_mul_ps(f0, s0)));
+        _mm_storeu_ps(V + i * 3 + 4, _mm_add_ps(o1, _mm_mul_ps(f1, s1)));
+        _mm_storeu_ps(V + i * 3 + 8, _mm_add_ps(o2, _mm_mul_ps(f2, s2)));
+      }
+#else
+      float32x4_t s0 = vld1q_f32(scale), s1 = vld1q_f32(scale + 4), s2 = vld1q_f32(scale + 8);
+      float32x4_t o0 = vld1q_f32(offset), o1 = vld1q_f32(offset + 4), o2 = vld1q_f32(offset + 8);
+      for (; stride == 3 && i + 4 <= end; i += 4) {
+        uint16x8_t a = vld1q_u16(Q + i * 3);
+        uint16x4_t c = vld1_u16(Q + i * 3 + 8);
+        vst1q_f32(V + i * 3, vmlaq_f32(o0, vcvtq_f32_u32(vmovl_u16(vget_low_u16(a))), s0));
+        vst1q_f32(V + i * 3 + 4, vmlaq_f32(o1, vcvtq_f32_u32(vmovl_u16(vget_high_u16(a))), s1));
+        vst1q_f32(V + i * 3 + 8, vmlaq_f32(o2, vcvtq_f32_u32(vmovl_u16(c)), s2));
+      }
+#endif
+#endif
+      for (; i < end; i++)
+        for (int k = 0; k < 3; k++) V[i * 3 + k] = o[k] + Q[i * stride + k] * s[k];
+    }, pool);
+  }
+
+  inline int16_t snorm16(float x) {
+    return int16_t(std::lround(std::clamp(x, -1.f, 1.f) * 32767.f));
+  }
+
+  // Unit vectors onto the octahedron, folded into the [-1, 1] square.
+  inline void octEncode(const float* N, size_t n, int16_t* Q) {
+    for (size_t i = 0; i < n; i++) {
+      float x = N[i * 3], y = N[i * 3 + 1], z = N[i * 3 + 2];
+      float l1 = std::abs(x) + std::abs(y) + std::abs(z);
+      if (l1 == 0) l1 = 1, z = 1;
+      x /= l1, y /= l1, z /= l1;
+      if (z < 0) {
+        float fx = (1 - std::abs(y)) * (x >= 0 ? 1 : -1);
+        float fy = (1 - std::abs(x)) * (y >= 0 ? 1 : -1);
+        x = fx, y = fy;
+      }
+      Q[i * 2] = snorm16(x);
+      Q[i * 2 + 1] = snorm16(y);
+    }
+  }
+
+  // Branch-free so the loop vectorizes.
+  inline void octDecode(const int16_t* Q, size_t n, float* N, ThreadPool& pool = ThreadPool::shared()) {
+    parallelFor(n, 1 << 16, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        float x = std::max(Q[i * 2] / 32767.f, -1.f), y = std::max(Q[i * 2 + 1] / 32767.f, -1.f);
+        float z = 1 - std::abs(x) - std::abs(y);
+        float t = std::max(-z, 0.f);
+        x += x >= 0 ? -t : t;
+        y += y >= 0 ? -t : t;
+        float inv = 1 / std::sqrt(x * x + y * y + z * z);
+        N[i * 3] = x * inv, N[i * 3 + 1] = y * inv, N[i * 3 + 2] = z * inv;
+      }
+    }, pool);
+  }
+
+  // Layout: uint64 index count, uint64 block count, uint64 end offset of
+  // every block (from the start of the stream), then the blocks. Every block
+  // restarts its delta from 0.
+  inline void encodeIndices(const uint32_t* I, size_t n, std::vector<uint8_t>& out) {
+    uint64_t blocks = (n + indexBlock - 1) / indexBlock;
+    uint64_t headerSize = (2 + blocks) * sizeof(uint64_t);
+    out.assign(headerSize, 0);
+    out.reserve(headerSize + n * 2);
+    std::vector<uint64_t> table{ n, blocks };
+    for (size_t begin = 0; begin < n; begin += indexBlock) {
+      int64_t previous = 0;
+      for (size_t i = begin, end = std::min<size_t>(begin + indexBlock, n); i < end; i++) {
+        int64_t delta = int64_t(I[i]) - previous;
+        previous = I[i];
+        uint64_t zigzag = (uint64_t(delta) << 1) ^ uint64_t(delta >> 63);
+        for (; zigzag >= 0x80; zigzag >>= 7) out.push_back(uint8_t(zigzag) | 0x80);
+        out.push_back(uint8_t(zigzag));
+      }
+      table.push_back(out.size());
+    }
+    std::memcpy(out.data(), table.data(), headerSize);
+  }
+
+  // Decodes `count` indices into I, checking them against `vertexCount` and
+  // the stream against its size. Blocks run in parallel.
+  template <typename Index>
+  inline bool decodeIndices(const uint8_t* data, size_t size, uint64_t count, uint64_t vertexCount, Index* I,
+    ThreadPool& pool = ThreadPool::shared()) {
+    if (size < 2 * sizeof(uint64_t)) return false;
+    uint64_t n, blocks;
+    std::memcpy(&n, data, sizeof(uint64_t));
+    std::memcpy(&blocks, data + 8, sizeof(uint64_t));
+    if (n != count || blocks != (n + indexBlock - 1) / indexBlock || (size - 16) / sizeof(uint64_t) < blocks) return false;
+
+    std::vector<uint64_t> ends(blocks);
+    if (blocks) std::memcpy(ends.data(), data + 16, blocks * sizeof(uint64_t));
+    uint64_t first = 16 + blocks * sizeof(uint64_t);
+
+    std::vector<char> ok(blocks, 0);
+    pool.run(blocks, [&](size_t b, unsigned) {
+      if ((b ? ends[b - 1] : first) > ends[b] || ends[b] > size) return;
+      const uint8_t* p = data + (b ? ends[b - 1] : first);
+      const uint8_t* end = data + ends[b];
+      int64_t previous = 0;
+      for (size_t i = b * indexBlock, last = std::min<size_t>(i + indexBlock, n); i < last; i++) {
+        uint64_t zigzag = 0;
+        for (int shift = 0;; shift += 7) {
+          if (p == end || shift > 63) return;
+          uint8_t byte = *p++;
+          zigzag |= uint64_t(byte & 0x7f) << shift;
+          if (byte < 0x80) break;
+        }
+        previous += int64_t(zigzag >> 1) ^ -int64_t(zigzag & 1);
+        if (uint64_t(previous) >= vertexCount) return;
+        I[i] = Index(previous);
+      }
+      ok[b] = p == end;
+    });
+    return std::all_of(ok.begin(), ok.end(), [](char c) { return c; });
+  }
+
+  // Encoded streams of a mesh, kept alive until meshcache::write.
+  struct Encoded {
+    Bounds bounds;
+    uint64_t vertexCount = 0;
+    std::vector<uint16_t> positions;
+    std::vector<int16_t> normals;
+    std::vector<uint8_t> indices;
+
+    std::vector<meshcache::StreamData> streams() const {
+      using namespace meshcache;
+      std::vector<StreamData> out{
+        {.semantic = Position, .format = Unorm16, .components = 3, .data = positions.data(), .count = vertexCount, .bounds = bounds.v },
+        {.semantic = Index, .format = DeltaVarint, .components = 1, .data = indices.data(), .count = indices.size() },
+      };
+      if (!normals.empty())
+        out.push_back({ .semantic = Normal, .format = Snorm16, .components = 2, .data = normals.data(), .count = vertexCount });
+      return out;
+    }
+  };
+
+  // Encodes n positions, optional normals N and the indices of a mesh.
+  inline void encode(const float* V, size_t n, const float* N, const uint32_t* I, size_t indexCount, Encoded& out) {
+    out.vertexCount = n;
+    out.bounds = bounds(V, n);
+    out.positions.resize(n * 3);
+    quantizePositions(V, n, out.bounds, out.positions.data());
+    out.normals.resize(N ? n * 2 : 0);
+    if (N) octEncode(N, n, out.normals.data());
+    encodeIndices(I, indexCount, out.indices);
+  }
+
+  // GPU-ready buffers restored from a mesh cache.
+  struct Decoded {
+    std::vector<float> positions;
+    std::vector<float> normals;
+    IndexStream indices;
+  };
+
+  // Decodes the Position, Normal and Index streams of `cache` into float
+  // positions and normals and indices of the narrowest width. Streams that
+  // are already stored in that form are copied. Other streams, such as
+  // Unorm8 colors, are uploaded from the cache as they are.
+  inline bool decode(const MeshCache& cache, Decoded& out, ThreadPool& pool = ThreadPool::shared()) {
+    using namespace meshcache;
+    auto position = cache.find(Position);
+    auto normal = cache.find(Normal);
+    auto index = cache.find(Index);
+    if (!position || !index) return false;
+    uint64_t n = cache.header->vertexCount;
+    if (position->size / position->stride < n || (normal && normal->size / normal->stride < n)) return false;
+
+    out.positions.resize(n * 3);
+    if (position->format == Unorm16 && (position->components == 3 || position->components == 4)) {
+      Bounds b;
+      std::memcpy(b.v, cache.header->boundsMin, sizeof(float) * 3);
+      std::memcpy(b.v + 3, cache.header->boundsMax, sizeof(float) * 3);
+      dequantizePositions(static_cast<const uint16_t*>(cache.data(*position)), n, b, out.positions.data(),
+        position->components, pool);
+    }
+    else if (position->format == Float32 && position->components == 3)
+      std::memcpy(out.positions.data(), cache.data(*position), n * 12);
+    else return false;
+
+    out.normals.clear();
+    if (normal) {
+      out.normals.resize(n * 3);
+      if (normal->format == Snorm16 && normal->components == 2)
+        octDecode(static_cast<const int16_t*>(cache.data(*normal)), n, out.normals.data(), pool);
+      else if (normal->format == Float32 && normal->components == 3)
+        std::memcpy(out.normals.data(), cache.data(*normal), n * 12);
+      else return false;
+    }
+
+    auto data = static_cast<const uint8_t*>(cache.data(*index));
+    out.indices.resize(cache.header->indexCount, n);
+    if (index->format == DeltaVarint)
+      return out.indices.isWide() ?
+        decodeIndices(data, index->size, out.indices.size(), n, out.indices.wide.data(), pool) :
+        decodeIndices(data, index->size, out.indices.size(), n, out.indices.narrow.data(), pool);
+    if (index->format != (out.indices.isWide() ? Uint32 : Uint16) || index->size != out.indices.bytes()) return false;
+    if (out.indices.isWide()) std::memcpy(out.indices.wide.data(), data, index->size);
+    else std::memcpy(out.indices.narrow.data(), data, index->size);
+    return true;
+  }
+}
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "parallel.hpp"
+#include "simd.hpp"
+
+// Statistics of the vertex streams of a mesh: the range and mean of every
+// component of the positions and of any other float attributes, gathered in
+// one pass over fixed chunks of vertices, and a bounding sphere of the
+// positions (Ritter 1990).
+//
+// A stream of c components is read simd::width vertices, c registers, at a
+// time; lane j of register r then always holds component (r * width + j) % c,
+// so per-lane minimums, maximums and sums fold into components at the end.
+// Sums are carried in float over short runs and in double across them.
+// Chunks are merged in order, so the result does not depend on the thread
+// count.
+namespace meshstats {
+  constexpr size_t chunkVertices = 1 << 16;
+  constexpr size_t maxComponents = 4;
+  // vertices summed in float before the sums move to double
+  constexpr size_t run = 1024;
+
+  // A vertex stream: `components` floats per vertex, at most maxComponents.
+  struct Stream {
+    const float* data;
+    uint32_t components;
+  };
+
+  // Per-component minimum, maximum and mean of a stream; unused components
+  // are zero.
+  struct Range {
+    float min[maxComponents] = {};
+    float max[maxComponents] = {};
+    float mean[maxComponents] = {};
+  };
+
+  struct Sphere {
+    float center[3] = {};
+    float radius = 0;
+  };
+
+  // A stream over one chunk.
+  struct Partial {
+    float min[maxComponents], max[maxComponents];
+    double sum[maxComponents];
+  };
+
+  // Scans vertices [begin, end) of a stream.
+  inline Partial scan(const Stream& stream, size_t begin, size_t end) {
+    using simd::Float, simd::splat;
+    constexpr size_t width = simd::width;
+    constexpr float inf = std::numeric_limits<float>::infinity();
+    uint32_t c = stream.components;
+    const float* p = stream.data + begin * c;
+    size_t floats = (end - begin) * c, block = c * width, blocks = floats / block;
+
+    Float lo[maxComponents], hi[maxComponents];
+    double sums[maxComponents][width] = {};
+    for (uint32_t r = 0; r < c; r++) lo[r] = splat(inf), hi[r] = splat(-inf);
+    for (size_t b = 0; b < blocks;) {
+      Float s[maxComponents];
+      for (uint32_t r = 0; r < c; r++) s[r] = splat(0);
+      for (size_t stop = std::min(blocks, b + run / width); b < stop; b++)
+        for (uint32_t r = 0; r < c; r++) {
+          Float x = simd::load(p + b * block + r * width);
+          lo[r] = simd::min(lo[r], x), hi[r] = simd::max(hi[r], x), s[r] = s[r] + x;
+        }
+      alignas(16) float lanes[width];
+      for (uint32_t r = 0; r < c; r++) {
+        simd::store(lanes, s[r]);
+        for (size_t j = 0; j < width; j++) sums[r][j] += lanes[j];
+      }
+    }
+
+    Partial out;
+    for (uint32_t k = 0; k < maxComponents; k++) out.min[k] = inf, out.max[k] = -inf, out.sum[k] = 0;
+    alignas(16) float lows[width], highs[width];
+    for (uint32_t r = 0; r < c; r++) {
+      simd::store(lows, lo[r]), simd::store(highs, hi[r]);
+      for (size_t j = 0; j < width; j++) {
+        uint32_t k = (r * width + j) % c;
+        out.min[k] = std::min(out.min[k], lows[j]), out.max[k] = std::max(out.max[k], highs[j]);
+        out.sum[k] += sums[r][j];
+      }
+    }
+    for (size_t i = blocks * block; i < floats; i++) {
+      uint32_t k = i % c;
+      out.min[k] = std::min(out.min[k], p[i]), out.max[k] = std::max(out.max[k], p[i]);
+      out.sum[k] += p[i];
+    }
+    return out;
+  }
+
+  // Grows s to take in the point p.
+  inline void grow(Sphere& s, const float* p) {
+    double d[3], d2 = 0;
+    for (int k = 0; k < 3; k++) d[k] = double(p[k]) - s.center[k], d2 += d[k] * d[k];
+    if (d2 <= double(s.radius) * s.radius) return;
+    double distance = std::sqrt(d2), radius = (s.radius + distance) / 2;
+    for (int k = 0; k < 3; k++) s.center[k] = float(s.center[k] + d[k] * (radius - s.radius) / distance);
+    // rounded up so that p stays inside
+    s.radius = std::nextafter(float(radius), std::numeric_limits<float>::infinity());
+  }
+
+  // Smallest sphere around the spheres a and b.
+  inline Sphere merge(const Sphere& a, const Sphere& b) {
+    double d[3], d2 = 0;
+    for (int k = 0; k < 3; k++) d[k] = double(b.center[k]) - a.center[k], d2 += d[k] * d[k];
+    double distance = std::sqrt(d2);
+    if (distance + b.radius <= a.radius) return a;
+    if (distance + a.radius <= b.radius) return b;
+    double radius = (distance + a.radius + b.radius) / 2;
+    Sphere s;
+    for (int k = 0; k < 3; k++) s.center[k] = float(a.center[k] + d[k] * (radius - a.radius) / distance);
+    s.radius = std::nextafter(float(radius), std::numeric_limits<float>::infinity());
+    return s;
+  }
+}
+
+struct MeshStats {
+  uint64_t vertexCount = 0;
+  // the box and the centroid of the positions
+  meshstats::Range positions;
+  meshstats::Sphere sphere;
+  // one per attribute stream passed to computeMeshStats
+  std::vector<meshstats::Range> attributes;
+
+  // Follows the positions through p -> (p - offset) / scale, computed in the
+  // same float operations, so the box stays exact.
+  void normalize(const float* offset, float scale) {
+    for (int k = 0; k < 3; k++) {
+      positions.min[k] = (positions.min[k] - offset[k]) / scale;
+      positions.max[k] = (positions.max[k] - offset[k]) / scale;
+      positions.mean[k] = (positions.mean[k] - offset[k]) / scale;
+      sphere.center[k] = (sphere.center[k] - offset[k]) / scale;
+    }
+    sphere.radius = std::nextafter(sphere.radius / scale, std::numeric_limits<float>::infinity());
+  }
+};
+
+// Computes the statistics of the positions V (xyz triples) and of the
+// `attributes`, which have as many vertices as V.
+//
+// The sphere starts as Ritter's, across the two vertices at the ends of the
+// widest axis of the box; every chunk grows a copy of it to take in its
+// vertices and the chunk spheres are merged.
+inline MeshStats computeMeshStats(const std::vector<float>& V, const std::vector<meshstats::Stream>& attributes = {},
+  ThreadPool& pool = ThreadPool::shared()) {
+  using namespace meshstats;
+  MeshStats stats;
+  size_t n = V.size() / 3, chunks = (n + chunkVertices - 1) / chunkVertices;
+  stats.vertexCount = n;
+  stats.attributes.resize(attributes.size());
+  if (n == 0) return stats;
+
+  std::vector<Stream> streams{ { V.data(), 3 } };
+  streams.insert(streams.end(), attributes.begin(), attributes.end());
+  std::vector<Partial> partials(chunks * streams.size());
+  parallelFor(n, chunkVertices, [&](size_t begin, size_t end) {
+    for (size_t s = 0; s < streams.size(); s++) partials[begin / chunkVertices * streams.size() + s] = scan(streams[s], begin, end);
+  }, pool);
+  for (size_t s = 0; s < streams.size(); s++) {
+    Range& range = s == 0 ? stats.positions : stats.attributes[s - 1];
+    Partial total = partials[s];
+    for (size_t c = 1; c < chunks; c++)
+      for (uint32_t k = 0; k < streams[s].components; k++) {
+        const Partial& part = partials[c * streams.size() + s];
+        total.min[k] = std::min(total.min[k], part.min[k]), total.max[k] = std::max(total.max[k], part.max[k]);
+        total.sum[k] += part.sum[k];
+      }
+    for (uint32_t k = 0; k < streams[s].components; k++)
+      range.min[k] = total.min[k], range.max[k] = total.max[k], range.mean[k] = float(total.sum[k] / n);
+  }
+
+  // the first vertices on the two sides of the widest axis
+  const Range& box = stats.positions;
+  int axis = 0;
+  for (int k = 1; k < 3; k++)
+    if (box.max[k] - box.min[k] > box.max[axis] - box.min[axis]) axis = k;
+  std::vector<size_t> lows(chunks, n), highs(chunks, n);
+  parallelFor(n, chunkVertices, [&](size_t begin, size_t end) {
+    size_t c = begin / chunkVertices;
+    for (size_t v = begin; v < end && (lows[c] == n || highs[c] == n); v++) {
+      if (lows[c] == n && V[v * 3 + axis] == box.min[axis]) lows[c] = v;
+      if (highs[c] == n && V[v * 3 + axis] == box.max[axis]) highs[c] = v;
+    }
+  }, pool);
+  const float* low = &V[*std::min_element(lows.begin(), lows.end()) * 3];
+  const float* high = &V[*std::min_element(highs.begin(), highs.end()) * 3];
+  Sphere initial;
+  double d2 = 0;
+  for (int k = 0; k < 3; k++) {
+    initial.center[k] = (low[k] + high[k]) / 2;
+    d2 += (double(high[k]) - low[k]) * (double(high[k]) - low[k]);
+  }
+  initial.radius = float(std::sqrt(d2) / 2);
+  grow(initial, low), grow(initial, high);
+
+  std::vector<Sphere> spheres(chunks, initial);
+  parallelFor(n, chunkVertices, [&](size_t begin, size_t end) {
+    Sphere& s = spheres[begin / chunkVertices];
+    for (size_t v = begin; v < end; v++) grow(s, &V[v * 3]);
+  }, pool);
+  stats.sphere = spheres[0];
+  for (size_t c = 1; c < chunks; c++) stats.sphere = merge(stats.sphere, spheres[c]);
+  return stats;
+}
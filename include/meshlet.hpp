@@ -0,0 +1,231 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "hash.hpp"
+#include "parallel.hpp"
+
+// Meshlets: small clusters of triangles with their own vertex list and 8-bit
+// local indices, plus a bounding sphere and a normal cone for culling whole
+// clusters. Triangles are taken greedily in index buffer order, so the list
+// should be optimized for the vertex cache first. The triangle list is split
+// into fixed chunks that are built in parallel and meshlets never cross a
+// chunk, so the result does not depend on the thread count.
+namespace meshlet {
+  constexpr size_t chunkTriangles = 1 << 16;
+
+  struct Meshlet {
+    uint32_t vertexOffset;   // into Meshlets::vertices
+    uint32_t triangleOffset; // into Meshlets::triangles, in triangles
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+  };
+
+  struct Bounds {
+    float center[3];
+    float radius;
+    // every triangle faces away from viewers in the cone from the apex
+    // around -axis: dot(normalize(apex - eye), axis) >= cutoff. A cutoff
+    // of 1 never culls.
+    float apex[3];
+    float axis[3];
+    float cutoff;
+
+    bool backfacing(const float* eye) const {
+      float d[3] = { apex[0] - eye[0], apex[1] - eye[1], apex[2] - eye[2] };
+      float length = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+      return cutoff < 1 && d[0] * axis[0] + d[1] * axis[1] + d[2] * axis[2] >= cutoff * length;
+    }
+  };
+
+  struct Statistics {
+    size_t meshlets = 0;
+    double vertexFill = 0;     // mean vertices per meshlet over the limit
+    double triangleFill = 0;   // mean triangles per meshlet over the limit
+    double duplication = 0;    // meshlet vertices per referenced mesh vertex
+    size_t bytes = 0;          // table, vertex lists and local indices
+  };
+
+  struct Meshlets {
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> vertices;
+    std::vector<uint8_t> triangles; // 3 local indices per triangle
+    std::vector<Bounds> bounds;
+    unsigned maxVertices = 0, maxTriangles = 0;
+
+    Statistics statistics(size_t referencedVertices) const {
+      Statistics stats;
+      stats.meshlets = meshlets.size();
+      if (meshlets.empty()) return stats;
+      stats.vertexFill = double(vertices.size()) / (meshlets.size() * maxVertices);
+      stats.triangleFill = double(triangles.size() / 3) / (meshlets.size() * maxTriangles);
+      stats.duplication = referencedVertices ? double(vertices.size()) / referencedVertices : 0;
+      stats.bytes = meshlets.size() * sizeof(Meshlet) + vertices.size() * 4 + triangles.size();
+      return stats;
+    }
+  };
+
+  // Meshlets of one chunk, with offsets local to it.
+  struct Part {
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> vertices;
+    std::vector<uint8_t> triangles;
+  };
+
+  // Greedy scan over triangles [begin, end) of I.
+  template <typename Index>
+  inline void scan(const Index* I, size_t begin, size_t end, unsigned maxVertices, unsigned maxTriangles, Part& part) {
+    // vertex -> local index, for the current meshlet only: slots are valid
+    // while their stamp matches
+    constexpr uint32_t slots = 512;
+    uint32_t key[slots], stamp[slots] = {}, current = 1;
+    uint8_t local[slots];
+    auto find = [&](uint32_t v) {
+      uint32_t h = uint32_t(hashMix(v)) & (slots - 1);
+      while (stamp[h] == current && key[h] != v) h = (h + 1) & (slots - 1);
+      return h;
+    };
+
+    Meshlet m{ 0, 0, 0, 0 };
+    auto flush = [&] {
+      if (m.triangleCount) part.meshlets.push_back(m);
+      m = { uint32_t(part.vertices.size()), uint32_t(part.triangles.size() / 3), 0, 0 };
+      current++;
+    };
+
+    for (size_t t = begin; t < end; t++) {
+      const Index* f = &I[t * 3];
+      unsigned added = 0;
+      for (int k = 0; k < 3; k++)
+        added += stamp[find(f[k])] != current && (k == 0 || f[k] != f[0]) && (k < 2 || f[2] != f[1]);
+      if (m.vertexCount + added > maxVertices || m.triangleCount + 1 > maxTriangles) flush();
+
+      for (int k = 0; k < 3; k++) {
+        uint32_t h = find(f[k]);
+        if (stamp[h] != current) {
+          stamp[h] = current, key[h] = f[k], local[h] = uint8_t(m.vertexCount++);
+          part.vertices.push_back(f[k]);
+        }
+        part.triangles.push_back(local[h]);
+      }
+      m.triangleCount++;
+    }
+    flush();
+  }
+
+  // Sphere around the box of the meshlet and the cone of its triangle
+  // normals, as in meshoptimizer's computeMeshletBounds.
+  template <typename Scalar>
+  inline Bounds bounds(const Scalar* V, const uint32_t* vertices, const uint8_t* triangles, const Meshlet& m) {
+    Bounds b{};
+    float lo[3], hi[3];
+    for (int k = 0; k < 3; k++) lo[k] = hi[k] = float(V[size_t(vertices[0]) * 3 + k]);
+    for (uint32_t i = 1; i < m.vertexCount; i++)
+      for (int k = 0; k < 3; k++) {
+        float x = float(V[size_t(vertices[i]) * 3 + k]);
+        lo[k] = std::min(lo[k], x), hi[k] = std::max(hi[k], x);
+      }
+    for (int k = 0; k < 3; k++) b.center[k] = (lo[k] + hi[k]) * .5f;
+    float r2 = 0;
+    for (uint32_t i = 0; i < m.vertexCount; i++) {
+      float d2 = 0;
+      for (int k = 0; k < 3; k++) {
+        float d = float(V[size_t(vertices[i]) * 3 + k]) - b.center[k];
+        d2 += d * d;
+      }
+      r2 = std::max(r2, d2);
+    }
+    b.radius = std::sqrt(r2);
+
+    // unit normal and first corner of triangle t, false when degenerate
+    auto normal = [&](uint32_t t, float* n, float* corner) {
+      const Scalar* p[3];
+      for (int k = 0; k < 3; k++) p[k] = &V[size_t(vertices[triangles[t * 3 + k]]) * 3];
+      float e1[3], e2[3];
+      for (int k = 0; k < 3; k++) e1[k] = float(p[1][k] - p[0][k]), e2[k] = float(p[2][k] - p[0][k]), corner[k] = float(p[0][k]);
+      n[0] = e1[1] * e2[2] - e1[2] * e2[1], n[1] = e1[2] * e2[0] - e1[0] * e2[2], n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+      float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      for (int k = 0; k < 3; k++) n[k] = length > 0 ? n[k] / length : 0;
+      return length > 0;
+    };
+
+    float axis[3] = { 0, 0, 0 }, n[3], c[3];
+    for (uint32_t t = 0; t < m.triangleCount; t++)
+      if (normal(t, n, c))
+        for (int k = 0; k < 3; k++) axis[k] += n[k];
+    std::copy_n(b.center, 3, b.apex);
+    b.cutoff = 1;
+    float length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    if (length == 0) return b;
+    for (int k = 0; k < 3; k++) b.axis[k] = axis[k] / length;
+
+    float minDot = 1;
+    for (uint32_t t = 0; t < m.triangleCount; t++)
+      if (normal(t, n, c)) minDot = std::min(minDot, n[0] * b.axis[0] + n[1] * b.axis[1] + n[2] * b.axis[2]);
+    // cones wider than about 84 degrees cull too little to be worth a test
+    if (minDot <= .1f) return b;
+
+    // move the apex back along the axis until it is behind every triangle
+    float maxT = 0;
+    for (uint32_t t = 0; t < m.triangleCount; t++) {
+      if (!normal(t, n, c)) continue;
+      float dc = (b.center[0] - c[0]) * n[0] + (b.center[1] - c[1]) * n[1] + (b.center[2] - c[2]) * n[2];
+      float dn = b.axis[0] * n[0] + b.axis[1] * n[1] + b.axis[2] * n[2];
+      maxT = std::max(maxT, dc / dn);
+    }
+    for (int k = 0; k < 3; k++) b.apex[k] = b.center[k] - b.axis[k] * maxT;
+    b.cutoff = std::sqrt(1 - minDot * minDot);
+    return b;
+  }
+}
+
+// Splits the triangle list F over the positions V (xyz triples) into
+// meshlets of at most `maxVertices` (up to 256) vertices and `maxTriangles`
+// triangles, with their bounds.
+template <typename Scalar, typename Index>
+inline void buildMeshlets(const std::vector<Scalar>& V, const std::vector<Index>& F, meshlet::Meshlets& out,
+  unsigned maxVertices = 64, unsigned maxTriangles = 124, ThreadPool& pool = ThreadPool::shared()) {
+  maxVertices = std::clamp(maxVertices, 3u, 256u);
+  maxTriangles = std::max(maxTriangles, 1u);
+  out.maxVertices = maxVertices, out.maxTriangles = maxTriangles;
+
+  size_t triangles = F.size() / 3, chunks = (triangles + meshlet::chunkTriangles - 1) / meshlet::chunkTriangles;
+  std::vector<meshlet::Part> parts(chunks);
+  parallelFor(triangles, meshlet::chunkTriangles, [&](size_t begin, size_t end) {
+    meshlet::scan(F.data(), begin, end, maxVertices, maxTriangles, parts[begin / meshlet::chunkTriangles]);
+  }, pool);
+
+  // concatenate the parts, shifting their offsets
+  std::vector<size_t> meshletStart(chunks + 1, 0), vertexStart(chunks + 1, 0), triangleStart(chunks + 1, 0);
+  for (size_t c = 0; c < chunks; c++) {
+    meshletStart[c + 1] = meshletStart[c] + parts[c].meshlets.size();
+    vertexStart[c + 1] = vertexStart[c] + parts[c].vertices.size();
+    triangleStart[c + 1] = triangleStart[c] + parts[c].triangles.size();
+  }
+  out.meshlets.resize(meshletStart[chunks]);
+  out.vertices.resize(vertexStart[chunks]);
+  out.triangles.resize(triangleStart[chunks]);
+  out.bounds.resize(meshletStart[chunks]);
+  pool.run(chunks, [&](size_t c, unsigned) {
+    meshlet::Part& part = parts[c];
+    for (size_t i = 0; i < part.meshlets.size(); i++) {
+      meshlet::Meshlet m = part.meshlets[i];
+      m.vertexOffset += uint32_t(vertexStart[c]);
+      m.triangleOffset += uint32_t(triangleStart[c] / 3);
+      out.meshlets[meshletStart[c] + i] = m;
+    }
+    std::copy(part.vertices.begin(), part.vertices.end(), out.vertices.begin() + vertexStart[c]);
+    std::copy(part.triangles.begin(), part.triangles.end(), out.triangles.begin() + triangleStart[c]);
+    part = {};
+  });
+
+  parallelFor(out.meshlets.size(), 1024, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      const meshlet::Meshlet& m = out.meshlets[i];
+      out.bounds[i] = meshlet::bounds(V.data(), &out.vertices[m.vertexOffset], &out.triangles[size_t(m.triangleOffset) * 3], m);
+    }
+  }, pool);
+}
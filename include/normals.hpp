@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "parallel.hpp"
+
+// Smooth vertex normals: the normals of the triangles around each vertex,
+// weighted by triangle area or by the angle of the triangle at the vertex,
+// summed and normalized.
+//
+// Per-corner values are summed into the vertices without atomics: the
+// triangle list is cut into fixed chunks summed in parallel. Every block of
+// vertices used by a single chunk belongs to it and is summed in place;
+// blocks used by several chunks are summed by each in a buffer of its own
+// and merged in chunk order afterwards. No two threads write the same vertex
+// and the result does not depend on the thread count. Index buffers in
+// vertex fetch order share few blocks between chunks. When most blocks are
+// shared, as with vertices numbered at random, the list is cut into a few
+// stripes instead, each summed into a copy of the blocks it uses.
+namespace normals {
+  constexpr size_t chunkTriangles = 1 << 16;
+  constexpr size_t blockShift = 10;
+  // stripes of a list whose chunks share most blocks, each up to a copy of
+  // the sums
+  constexpr size_t stripes = 4;
+  // owners of blocks no chunk uses and of blocks used by several
+  constexpr uint32_t unused = std::numeric_limits<uint32_t>::max(), shared = unused - 1;
+
+  enum Weighting { Area, Angle };
+
+  // Blocks a chunk uses, first to last, and those of them it shares with
+  // other chunks, in order, with their sums.
+  struct Chunk {
+    uint32_t first = 0, last = 0;
+    std::vector<uint32_t> shared;
+    std::vector<float> sums;
+  };
+
+  // Sums `components` floats per corner of the triangle list F into `sums`,
+  // which gets 1 << shift slots of `components` floats per vertex (shift
+  // below blockShift). values(t, out, slot) is called for every triangle t,
+  // in order within a chunk, and fills out[i * components] and the slot of
+  // vertex F[t * 3 + i] for every corner i.
+  template <size_t components, typename Index, typename Values>
+  inline void sumCorners(const Index* F, size_t triangles, size_t n, unsigned shift, std::vector<float>& sums,
+    Values&& values, ThreadPool& pool = ThreadPool::shared()) {
+    constexpr size_t blockSize = size_t(1) << blockShift;
+    size_t slots = n << shift, blocks = (slots + blockSize - 1) / blockSize;
+    sums.assign(slots * components, 0.f);
+    if (triangles == 0) return;
+
+    // blocks used by every chunk, then the owner of every block; false when
+    // most blocks are shared
+    size_t chunk = 0, chunks = 0;
+    std::vector<Chunk> parts;
+    std::vector<uint32_t> owner;
+    auto divide = [&](size_t size) {
+      chunk = size, chunks = (triangles + chunk - 1) / chunk;
+      parts.assign(chunks, {});
+      parallelFor(triangles, chunk, [&](size_t begin, size_t end) {
+        Chunk& part = parts[begin / chunk];
+        std::vector<uint8_t> seen(blocks, 0);
+        uint32_t previous = unused;
+        for (size_t i = begin * 3; i < end * 3; i++) {
+          uint32_t b = uint32_t((size_t(F[i]) << shift) >> blockShift);
+          if (b == previous) continue;
+          previous = b;
+          if (!seen[b]) seen[b] = 1, part.shared.push_back(b);
+        }
+        std::sort(part.shared.begin(), part.shared.end());
+        part.first = part.shared.front(), part.last = part.shared.back();
+      }, pool);
+      owner.assign(blocks, unused);
+      for (size_t c = 0; c < chunks; c++)
+        for (uint32_t b : parts[c].shared) owner[b] = owner[b] == unused ? uint32_t(c) : shared;
+      size_t sharedBlocks = 0;
+      for (auto& part : parts) {
+        std::erase_if(part.shared, [&](uint32_t b) { return owner[b] != shared; });
+        sharedBlocks += part.shared.size();
+      }
+      return sharedBlocks <= blocks / 2;
+    };
+    if (!divide(chunkTriangles) && triangles > chunkTriangles)
+      divide((triangles + stripes - 1) / stripes);
+
+    parallelFor(triangles, chunk, [&](size_t begin, size_t end) {
+      uint32_t c = uint32_t(begin / chunk);
+      Chunk& part = parts[c];
+      // where every block the chunk uses is summed
+      part.sums.assign(part.shared.size() * blockSize * components, 0.f);
+      std::vector<float*> base(part.last - part.first + 1, nullptr);
+      for (size_t b = part.first; b <= part.last; b++)
+        if (owner[b] == c) base[b - part.first] = &sums[b * blockSize * components];
+      for (size_t i = 0; i < part.shared.size(); i++)
+        base[part.shared[i] - part.first] = &part.sums[i * blockSize * components];
+
+      float out[3 * components];
+      uint32_t slot[3];
+      for (size_t t = begin; t < end; t++) {
+        values(t, out, slot);
+        for (size_t i = 0; i < 3; i++) {
+          size_t s = (size_t(F[t * 3 + i]) << shift) + slot[i];
+          float* a = base[(s >> blockShift) - part.first] + (s & (blockSize - 1)) * components;
+          for (size_t k = 0; k < components; k++) a[k] += out[i * components + k];
+        }
+      }
+    }, pool);
+
+    // the shared blocks, merged in chunk order
+    parallelFor(blocks, 64, [&](size_t begin, size_t end) {
+      for (auto& part : parts)
+        for (size_t i = 0; i < part.shared.size(); i++) {
+          size_t b = part.shared[i];
+          if (b < begin || b >= end) continue;
+          const float* from = &part.sums[i * blockSize * components];
+          float* to = &sums[b * blockSize * components];
+          size_t count = (std::min((b + 1) * blockSize, slots) - b * blockSize) * components;
+          for (size_t j = 0; j < count; j++) to[j] += from[j];
+        }
+    }, pool);
+  }
+
+  // acos of x in [-1, 1] to within 7e-5 (Abramowitz and Stegun 4.4.45).
+  inline float acos(float x) {
+    float a = std::abs(x);
+    float r = std::sqrt(1 - a) * (((-.0187293f * a + .0742610f) * a - .2121144f) * a + 1.5707288f);
+    return x < 0 ? float(M_PI) - r : r;
+  }
+
+  // Weighted normal of every corner of the triangle f, as xyz in `out`: the
+  // cross product of two edges for Area, the unit normal times the angle at
+  // the corner for Angle.
+  template <typename Scalar, typename Index>
+  inline void corners(const Scalar* V, const Index* f, Weighting weighting, float* out) {
+    float p[3][3];
+    for (int c = 0; c < 3; c++)
+      for (int k = 0; k < 3; k++) p[c][k] = float(V[size_t(f[c]) * 3 + k]);
+    float e1[3], e2[3];
+    for (int k = 0; k < 3; k++) e1[k] = p[1][k] - p[0][k], e2[k] = p[2][k] - p[0][k];
+    float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+    if (weighting == Area) {
+      for (int c = 0; c < 3; c++) out[c * 3] = n[0], out[c * 3 + 1] = n[1], out[c * 3 + 2] = n[2];
+      return;
+    }
+
+    // the angles at the first two corners, and what is left of pi
+    auto dot = [](const float* a, const float* b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; };
+    float e3[3];
+    for (int k = 0; k < 3; k++) e3[k] = p[2][k] - p[1][k];
+    float l1 = dot(e1, e1), l2 = dot(e2, e2), l3 = dot(e3, e3), length = std::sqrt(dot(n, n));
+    float angles[3] = { 0, 0, 0 };
+    if (length > 0) {
+      angles[0] = acos(std::clamp(dot(e1, e2) / std::sqrt(l1 * l2), -1.f, 1.f));
+      angles[1] = acos(std::clamp(-dot(e1, e3) / std::sqrt(l1 * l3), -1.f, 1.f));
+      angles[2] = std::max(float(M_PI) - angles[0] - angles[1], 0.f);
+    }
+    for (int c = 0; c < 3; c++)
+      for (int k = 0; k < 3; k++) out[c * 3 + k] = length > 0 ? n[k] / length * angles[c] : 0;
+  }
+
+  // Scales the sums of vertices [begin, end) of N (xyz) to unit length,
+  // leaving zero sums zero.
+  inline void normalize(float* N, size_t begin, size_t end) {
+    for (size_t v = begin; v < end; v++) {
+      float* a = &N[v * 3];
+      float length = std::sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+      for (int k = 0; k < 3; k++) a[k] = length > 0 ? a[k] / length : 0;
+    }
+  }
+}
+
+// Computes unit normals N (xyz triples of floats, ready for a Float32x3
+// vertex buffer) for the positions V (xyz triples) of the triangle list F.
+// Vertices that no triangle with area uses get a zero normal.
+template <typename Scalar, typename Index>
+inline void computeNormals(const std::vector<Scalar>& V, const std::vector<Index>& F, std::vector<float>& N,
+  normals::Weighting weighting = normals::Angle, ThreadPool& pool = ThreadPool::shared()) {
+  size_t n = V.size() / 3;
+  normals::sumCorners<3>(F.data(), F.size() / 3, n, 0, N, [&](size_t t, float* out, uint32_t* slot) {
+    normals::corners(V.data(), &F[t * 3], weighting, out);
+    slot[0] = slot[1] = slot[2] = 0;
+  }, pool);
+
+  parallelFor(n, 1 << 16, [&](size_t begin, size_t end) { normals::normalize(N.data(), begin, end); }, pool);
+}
+
+// The same normals summed on the calling thread, in triangle order. It skips
+// the pass that splits the list between chunks, so it is the faster of the
+// two on a single core; the sums may differ from computeNormals in the last
+// bits.
+template <typename Scalar, typename Index>
+inline void computeNormalsSerial(const std::vector<Scalar>& V, const std::vector<Index>& F, std::vector<float>& N,
+  normals::Weighting weighting = normals::Angle) {
+  size_t n = V.size() / 3;
+  N.assign(n * 3, 0.f);
+  float out[9];
+  for (size_t t = 0; t < F.size() / 3; t++) {
+    normals::corners(V.data(), &F[t * 3], weighting, out);
+    for (int c = 0; c < 3; c++)
+      for (int k = 0; k < 3; k++) N[size_t(F[t * 3 + c]) * 3 + k] += out[c * 3 + k];
+  }
+  normals::normalize(N.data(), 0, n);
+}
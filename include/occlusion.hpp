@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "bvh.hpp"
+#include "hash.hpp"
+#include "mesh_cache.hpp"
+#include "parallel.hpp"
+
+// Ambient occlusion per vertex: the share of `rays` directions over the
+// hemisphere around the normal that leave the surface without meeting a
+// triangle within `distance`, from 0 when closed in to 1 when open.
+//
+// Directions are cosine weighted, a Fibonacci spiral over the disk lifted to
+// the hemisphere, so the share weighs them as diffuse light would. Every
+// vertex turns the spiral by an angle hashed from its index, which trades
+// banding between neighbours for noise. Vertices are baked in parallel over
+// fixed chunks with any-hit queries against a bvh::Tree; nothing depends on
+// the thread count.
+//
+// A bake can be kept in a file of its own, a mesh cache holding only an
+// Occlusion stream with the key of the geometry and settings it was baked
+// from as its source hash. A mesh whose cache is rebuilt with the same
+// geometry then reads the bake back instead of casting the rays again.
+namespace occlusion {
+  constexpr size_t chunkVertices = 256;
+  // the golden angle, in radians
+  constexpr float turn = 2.39996323f;
+
+  // Key of a bake of the positions V, normals N and triangle list F with
+  // these settings.
+  template <typename Scalar, typename Index>
+  inline uint64_t key(const std::vector<Scalar>& V, const std::vector<float>& N, const std::vector<Index>& F,
+    uint32_t rays, float distance) {
+    uint32_t bits;
+    std::memcpy(&bits, &distance, sizeof(bits));
+    uint64_t h = hashMix(uint64_t(rays) << 32 | bits);
+    h = hash64(V.data(), V.size() * sizeof(Scalar), h);
+    h = hash64(N.data(), N.size() * sizeof(float), h);
+    return hash64(F.data(), F.size() * sizeof(Index), h);
+  }
+
+  // Reads the bake stored in `path` under `key` into AO; false when the file
+  // is missing or holds another bake.
+  inline bool read(const std::string& path, uint64_t key, std::vector<float>& AO) {
+    MeshCache cache;
+    if (!cache.open(path) || cache.header->source.hash != key) return false;
+    auto stream = cache.find(meshcache::Occlusion);
+    if (!stream || stream->format != meshcache::Float32 || stream->components != 1) return false;
+    auto first = static_cast<const float*>(cache.data(*stream));
+    AO.assign(first, first + stream->size / sizeof(float));
+    return true;
+  }
+
+  inline bool write(const std::string& path, uint64_t key, const std::vector<float>& AO) {
+    meshcache::Source source;
+    source.hash = key;
+    return meshcache::write(path, source, {
+      {.semantic = meshcache::Occlusion, .format = meshcache::Float32, .components = 1, .data = AO.data(), .count = AO.size() }
+      });
+  }
+}
+
+// Bakes the occlusion AO (one float per vertex) of the positions V (xyz
+// triples) with unit normals N, over the triangle list F that `tree` was
+// built for. Rays start a thousandth of `distance` off the surface; vertices
+// with a zero normal are open.
+template <typename Scalar, typename Index>
+inline void bakeOcclusion(const std::vector<Scalar>& V, const std::vector<float>& N, const std::vector<Index>& F,
+  const bvh::Tree& tree, std::vector<float>& AO, uint32_t rays = 64, float distance = .5f,
+  ThreadPool& pool = ThreadPool::shared()) {
+  size_t n = V.size() / 3;
+  AO.resize(n);
+  parallelFor(n, occlusion::chunkVertices, [&](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; v++) {
+      const float* normal = &N[v * 3];
+      if (normal[0] == 0 && normal[1] == 0 && normal[2] == 0) {
+        AO[v] = 1;
+        continue;
+      }
+      // a frame around the normal (Duff et al. 2017)
+      float sign = std::copysign(1.f, normal[2]), a = -1 / (sign + normal[2]), b = normal[0] * normal[1] * a;
+      float tangent[3] = { 1 + sign * normal[0] * normal[0] * a, sign * b, -sign * normal[0] };
+      float bitangent[3] = { b, sign + normal[1] * normal[1] * a, -normal[1] };
+
+      bvh::Ray ray;
+      ray.tmax = distance;
+      for (int k = 0; k < 3; k++) ray.origin[k] = float(V[v * 3 + k]) + normal[k] * distance * 1e-3f;
+      float offset = float(hashMix(v) >> 40) / float(1 << 24) * 2 * float(M_PI);
+      uint32_t open = 0;
+      for (uint32_t i = 0; i < rays; i++) {
+        float r = std::sqrt((i + .5f) / rays), phi = i * occlusion::turn + offset;
+        float x = r * std::cos(phi), y = r * std::sin(phi), z = std::sqrt(std::max(0.f, 1 - r * r));
+        for (int k = 0; k < 3; k++) ray.direction[k] = tangent[k] * x + bitangent[k] * y + normal[k] * z;
+        open += !bvh::occluded(tree, V.data(), F.data(), ray);
+      }
+      AO[v] = float(open) / rays;
+    }
+  }, pool);
+}
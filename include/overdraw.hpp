@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+#include "parallel.hpp"
+#include "vertex_cache.hpp"
+
+// Triangle order for less overdraw (Sander, Nehab and Barczak 2007): the
+// cache-optimized list is cut into clusters that each keep their vertex
+// reuse, and clusters facing out from the middle of the mesh, which are
+// likely to occlude the rest from any view, are drawn first.
+namespace overdraw {
+  struct Statistics {
+    uint64_t covered = 0; // pixels with at least one fragment
+    uint64_t shaded = 0;  // fragments passing the depth test when drawn
+    double overdraw = 0;  // shaded per covered pixel, 1 at best
+  };
+
+  // Depth-tested rasterization of the triangles into a square orthographic
+  // view along `axis`, from its positive side when `flip` is set and from
+  // the negative side otherwise. Triangles are front facing when
+  // counter-clockwise; back faces are dropped when `cull`. Counts are added
+  // to `stats`.
+  template <typename Scalar, typename Index>
+  inline void rasterize(const Scalar* V, const Index* I, size_t count, const float* lo, const float* hi,
+    int axis, bool flip, unsigned resolution, bool cull, Statistics& stats) {
+    int u = (axis + 1) % 3, v = (axis + 2) % 3;
+    float extent = std::max(hi[u] - lo[u], hi[v] - lo[v]), scale = extent > 0 ? resolution / extent : 0;
+    std::vector<float> depth(size_t(resolution) * resolution, std::numeric_limits<float>::infinity());
+
+    for (size_t t = 0; t + 2 < count; t += 3) {
+      float x[3], y[3], z[3];
+      for (int k = 0; k < 3; k++) {
+        const Scalar* p = &V[size_t(I[t + k]) * 3];
+        x[k] = (float(p[u]) - lo[u]) * scale;
+        y[k] = (float(p[v]) - lo[v]) * scale;
+        z[k] = flip ? hi[axis] - float(p[axis]) : float(p[axis]) - lo[axis];
+      }
+      // (u, v) is mirrored when seen from the negative side of the axis
+      float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+      bool front = flip ? area > 0 : area < 0;
+      if (area == 0 || (cull && !front)) continue;
+      if (area < 0) std::swap(x[1], x[2]), std::swap(y[1], y[2]), std::swap(z[1], z[2]), area = -area;
+
+      int x0 = std::max(0, int(std::floor(std::min({ x[0], x[1], x[2] }))));
+      int y0 = std::max(0, int(std::floor(std::min({ y[0], y[1], y[2] }))));
+      int x1 = std::min(int(resolution) - 1, int(std::ceil(std::max({ x[0], x[1], x[2] }))));
+      int y1 = std::min(int(resolution) - 1, int(std::ceil(std::max({ y[0], y[1], y[2] }))));
+      // a pixel center on an edge shared by two triangles belongs to the
+      // one that runs along it downwards, or leftwards when horizontal
+      auto owns = [](float w, float dx, float dy) { return w > 0 || (w == 0 && (dy < 0 || (dy == 0 && dx < 0))); };
+      for (int py = y0; py <= y1; py++)
+        for (int px = x0; px <= x1; px++) {
+          float cx = px + .5f, cy = py + .5f;
+          float w0 = (x[2] - x[1]) * (cy - y[1]) - (y[2] - y[1]) * (cx - x[1]);
+          float w1 = (x[0] - x[2]) * (cy - y[2]) - (y[0] - y[2]) * (cx - x[2]);
+          float w2 = area - w0 - w1;
+          if (!owns(w0, x[2] - x[1], y[2] - y[1]) || !owns(w1, x[0] - x[2], y[0] - y[2]) ||
+            !owns(w2, x[1] - x[0], y[1] - y[0])) continue;
+          float d = (w0 * z[0] + w1 * z[1] + w2 * z[2]) / area;
+          float& stored = depth[size_t(py) * resolution + px];
+          if (std::isinf(stored)) stats.covered++;
+          if (d <= stored) stored = d, stats.shaded++;
+        }
+    }
+  }
+
+  // Estimates overdraw from the six axis directions, one view per task.
+  template <typename Scalar, typename Index>
+  inline Statistics analyze(const Scalar* V, size_t vertexCount, const Index* I, size_t count,
+    unsigned resolution = 256, bool cull = true, ThreadPool& pool = ThreadPool::shared()) {
+    float lo[3] = { 0, 0, 0 }, hi[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < vertexCount; i++)
+      for (int k = 0; k < 3; k++) {
+        float x = float(V[i * 3 + k]);
+        lo[k] = i ? std::min(lo[k], x) : x;
+        hi[k] = i ? std::max(hi[k], x) : x;
+      }
+
+    Statistics views[6];
+    pool.run(6, [&](size_t view, unsigned) {
+      rasterize(V, I, count, lo, hi, int(view / 2), view % 2 == 1, resolution, cull, views[view]);
+    });
+    Statistics stats;
+    for (auto& view : views) stats.covered += view.covered, stats.shaded += view.shaded;
+    stats.overdraw = stats.covered ? double(stats.shaded) / stats.covered : 0;
+    return stats;
+  }
+
+  template <typename Scalar, typename Index>
+  inline Statistics analyze(const std::vector<Scalar>& V, const std::vector<Index>& I,
+    unsigned resolution = 256, bool cull = true, ThreadPool& pool = ThreadPool::shared()) {
+    return analyze(V.data(), V.size() / 3, I.data(), I.size(), resolution, cull, pool);
+  }
+
+  // Starts of the clusters of I, ending with the triangle count. Hard
+  // boundaries are where a triangle misses the cache on every corner, the
+  // start of a new patch in a cache-optimized list. Each patch is then cut
+  // as soon as its running ACMR, from an empty cache, is within `threshold`
+  // times the ACMR of the whole patch.
+  template <typename Index>
+  inline std::vector<uint32_t> clusters(const Index* I, size_t count, size_t vertexCount, float threshold, unsigned cacheSize) {
+    size_t triangles = count / 3;
+    std::vector<uint32_t> hard, result;
+    vcache::Fifo cache(vertexCount, cacheSize);
+    for (size_t t = 0; t < triangles; t++)
+      if (cache.misses(&I[t * 3]) == 3 || t == 0) hard.push_back(uint32_t(t));
+    hard.push_back(uint32_t(triangles));
+
+    for (size_t c = 0; c + 1 < hard.size(); c++) {
+      size_t begin = hard[c], end = hard[c + 1], misses = 0;
+      cache.flush();
+      for (size_t t = begin; t < end; t++) misses += cache.misses(&I[t * 3]);
+      float target = threshold * float(misses) / float(end - begin);
+
+      result.push_back(uint32_t(begin));
+      cache.flush();
+      size_t runningMisses = 0, runningTriangles = 0;
+      for (size_t t = begin; t < end; t++) {
+        runningMisses += cache.misses(&I[t * 3]);
+        runningTriangles++;
+        if (float(runningMisses) / float(runningTriangles) <= target) {
+          result.push_back(uint32_t(t + 1));
+          cache.flush();
+          runningMisses = runningTriangles = 0;
+        }
+      }
+      // a cut after the last triangle would leave an empty cluster
+      if (result.back() == end) result.pop_back();
+    }
+    result.push_back(uint32_t(triangles));
+    return result;
+  }
+}
+
+// Reorders the cache-optimized triangle list F over the positions V (xyz
+// triples) so that occluders tend to be drawn first, letting any cluster
+// lose at most `threshold` times its vertex cache efficiency.
+template <typename Scalar, typename Index>
+inline void optimizeOverdraw(std::vector<Index>& F, const std::vector<Scalar>& V, float threshold = 1.05f,
+  unsigned cacheSize = 16, ThreadPool& pool = ThreadPool::shared()) {
+  size_t triangles = F.size() / 3;
+  if (triangles == 0) return;
+  std::vector<uint32_t> starts = overdraw::clusters(F.data(), F.size(), V.size() / 3, threshold, cacheSize);
+  size_t clusterCount = starts.size() - 1;
+
+  // area-weighted centroids and summed normals of the clusters
+  std::vector<double> centroids(clusterCount * 3), normals(clusterCount * 3), areas(clusterCount);
+  parallelFor(clusterCount, 256, [&](size_t begin, size_t end) {
+    for (size_t c = begin; c < end; c++) {
+      double* centroid = &centroids[c * 3], * normal = &normals[c * 3];
+      for (size_t t = starts[c]; t < starts[c + 1]; t++) {
+        const Scalar* p[3] = { &V[size_t(F[t * 3]) * 3], &V[size_t(F[t * 3 + 1]) * 3], &V[size_t(F[t * 3 + 2]) * 3] };
+        double e1[3], e2[3];
+        for (int k = 0; k < 3; k++) e1[k] = double(p[1][k]) - p[0][k], e2[k] = double(p[2][k]) - p[0][k];
+        double n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+        double a = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        for (int k = 0; k < 3; k++) {
+          centroid[k] += (double(p[0][k]) + p[1][k] + p[2][k]) * a / 3;
+          normal[k] += n[k];
+        }
+        areas[c] += a;
+      }
+    }
+  }, pool);
+  double center[3] = { 0, 0, 0 }, area = 0;
+  for (size_t c = 0; c < clusterCount; c++) {
+    for (int k = 0; k < 3; k++) center[k] += centroids[c * 3 + k];
+    area += areas[c];
+  }
+  for (int k = 0; k < 3; k++) center[k] = area > 0 ? center[k] / area : 0;
+
+  // clusters far out along their own normal first
+  std::vector<double> key(clusterCount, 0.);
+  for (size_t c = 0; c < clusterCount; c++) {
+    const double* n = &normals[c * 3];
+    double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (areas[c] > 0 && length > 0)
+      for (int k = 0; k < 3; k++) key[c] += (centroids[c * 3 + k] / areas[c] - center[k]) * n[k] / length;
+  }
+  std::vector<uint32_t> order(clusterCount);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return key[a] > key[b]; });
+
+  std::vector<Index> reordered(F.size());
+  size_t written = 0;
+  for (uint32_t c : order) {
+    std::copy(&F[size_t(starts[c]) * 3], &F[size_t(starts[c + 1]) * 3], &reordered[written]);
+    written += size_t(starts[c + 1] - starts[c]) * 3;
+  }
+  F.swap(reordered);
+}
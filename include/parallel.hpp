@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Fixed set of worker threads running one data-parallel job at a time. The
+// calling thread takes part in the job, so a pool of size 1 has no workers.
+class ThreadPool {
+public:
+  explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency()) {
+    threads = std::max(threads, 1u);
+    for (unsigned i = 1; i < threads; i++)
+      workers.emplace_back([this, i] { loop(i); });
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+  }
+
+  unsigned size() const { return workers.size() + 1; }
+
+  static ThreadPool& shared() {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  // Calls fn(task, thread) for every task in [0, count) and blocks until all
+  // are done. Tasks are claimed dynamically; `thread` is in [0, size()).
+  // Calls from inside a running job execute inline on the current thread.
+  // The first exception thrown by a task skips the tasks not yet claimed and
+  // is rethrown here once every thread has left the job.
+  void run(size_t count, const std::function<void(size_t, unsigned)>& fn) {
+    if (count == 0) return;
+    if (workers.empty() || count == 1 || insideJob) {
+      for (size_t i = 0; i < count; i++) fn(i, 0);
+      return;
+    }
+
+    std::lock_guard submit(submitMutex);
+    {
+      std::lock_guard lock(mutex);
+      job = &fn;
+      jobCount = count;
+      next = 0;
+      active = workers.size();
+      generation++;
+    }
+    wake.notify_all();
+
+    work(0);
+
+    std::unique_lock lock(mutex);
+    done.wait(lock, [this] { return active == 0; });
+    job = nullptr;
+    if (std::exception_ptr e = std::exchange(error, nullptr)) {
+      lock.unlock();
+      std::rethrow_exception(e);
+    }
+  }
+
+private:
+  std::vector<std::thread> workers;
+  std::mutex submitMutex;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  const std::function<void(size_t, unsigned)>* job = nullptr;
+  std::exception_ptr error;
+  size_t jobCount = 0;
+  std::atomic<size_t> next = 0;
+  unsigned active = 0;
+  uint64_t generation = 0;
+  bool stopping = false;
+
+  static inline thread_local bool insideJob = false;
+
+  void work(unsigned thread) {
+    insideJob = true;
+    try {
+      for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < jobCount;)
+        (*job)(i, thread);
+    } catch (...) {
+      std::lock_guard lock(mutex);
+      if (!error) error = std::current_exception();
+      next = jobCount;
+    }
+    insideJob = false;
+  }
+
+  void loop(unsigned thread) {
+    uint64_t seen = 0;
+    for (;;) {
+      {
+        std::unique_lock lock(mutex);
+        wake.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+      }
+      work(thread);
+      {
+        std::lock_guard lock(mutex);
+        if (--active == 0) done.notify_one();
+      }
+    }
+  }
+};
+
+// Splits [0, n) into ranges of `grain` elements and calls fn(begin, end) for
+// each of them on the pool.
+template <typename F>
+inline void parallelFor(size_t n, size_t grain, F&& fn, ThreadPool& pool = ThreadPool::shared()) {
+  grain = std::max<size_t>(grain, 1);
+  size_t chunks = (n + grain - 1) / grain;
+  pool.run(chunks, [&](size_t chunk, unsigned) {
+    size_t begin = chunk * grain;
+    fn(begin, std::min(begin + grain, n));
+  });
+}
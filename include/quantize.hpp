@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "mesh_cache.hpp"
+#include "mesh_codec.hpp"
+#include "parallel.hpp"
+
+// Vertex streams packed into formats the GPU reads directly, so they are
+// fetched narrower and never decoded on the CPU:
+//
+//   positions  Unorm16 x 4 over the bounds, w zero   8 bytes
+//   normals    octahedral Snorm16 x 2               4 bytes
+//   colors     Unorm8 x 4, alpha opaque             4 bytes
+//
+// against 12 bytes each as Float32 x 3. Positions reach the vertex shader in
+// [0, 1] per axis; quantize::dequantization gives the matrix back to model
+// units, which folds into the model matrix for free. Normals are unfolded
+// from the octahedron in the shader. Vertices are packed in parallel over
+// fixed chunks, and each chunk measures the error of its own vertices
+// against the floats.
+namespace quantize {
+  constexpr size_t chunkVertices = 1 << 16;
+
+  // Column-major matrix taking positions in [0, 1] back into the box b.
+  inline void dequantization(const meshcodec::Bounds& b, float* m) {
+    std::fill_n(m, 16, 0.f);
+    for (int k = 0; k < 3; k++) m[k * 5] = b.v[k + 3] - b.v[k], m[12 + k] = b.v[k];
+    m[15] = 1;
+  }
+
+  // Largest differences from the floats: in model units per position
+  // component, in radians between normals and per color component.
+  struct Error {
+    float position = 0;
+    float normal = 0;
+    float color = 0;
+  };
+
+  // Packed streams of a mesh, kept alive until meshcache::write.
+  struct Packed {
+    meshcodec::Bounds bounds;
+    uint64_t vertexCount = 0;
+    std::vector<uint16_t> positions;
+    std::vector<int16_t> normals;
+    std::vector<uint8_t> colors;
+    Error error;
+
+    // Bytes per vertex over all packed streams.
+    size_t stride() const {
+      return vertexCount ? (positions.size() * 2 + normals.size() * 2 + colors.size()) / vertexCount : 0;
+    }
+
+    std::vector<meshcache::StreamData> streams() const {
+      using namespace meshcache;
+      std::vector<StreamData> out{
+        {.semantic = Position, .format = Unorm16, .components = 4, .data = positions.data(), .count = vertexCount, .bounds = bounds.v },
+      };
+      if (!normals.empty())
+        out.push_back({ .semantic = Normal, .format = Snorm16, .components = 2, .data = normals.data(), .count = vertexCount });
+      if (!colors.empty())
+        out.push_back({ .semantic = Color, .format = Unorm8, .components = 4, .data = colors.data(), .count = vertexCount });
+      return out;
+    }
+  };
+
+  // Colors of `components` channels in [0, 1] to four bytes, alpha opaque
+  // when there are three.
+  inline void packColors(const float* C, size_t n, uint32_t components, uint8_t* Q) {
+    for (size_t i = 0; i < n; i++) {
+      for (uint32_t k = 0; k < components; k++)
+        Q[i * 4 + k] = uint8_t(std::clamp(C[i * components + k], 0.f, 1.f) * 255.f + .5f);
+      for (uint32_t k = components; k < 4; k++) Q[i * 4 + k] = 255;
+    }
+  }
+}
+
+// Packs the positions V (xyz triples) into the box `bounds`, which holds
+// them, along with unit normals N and colors C of `colorComponents` channels
+// in [0, 1] when they are not empty, and measures the error of each.
+inline void quantizeVertices(const std::vector<float>& V, const meshcodec::Bounds& bounds, const std::vector<float>& N,
+  const std::vector<float>& C, uint32_t colorComponents, quantize::Packed& out, ThreadPool& pool = ThreadPool::shared()) {
+  using namespace quantize;
+  size_t n = V.size() / 3, chunks = (n + chunkVertices - 1) / chunkVertices;
+  out.bounds = bounds;
+  out.vertexCount = n;
+  out.positions.assign(n * 4, 0);
+  out.normals.resize(N.empty() ? 0 : n * 2);
+  out.colors.resize(C.empty() ? 0 : n * 4);
+
+  // the cosine of the widest angle instead of the angle, per chunk
+  std::vector<Error> errors(chunks, Error{ 0, 1, 0 });
+  float step[3] = { meshcodec::step(bounds, 0), meshcodec::step(bounds, 1), meshcodec::step(bounds, 2) };
+  parallelFor(n, chunkVertices, [&](size_t begin, size_t end) {
+    Error& error = errors[begin / chunkVertices];
+    size_t count = end - begin;
+    meshcodec::quantizePositions(&V[begin * 3], count, bounds, &out.positions[begin * 4], 4);
+    for (size_t i = begin; i < end; i++)
+      for (int k = 0; k < 3; k++)
+        error.position = std::max(error.position, std::abs(bounds.v[k] + out.positions[i * 4 + k] * step[k] - V[i * 3 + k]));
+
+    if (!N.empty()) {
+      meshcodec::octEncode(&N[begin * 3], count, &out.normals[begin * 2]);
+      std::vector<float> decoded(count * 3);
+      meshcodec::octDecode(&out.normals[begin * 2], count, decoded.data(), pool);
+      for (size_t i = 0; i < count; i++) {
+        const float* a = &N[(begin + i) * 3], * b = &decoded[i * 3];
+        if (a[0] == 0 && a[1] == 0 && a[2] == 0) continue;
+        error.normal = std::min(error.normal, a[0] * b[0] + a[1] * b[1] + a[2] * b[2]);
+      }
+    }
+
+    if (!C.empty()) {
+      packColors(&C[begin * colorComponents], count, colorComponents, &out.colors[begin * 4]);
+      for (size_t i = begin; i < end; i++)
+        for (uint32_t k = 0; k < colorComponents; k++)
+          error.color = std::max(error.color,
+            std::abs(out.colors[i * 4 + k] / 255.f - std::clamp(C[i * colorComponents + k], 0.f, 1.f)));
+    }
+  }, pool);
+
+  out.error = { 0, 1, 0 };
+  for (const Error& e : errors) {
+    out.error.position = std::max(out.error.position, e.position);
+    out.error.normal = std::min(out.error.normal, e.normal);
+    out.error.color = std::max(out.error.color, e.color);
+  }
+  out.error.normal = std::acos(std::clamp(out.error.normal, -1.f, 1.f));
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "mapped_file.hpp"
+#include "read_off.hpp"
+#include "read_ply.hpp"
+#include "read_stl.hpp"
+
+// Per-vertex normals and colors and per-face valences, shared by all readers.
+template <typename Scalar>
+using MeshAttributes = OFFAttributes<Scalar>;
+
+enum class MeshFormat { Unknown, OFF, PLY, STL };
+
+// Detects the format from the first bytes of the file, not its extension.
+inline MeshFormat sniffMeshFormat(const char* data, size_t size) {
+  std::string_view head(data, std::min<size_t>(size, 4096));
+  for (;;) {
+    size_t start = head.find_first_not_of(" \t\r\n");
+    if (start == std::string_view::npos) return MeshFormat::Unknown;
+    head.remove_prefix(start);
+    if (head[0] != '#') break;
+    head.remove_prefix(std::min(head.size(), head.find('\n')));
+  }
+
+  if (head.starts_with("ply") && head.size() > 3 && (head[3] == '\n' || head[3] == '\r')) return MeshFormat::PLY;
+  if (stl::isBinary(data, size)) return MeshFormat::STL;
+  for (auto keyword : { "OFF", "NOFF", "COFF", "CNOFF" }) {
+    std::string_view k(keyword);
+    if (head.starts_with(k) && (head.size() == k.size() || head.substr(k.size()).find_first_of(" \t\r\n") == 0))
+      return MeshFormat::OFF;
+  }
+  if (head.starts_with("solid")) return MeshFormat::STL;
+  return MeshFormat::Unknown;
+}
+
+inline MeshFormat sniffMeshFormat(const std::string& file_name) {
+  MappedFile file(file_name);
+  return sniffMeshFormat(file.data, file.size);
+}
+
+// Reads an OFF, PLY or STL file, whichever its header says it is, into
+// positions V, face indices F and, when given, attributes.
+template <typename Scalar, typename Index>
+inline bool readMesh(
+  const std::string file_name,
+  std::vector<Scalar>& V,
+  std::vector<Index>& F,
+  std::type_identity_t<MeshAttributes<Scalar>>* attributes = nullptr)
+{
+  switch (sniffMeshFormat(file_name)) {
+  case MeshFormat::OFF: return readOFF(file_name, V, F, attributes);
+  case MeshFormat::PLY: return readPLY(file_name, V, F, attributes);
+  case MeshFormat::STL: return readSTL(file_name, V, F, attributes);
+  default:
+    printf("readMesh() failed, unknown format %s\n", file_name.c_str());
+    return false;
+  }
+}
@@ -1,96 +1,565 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <string>
-#include <iostream>
+#include <type_traits>
+#include <vector>
+#include "index_stream.hpp"
+#include "mapped_file.hpp"
+#include "parallel.hpp"
+#include "text_scanner.hpp"
+
+struct OFFHeader {
+  int64_t numVertices = 0;
+  int64_t numFaces = 0;
+  int64_t numEdges = 0;
+  bool hasNormals = false;
+  bool hasColors = false;
+  bool binary = false;
+};
+
+// Binary OFF stores every number as a big-endian 32-bit int or float.
+inline uint32_t loadBigEndian32(const char* p) {
+  const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+  return uint32_t(b[0]) << 24 | uint32_t(b[1]) << 16 | uint32_t(b[2]) << 8 | uint32_t(b[3]);
+}
+
+inline float loadBigEndianFloat(const char* p) {
+  uint32_t bits = loadBigEndian32(p);
+  float value;
+  std::memcpy(&value, &bits, 4);
+  return value;
+}
+
+// Optional outputs beyond positions and indices. Normals and colors are the
+// per-vertex attributes of NOFF, COFF and CNOFF files, left empty when the
+// file has none: normals are 3 per vertex, colors are RGBA8, ready for a
+// Unorm8x4 vertex stream, whether the file stores 0-255 integers or 0-1
+// floats, with alpha defaulting to opaque. faceSizes holds the valence of
+// every face, which is needed to split the flat index list into polygons.
+template <typename Scalar>
+struct OFFAttributes {
+  std::vector<Scalar> normals;
+  std::vector<uint8_t> colors;
+  std::vector<uint32_t> faceSizes;
+
+  void resize(const OFFHeader& header, size_t vertices, size_t faces = 0) {
+    normals.resize(header.hasNormals ? vertices * 3 : 0);
+    colors.resize(header.hasColors ? vertices * 4 : 0);
+    faceSizes.resize(faces);
+  }
+
+  Scalar* normal(int64_t i) { return normals.empty() ? nullptr : &normals[i * 3]; }
+  uint8_t* color(int64_t i) { return colors.empty() ? nullptr : &colors[i * 4]; }
+};
+
+// Parses the "[C][N]OFF" keyword and the element counts, leaving the scanner
+// at the first vertex.
+inline bool readOFFHeader(TextScanner& in, OFFHeader& header) {
+  in.skipSpace();
+  const char* keyword = in.p;
+  while (!in.eof() && !TextScanner::isSpace(*in.p) && *in.p != '\n') in.p++;
+  std::string word(keyword, in.p);
+
+  size_t k = 0;
+  if ((header.hasColors = k < word.size() && word[k] == 'C')) k++;
+  if ((header.hasNormals = k < word.size() && word[k] == 'N')) k++;
+  if (word.compare(k, 3, "OFF") != 0) {
+    printf("Error: readOFF() first line should be OFF, NOFF, COFF or CNOFF, not %s...\n", word.c_str());
+    return false;
+  }
+
+  in.skipBlank();
+  if (in.end - in.p >= 6 && std::memcmp(in.p, "BINARY", 6) == 0) {
+    in.skipLine();
+    if (in.end - in.p < 12) {
+      printf("readOFF() failed, invalid element counts\n");
+      return false;
+    }
+    header.binary = true;
+    header.numVertices = int32_t(loadBigEndian32(in.p));
+    header.numFaces = int32_t(loadBigEndian32(in.p + 4));
+    header.numEdges = int32_t(loadBigEndian32(in.p + 8));
+    in.p += 12;
+    return header.numVertices >= 0 && header.numFaces >= 0;
+  }
+
+  in.skipSpace();
+  if (!in.parseInt(header.numVertices) || (in.skipBlank(), !in.parseInt(header.numFaces))) {
+    printf("readOFF() failed, invalid element counts\n");
+    return false;
+  }
+  in.skipBlank();
+  if (!in.parseInt(header.numEdges)) header.numEdges = 0;
+  in.skipLine();
+
+  if (header.numVertices < 0 || header.numFaces < 0) {
+    printf("readOFF() failed, negative element counts\n");
+    return false;
+  }
+  return true;
+}
+
+// Reads "r g b [a]" as RGBA8. Components with a decimal point or exponent
+// are taken as 0-1 floats, otherwise as 0-255 integers. A single colormap
+// index is not supported and reads as opaque white.
+inline bool readOFFColor(TextScanner& in, uint8_t* color) {
+  double c[4];
+  bool real = false;
+  int n = 0;
+  for (; n < 4 && !in.atLineEnd(); n++) {
+    const char* start = in.p;
+    if (!in.parseDouble(c[n])) return false;
+    for (const char* q = start; q < in.p; q++) real |= *q == '.' || *q == 'e' || *q == 'E';
+  }
+  if (n < 3) {
+    std::memset(color, 255, 4);
+    return true;
+  }
+  double scale = real ? 255. : 1.;
+  if (n == 3) c[3] = 255. / scale;
+  for (int k = 0; k < 4; k++) color[k] = uint8_t(std::clamp(c[k] * scale + .5, 0., 255.));
+  return true;
+}
+
+template <typename Scalar>
+inline bool readOFFTriple(TextScanner& in, Scalar* out) {
+  if (!in.parseFloat(out[0])) return false;
+  in.skipBlank();
+  if (!in.parseFloat(out[1])) return false;
+  in.skipBlank();
+  return in.parseFloat(out[2]);
+}
+
+// Reads "x y z [nx ny nz] [r g b [a]] ..." into out[0..2] and drops the rest
+// of the line. Normals and colors are stored when the header declares them
+// and a destination is given.
+template <typename Scalar>
+inline bool readOFFVertex(TextScanner& in, const OFFHeader& header, Scalar* out, Scalar* normal = nullptr, uint8_t* color = nullptr) {
+  in.skipSpace();
+  if (!readOFFTriple(in, out)) return false;
+  if (header.hasNormals) {
+    Scalar unused[3];
+    in.skipBlank();
+    if (!readOFFTriple(in, normal ? normal : unused)) return false;
+  }
+  if (header.hasColors && color && !readOFFColor(in, color)) return false;
+  in.skipLine();
+  return true;
+}
+
+// Appends the indices of "n i0 i1 ... [color]" to F. Indices outside the
+// vertex range fail the face instead of being stored.
+template <typename Index>
+inline bool readOFFFace(TextScanner& in, const OFFHeader& header, std::vector<Index>& F) {
+  in.skipSpace();
+  int64_t valence;
+  if (!in.parseInt(valence) || valence < 0) return false;
+  for (int64_t j = 0; j < valence; j++) {
+    in.skipSpace();
+    int64_t index;
+    if (!in.parseInt(index)) return false;
+    if (index < 0 || index >= header.numVertices) {
+      printf("readOFF() failed, index %lld out of range\n", (long long)index);
+      return false;
+    }
+    F.push_back(static_cast<Index>(index));
+  }
+  in.skipLine();
+  return true;
+}
+
+// Whether every vertex of the file can be addressed with Index.
+template <typename Index>
+inline bool readOFFIndexFits(const OFFHeader& header) {
+  if (header.numVertices == 0 || uint64_t(header.numVertices - 1) <= uint64_t(std::numeric_limits<Index>::max()))
+    return true;
+  printf("readOFF() failed, %lld vertices overflow %zu-byte indices\n", (long long)header.numVertices, sizeof(Index));
+  return false;
+}
+
+// Body of a binary OFF: per vertex 3 floats, then 3 normal floats and 4
+// color floats (0-1) when the header declares them; per face the valence,
+// the indices and a count of trailing color floats.
+template <typename Scalar, typename Index>
+inline bool readOFFBinary(
+  TextScanner& in,
+  const OFFHeader& header,
+  std::vector<Scalar>& V,
+  std::vector<Index>& F,
+  OFFAttributes<Scalar>* attributes)
+{
+  size_t floats = 3 + (header.hasNormals ? 3 : 0) + (header.hasColors ? 4 : 0);
+  uint64_t vertexBytes = uint64_t(header.numVertices) * floats * 4;
+  if (uint64_t(in.end - in.p) < vertexBytes) {
+    printf("readOFF() failed, truncated vertices\n");
+    return false;
+  }
+  // every face takes at least its valence and its color count
+  if ((uint64_t(in.end - in.p) - vertexBytes) / 8 < uint64_t(header.numFaces)) {
+    printf("readOFF() failed, truncated faces\n");
+    return false;
+  }
+  V.resize(header.numVertices * 3);
+  if (attributes) attributes->resize(header, header.numVertices, header.numFaces);
+
+  const char* p = in.p;
+  for (int64_t i = 0; i < header.numVertices; i++) {
+    for (int k = 0; k < 3; k++, p += 4) V[i * 3 + k] = loadBigEndianFloat(p);
+    if (header.hasNormals) {
+      Scalar* normal = attributes ? attributes->normal(i) : nullptr;
+      for (int k = 0; k < 3; k++, p += 4) if (normal) normal[k] = loadBigEndianFloat(p);
+    }
+    if (header.hasColors) {
+      uint8_t* color = attributes ? attributes->color(i) : nullptr;
+      for (int k = 0; k < 4; k++, p += 4) if (color) color[k] = uint8_t(std::clamp(loadBigEndianFloat(p) * 255.f + .5f, 0.f, 255.f));
+    }
+  }
+
+  auto truncated = [] {
+    printf("readOFF() failed, truncated faces\n");
+    return false;
+  };
+  for (int64_t i = 0; i < header.numFaces; i++) {
+    if (in.end - p < 4) return truncated();
+    int64_t valence = int32_t(loadBigEndian32(p));
+    p += 4;
+    if (valence < 0 || uint64_t(in.end - p) < uint64_t(valence + 1) * 4) return truncated();
+    for (int64_t j = 0; j < valence; j++, p += 4) {
+      int64_t index = int32_t(loadBigEndian32(p));
+      if (index < 0 || index >= header.numVertices) {
+        printf("readOFF() failed, index %lld out of range\n", (long long)index);
+        return false;
+      }
+      F.push_back(static_cast<Index>(index));
+    }
+    int64_t colors = int32_t(loadBigEndian32(p));
+    p += 4;
+    if (colors < 0 || uint64_t(in.end - p) < uint64_t(colors) * 4) return truncated();
+    p += colors * 4;
+    if (attributes) attributes->faceSizes[i] = valence;
+  }
+  return true;
+}
 
 template <typename Scalar, typename Index>
 inline bool readOFF(
   const std::string file_name,
   std::vector<Scalar>& V,
-  std::vector<Index>& F)
+  std::vector<Index>& F,
+  std::type_identity_t<OFFAttributes<Scalar>>* attributes = nullptr)
 {
   V.clear();
   F.clear();
+  if (attributes) attributes->resize({}, 0);
 
-  FILE* file = fopen(file_name.c_str(), "r");
+  MappedFile file(file_name);
+  if (!file.valid()) {
+    printf("readOFF() failed, cannot open %s\n", file_name.c_str());
+    return false;
+  }
 
-  char header[1000];
-  const std::string OFF("OFF");
-  const std::string NOFF("NOFF");
-  const std::string COFF("COFF");
+  TextScanner in{ file.begin(), file.end() };
+  OFFHeader header;
+  if (!readOFFHeader(in, header) || !readOFFIndexFits<Index>(header)) return false;
 
-  if (fscanf(file, "%s\n", header) != 1) {
-    printf("readOFF() failed, invalid header: %s\n", header);
-    fclose(file);
-    return false;
+  // The counts are only trusted as far as the file can hold them, a text
+  // vertex taking at least 6 bytes and a face at least 8; the buffers grow
+  // past that as records are actually read.
+  uint64_t bytes = in.end - in.p;
+  V.reserve(std::min<uint64_t>(header.numVertices, bytes / 6) * 3);
+  F.reserve(std::min<uint64_t>(header.numFaces, bytes / 8) * 3);
+  if (header.binary) return readOFFBinary(in, header, V, F, attributes);
+
+  for (int64_t i = 0; i < header.numVertices; i++) {
+    V.resize(i * 3 + 3);
+    if (attributes) attributes->resize(header, i + 1);
+    bool parsed = attributes ?
+      readOFFVertex(in, header, &V[i * 3], attributes->normal(i), attributes->color(i)) :
+      readOFFVertex(in, header, &V[i * 3]);
+    if (!parsed) {
+      printf("Error: bad line (%lld)\n", (long long)i);
+      V.resize(i * 3);
+      return false;
+    }
   }
-  if (!(std::string(header).compare(0, OFF.length(), OFF) == 0 ||
-    std::string(header).compare(0, COFF.length(), COFF) == 0 ||
-    std::string(header).compare(0, NOFF.length(), NOFF) == 0))
-  {
-    printf("Error: readOFF() first line should be OFF or NOFF or COFF, not %s...", header);
-    fclose(file);
-    return false;
+
+  for (int64_t i = 0; i < header.numFaces; i++) {
+    size_t first = F.size();
+    if (!readOFFFace(in, header, F)) {
+      printf("Error: bad line\n");
+      return false;
+    }
+    if (attributes) attributes->faceSizes.push_back(F.size() - first);
   }
 
-  int num_vertices, num_faces, num_edges;
-  char tic_tac_toe;
-  char line[1000];
-  bool has_comment = true;
-  while (has_comment) {
-    fgets(line, 1000, file);
-    has_comment = (line[0] == '#' || line[0] == '\n');
+  return true;
+}
+
+// readOFF into an IndexStream whose width is chosen from the vertex count.
+template <typename Scalar>
+inline bool readOFF(
+  const std::string file_name,
+  std::vector<Scalar>& V,
+  IndexStream& F,
+  std::type_identity_t<OFFAttributes<Scalar>>* attributes = nullptr)
+{
+  std::vector<uint32_t> indices;
+  bool ok = readOFF(file_name, V, indices, attributes);
+  F.assign(std::move(indices), V.size() / 3);
+  return ok;
+}
+
+// Parallel readOFF for large files. The body is cut into line-aligned chunks
+// of about `chunkBytes`; a first pass counts the records (non-blank,
+// non-comment lines) of every chunk so each chunk knows which vertex or face
+// it starts at, a second pass parses vertices in place and faces into
+// per-chunk lists which are then stitched into F in file order.
+// Files below two chunks, and files where a record spans several lines, are
+// handed to the serial readOFF, so results are always identical to it.
+template <typename Scalar, typename Index>
+inline bool readOFFParallel(
+  const std::string file_name,
+  std::vector<Scalar>& V,
+  std::vector<Index>& F,
+  std::type_identity_t<OFFAttributes<Scalar>>* attributes = nullptr,
+  size_t chunkBytes = size_t(1) << 22,
+  ThreadPool& pool = ThreadPool::shared())
+{
+  MappedFile file(file_name);
+  if (!file.valid() || pool.size() == 1 || file.size < 2 * chunkBytes)
+    return readOFF(file_name, V, F, attributes);
+
+  TextScanner in{ file.begin(), file.end() };
+  OFFHeader header;
+  if (!readOFFHeader(in, header) || !readOFFIndexFits<Index>(header)) return false;
+  if (header.binary) return readOFF(file_name, V, F, attributes);
+
+  std::vector<const char*> bounds{ in.p };
+  while (bounds.back() < file.end()) {
+    const char* p = bounds.back() + chunkBytes;
+    if (p >= file.end()) p = file.end();
+    else {
+      const char* nl = static_cast<const char*>(std::memchr(p, '\n', file.end() - p));
+      p = nl ? nl + 1 : file.end();
+    }
+    bounds.push_back(p);
   }
-  sscanf(line, "%d %d %d", &num_vertices, &num_faces, &num_edges);
+  size_t chunks = bounds.size() - 1;
+
+  std::vector<int64_t> firstRecord(chunks + 1, 0);
+  pool.run(chunks, [&](size_t c, unsigned) {
+    int64_t records = 0;
+    for (const char* p = bounds[c]; p < bounds[c + 1];) {
+      while (p < bounds[c + 1] && TextScanner::isSpace(*p)) p++;
+      if (p < bounds[c + 1] && *p != '\n' && *p != '#') records++;
+      const char* nl = static_cast<const char*>(std::memchr(p, '\n', bounds[c + 1] - p));
+      p = nl ? nl + 1 : bounds[c + 1];
+    }
+    firstRecord[c + 1] = records;
+  });
+  for (size_t c = 0; c < chunks; c++) firstRecord[c + 1] += firstRecord[c];
+
+  const int64_t numRecords = header.numVertices + header.numFaces;
+  if (firstRecord[chunks] < numRecords) return readOFF(file_name, V, F, attributes);
+
+  V.clear();
+  F.clear();
+  V.resize(header.numVertices * 3);
+  if (attributes) attributes->resize(header, header.numVertices, header.numFaces);
+
+  std::vector<std::vector<Index>> faces(chunks);
+  std::atomic<bool> ok = true;
+  pool.run(chunks, [&](size_t c, unsigned) {
+    TextScanner chunk{ bounds[c], bounds[c + 1] };
+    int64_t record = firstRecord[c];
+    int64_t last = std::min(firstRecord[c + 1], numRecords);
+    if (last > header.numVertices)
+      faces[c].reserve((last - std::max(record, header.numVertices)) * 3);
+
+    for (; record < last; record++) {
+      size_t first = faces[c].size();
+      bool parsed = record >= header.numVertices ? readOFFFace(chunk, header, faces[c]) :
+        attributes ? readOFFVertex(chunk, header, &V[record * 3], attributes->normal(record), attributes->color(record)) :
+        readOFFVertex(chunk, header, &V[record * 3]);
+      if (!parsed) {
+        ok = false;
+        return;
+      }
+      if (attributes && record >= header.numVertices)
+        attributes->faceSizes[record - header.numVertices] = faces[c].size() - first;
+    }
+    // a record that ran over several lines shifts every later record
+    chunk.skipSpace();
+    if (record < numRecords && !chunk.eof()) ok = false;
+  });
+  if (!ok) return readOFF(file_name, V, F, attributes);
+
+  std::vector<size_t> offsets(chunks + 1, 0);
+  for (size_t c = 0; c < chunks; c++) offsets[c + 1] = offsets[c] + faces[c].size();
+  F.resize(offsets[chunks]);
+  pool.run(chunks, [&](size_t c, unsigned) {
+    std::copy(faces[c].begin(), faces[c].end(), F.begin() + offsets[c]);
+    std::vector<Index>().swap(faces[c]);
+  });
+
+  return true;
+}
+
+// Incremental OFF reader for meshes that do not fit in memory. Only a window
+// of the file (grown only for lines longer than the window) and the chunk
+// being returned are held, so memory stays constant whatever the file size.
+// Vertices have to be consumed before faces.
+template <typename Scalar, typename Index>
+class OFFStreamReader {
+public:
+  OFFHeader header;
+  int64_t verticesRead = 0;
+  int64_t facesRead = 0;
+
+  explicit OFFStreamReader(size_t bufferBytes = size_t(1) << 20) : buffer(std::max<size_t>(bufferBytes, 64)) {}
 
-  for (int i = 0;i < num_vertices;) {
-    fgets(line, 1000, file);
-    double x, y, z, nx, ny, nz;
-    if (sscanf(line, "%lg %lg %lg %lg %lg %lg", &x, &y, &z, &nx, &ny, &nz) >= 3) {
-      V.push_back(x);
-      V.push_back(y);
-      V.push_back(z);
+  OFFStreamReader(const OFFStreamReader&) = delete;
+  OFFStreamReader& operator=(const OFFStreamReader&) = delete;
+
+  ~OFFStreamReader() {
+    if (file) fclose(file);
+  }
 
-      i++;
+  bool open(const std::string& file_name) {
+    file = fopen(file_name.c_str(), "rb");
+    if (!file) {
+      printf("readOFF() failed, cannot open %s\n", file_name.c_str());
+      return false;
     }
-    else if (fscanf(file, "%[#]", &tic_tac_toe) == 1) {
-      char comment[1000];
-      fscanf(file, "%[^\n]", comment);
+    while (!eof && end < buffer.size()) refill();
+    if (!parse([&](TextScanner& in) { return readOFFHeader(in, header); }) || !readOFFIndexFits<Index>(header))
+      return false;
+    if (header.binary) {
+      printf("OFFStreamReader::open() failed, binary OFF is not supported\n");
+      return false;
     }
-    else {
-      printf("Error: bad line (%d)\n", i);
-      if (feof(file)) {
-        fclose(file);
+    return true;
+  }
+
+  bool verticesDone() const { return verticesRead == header.numVertices; }
+  bool facesDone() const { return facesRead == header.numFaces; }
+  size_t bufferCapacity() const { return buffer.size(); }
+
+  // Replaces V, and the attributes when given, with the next (up to) `count`
+  // vertices.
+  bool nextVertices(std::vector<Scalar>& V, size_t count, OFFAttributes<Scalar>* attributes = nullptr) {
+    count = std::min<int64_t>(count, header.numVertices - verticesRead);
+    V.resize(count * 3);
+    if (attributes) attributes->resize(header, count);
+    for (size_t i = 0; i < count; i++)
+      if (!parse([&](TextScanner& in) {
+        return attributes ?
+          readOFFVertex(in, header, &V[i * 3], attributes->normal(i), attributes->color(i)) :
+          readOFFVertex(in, header, &V[i * 3]);
+        })) {
+        printf("Error: bad line (%lld)\n", (long long)(verticesRead + i));
+        V.resize(i * 3);
         return false;
       }
+    verticesRead += count;
+    return true;
+  }
+
+  // Replaces F with the indices of the next (up to) `count` faces, and
+  // faceSizes, when given, with their valences.
+  bool nextFaces(std::vector<Index>& F, size_t count, std::vector<uint32_t>* faceSizes = nullptr) {
+    F.clear();
+    if (faceSizes) faceSizes->clear();
+    if (!verticesDone()) {
+      printf("OFFStreamReader::nextFaces() called before all vertices were read\n");
+      return false;
     }
+    count = std::min<int64_t>(count, header.numFaces - facesRead);
+    for (size_t i = 0; i < count; i++)
+      if (!parse([&](TextScanner& in) {
+        size_t mark = F.size();
+        if (readOFFFace(in, header, F)) {
+          if (faceSizes) faceSizes->push_back(F.size() - mark);
+          return true;
+        }
+        F.resize(mark);
+        return false;
+        })) {
+        printf("Error: bad line\n");
+        return false;
+      }
+    facesRead += count;
+    return true;
   }
 
-  for (int i = 0;i < num_faces;)
-  {
-    int valence;
-    if (fscanf(file, "%d", &valence) == 1) {
-      for (int j = 0;j < valence;j++) {
-        int index;
-        if (j < valence - 1)
-          fscanf(file, "%d", &index);
-        else
-          fscanf(file, "%d%*[^\n]", &index);
+private:
+  FILE* file = nullptr;
+  std::vector<char> buffer;
+  size_t begin = 0, lines = 0, end = 0;
+  bool eof = false;
 
-        F.push_back(index);
+  // Parses one record from the complete lines in the window, reading more of
+  // the file and retrying when the record ran into the end of the window.
+  template <typename F>
+  bool parse(F&& record) {
+    for (;;) {
+      TextScanner in{ buffer.data() + begin, buffer.data() + lines };
+      if (record(in)) {
+        begin = in.p - buffer.data();
+        return true;
       }
-      i++;
-    }
-    else if (fscanf(file, "%[#]", &tic_tac_toe) == 1) {
-      char comment[1000];
-      fscanf(file, "%[^\n]", comment);
-    }
-    else {
-      printf("Error: bad line\n");
-      fclose(file);
-      return false;
+      if (eof || !in.eof()) return false;
+      refill();
     }
   }
 
-  fclose(file);
+  void refill() {
+    std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+    end -= begin;
+    lines -= begin;
+    begin = 0;
+    if (end == buffer.size()) buffer.resize(buffer.size() * 2);
+
+    size_t n = fread(buffer.data() + end, 1, buffer.size() - end, file);
+    end += n;
+    if (n == 0) eof = true;
+
+    lines = end;
+    if (!eof)
+      while (lines > 0 && buffer[lines - 1] != '\n') lines--;
+  }
+};
+
+// Calls onVertices(V, firstVertex) and then onFaces(F, firstFace) for
+// consecutive chunks of at most `chunkSize` vertices or faces.
+template <typename Scalar, typename Index, typename OnVertices, typename OnFaces>
+inline bool streamOFF(
+  const std::string file_name,
+  size_t chunkSize,
+  OnVertices&& onVertices,
+  OnFaces&& onFaces)
+{
+  OFFStreamReader<Scalar, Index> reader;
+  if (!reader.open(file_name)) return false;
+
+  std::vector<Scalar> V;
+  while (!reader.verticesDone()) {
+    int64_t first = reader.verticesRead;
+    if (!reader.nextVertices(V, chunkSize)) return false;
+    onVertices(V, first);
+  }
+
+  std::vector<Index> F;
+  while (!reader.facesDone()) {
+    int64_t first = reader.facesRead;
+    if (!reader.nextFaces(F, chunkSize)) return false;
+    onFaces(F, first);
+  }
   return true;
-}
\ No newline at end of file
+}
@@ -0,0 +1,410 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "mapped_file.hpp"
+#include "read_off.hpp"
+#include "text_scanner.hpp"
+
+// Stanford PLY: a text header declaring elements and their typed properties,
+// followed by the element data as ASCII or binary in either byte order.
+namespace ply {
+  enum Type : uint8_t { Int8, Uint8, Int16, Uint16, Int32, Uint32, Float32, Float64, None };
+
+  inline uint32_t typeSize(Type type) {
+    static constexpr uint32_t sizes[] = { 1, 1, 2, 2, 4, 4, 4, 8, 0 };
+    return sizes[type];
+  }
+
+  inline Type parseType(std::string_view name) {
+    if (name == "char" || name == "int8") return Int8;
+    if (name == "uchar" || name == "uint8") return Uint8;
+    if (name == "short" || name == "int16") return Int16;
+    if (name == "ushort" || name == "uint16") return Uint16;
+    if (name == "int" || name == "int32") return Int32;
+    if (name == "uint" || name == "uint32") return Uint32;
+    if (name == "float" || name == "float32") return Float32;
+    if (name == "double" || name == "float64") return Float64;
+    return None;
+  }
+
+  // A list property has a countType, its items are of `type`.
+  struct Property {
+    std::string name;
+    Type type = None;
+    Type countType = None;
+
+    bool isList() const { return countType != None; }
+  };
+
+  struct Element {
+    std::string name;
+    int64_t count = 0;
+    std::vector<Property> properties;
+
+    // Bytes per binary record, 0 when the element has list properties.
+    uint32_t stride() const {
+      uint32_t size = 0;
+      for (auto& p : properties) {
+        if (p.isList()) return 0;
+        size += typeSize(p.type);
+      }
+      return size;
+    }
+
+    // Fewest bytes a record can take: a binary list holds at least its
+    // count, an ASCII value at least a digit and a separator.
+    uint64_t minRecordBytes(bool binary) const {
+      uint64_t size = 0;
+      for (auto& p : properties) size += binary ? typeSize(p.isList() ? p.countType : p.type) : 2;
+      return std::max<uint64_t>(size, 1);
+    }
+
+    int find(std::string_view name) const {
+      for (size_t i = 0; i < properties.size(); i++)
+        if (properties[i].name == name) return int(i);
+      return -1;
+    }
+  };
+
+  enum Format { Ascii, BinaryLittleEndian, BinaryBigEndian };
+
+  struct Header {
+    Format format = Ascii;
+    std::vector<Element> elements;
+  };
+
+  // Parses the header up to and including the end_header line.
+  inline bool readHeader(TextScanner& in, Header& header) {
+    auto word = [&]() {
+      in.skipBlank();
+      const char* start = in.p;
+      while (!in.eof() && !TextScanner::isSpace(*in.p) && *in.p != '\n') in.p++;
+      return std::string_view(start, in.p - start);
+    };
+
+    if (word() != "ply" || !in.atLineEnd()) {
+      printf("Error: not a PLY file\n");
+      return false;
+    }
+    in.skipLine();
+
+    bool hasFormat = false;
+    while (!in.eof()) {
+      std::string_view keyword = word();
+      if (keyword == "end_header") {
+        in.skipLine();
+        if (!hasFormat) printf("Error: PLY header without format\n");
+        return hasFormat;
+      }
+      if (keyword == "format") {
+        std::string_view format = word();
+        if (format == "ascii") header.format = Ascii;
+        else if (format == "binary_little_endian") header.format = BinaryLittleEndian;
+        else if (format == "binary_big_endian") header.format = BinaryBigEndian;
+        else {
+          printf("Error: unknown PLY format %.*s\n", int(format.size()), format.data());
+          return false;
+        }
+        hasFormat = true;
+      }
+      else if (keyword == "element") {
+        Element element;
+        element.name = word();
+        in.skipBlank();
+        if (!in.parseInt(element.count) || element.count < 0) {
+          printf("Error: bad PLY element count\n");
+          return false;
+        }
+        header.elements.push_back(std::move(element));
+      }
+      else if (keyword == "property") {
+        if (header.elements.empty()) {
+          printf("Error: PLY property before element\n");
+          return false;
+        }
+        Property property;
+        std::string_view type = word();
+        if (type == "list") {
+          property.countType = parseType(word());
+          type = word();
+          if (property.countType == None || property.countType >= Float32) {
+            printf("Error: bad PLY list count type\n");
+            return false;
+          }
+        }
+        property.type = parseType(type);
+        property.name = word();
+        if (property.type == None) {
+          printf("Error: unknown PLY type %.*s\n", int(type.size()), type.data());
+          return false;
+        }
+        header.elements.back().properties.push_back(std::move(property));
+      }
+      // comment, obj_info and unknown lines are ignored
+      in.skipLine();
+    }
+    printf("Error: PLY header without end_header\n");
+    return false;
+  }
+
+  template <typename T>
+  inline T load(const char* p, bool swap) {
+    std::conditional_t<sizeof(T) == 8, uint64_t, std::conditional_t<sizeof(T) == 4, uint32_t,
+      std::conditional_t<sizeof(T) == 2, uint16_t, uint8_t>>> bits;
+    std::memcpy(&bits, p, sizeof(T));
+    if (swap) {
+      if constexpr (sizeof(T) == 8) bits = __builtin_bswap64(bits);
+      else if constexpr (sizeof(T) == 4) bits = __builtin_bswap32(bits);
+      else if constexpr (sizeof(T) == 2) bits = __builtin_bswap16(bits);
+    }
+    T value;
+    std::memcpy(&value, &bits, sizeof(T));
+    return value;
+  }
+
+  // Reads one binary value of `type` as double.
+  inline double loadValue(const char* p, Type type, bool swap) {
+    switch (type) {
+    case Int8: return load<int8_t>(p, swap);
+    case Uint8: return load<uint8_t>(p, swap);
+    case Int16: return load<int16_t>(p, swap);
+    case Uint16: return load<uint16_t>(p, swap);
+    case Int32: return load<int32_t>(p, swap);
+    case Uint32: return load<uint32_t>(p, swap);
+    case Float32: return load<float>(p, swap);
+    case Float64: return load<double>(p, swap);
+    default: return 0;
+    }
+  }
+
+  // Cursor over element data in any of the three formats. Binary reads are
+  // bounds checked against the end of the file; ASCII records may span lines.
+  struct Reader {
+    TextScanner in;
+    Format format;
+
+    bool swap() const {
+      return (format == BinaryBigEndian) != (std::endian::native == std::endian::big);
+    }
+
+    bool value(Type type, double& out) {
+      if (format == Ascii) {
+        in.skipSpace();
+        return in.parseDouble(out);
+      }
+      if (uint64_t(in.end - in.p) < typeSize(type)) return false;
+      out = loadValue(in.p, type, swap());
+      in.p += typeSize(type);
+      return true;
+    }
+
+    bool count(Type type, uint32_t& out) {
+      double value;
+      if (!this->value(type, value) || value < 0 || value > std::numeric_limits<uint32_t>::max()) return false;
+      out = uint32_t(value);
+      return true;
+    }
+
+    bool skip(const Property& property) {
+      double value;
+      uint32_t n = 1;
+      if (property.isList() && !count(property.countType, n)) return false;
+      if (format != Ascii) {
+        uint64_t bytes = uint64_t(n) * typeSize(property.type);
+        if (uint64_t(in.end - in.p) < bytes) return false;
+        in.p += bytes;
+        return true;
+      }
+      for (uint32_t i = 0; i < n; i++)
+        if (!this->value(property.type, value)) return false;
+      return true;
+    }
+
+    bool skip(const Element& element) {
+      uint32_t stride = element.stride();
+      if (format != Ascii && stride) {
+        if (uint64_t(in.end - in.p) / stride < uint64_t(element.count)) return false;
+        in.p += uint64_t(stride) * element.count;
+        return true;
+      }
+      for (int64_t i = 0; i < element.count; i++)
+        for (auto& p : element.properties)
+          if (!skip(p)) return false;
+      return true;
+    }
+  };
+}
+
+// Reads a PLY file into the same layout as readOFF: positions in V, face
+// indices in F and, when requested, per-vertex normals (nx, ny, nz), colors
+// (red, green, blue[, alpha], 8-bit or float) and face valences. Elements
+// other than vertex and face are skipped. Binary vertex data that already is
+// packed x, y, z of Scalar in native byte order is copied in one block, and
+// 32-bit triangle indices are copied per face without conversion.
+template <typename Scalar, typename Index>
+inline bool readPLY(
+  const std::string file_name,
+  std::vector<Scalar>& V,
+  std::vector<Index>& F,
+  std::type_identity_t<OFFAttributes<Scalar>>* attributes = nullptr)
+{
+  V.clear();
+  F.clear();
+  if (attributes) attributes->resize({}, 0);
+
+  MappedFile file(file_name);
+  if (!file.valid()) {
+    printf("readPLY() failed, cannot open %s\n", file_name.c_str());
+    return false;
+  }
+
+  ply::Reader reader{ { file.begin(), file.end() }, ply::Ascii };
+  ply::Header header;
+  if (!ply::readHeader(reader.in, header)) return false;
+  reader.format = header.format;
+
+  for (auto& element : header.elements) {
+    if (element.name == "vertex") {
+      int xyz[3] = { element.find("x"), element.find("y"), element.find("z") };
+      if (xyz[0] < 0 || xyz[1] < 0 || xyz[2] < 0) {
+        printf("Error: PLY vertex without x, y, z\n");
+        return false;
+      }
+      if (element.count > 0 && uint64_t(element.count - 1) > uint64_t(std::numeric_limits<Index>::max())) {
+        printf("Error: %lld vertices do not fit the index type\n", (long long)element.count);
+        return false;
+      }
+
+      // target of every property: 0-2 position, 3-5 normal, 6-9 color, -1 none
+      static const char* names[] = { "x", "y", "z", "nx", "ny", "nz", "red", "green", "blue", "alpha" };
+      std::vector<int> target(element.properties.size(), -1);
+      for (size_t i = 0; i < element.properties.size(); i++)
+        for (int k = 0; k < 10; k++)
+          if (element.properties[i].name == names[k] && !element.properties[i].isList()) target[i] = k;
+      OFFHeader layout;
+      layout.hasNormals = element.find("nx") >= 0 && element.find("ny") >= 0 && element.find("nz") >= 0;
+      layout.hasColors = element.find("red") >= 0 && element.find("green") >= 0 && element.find("blue") >= 0;
+
+      // The count is only trusted as far as the rest of the file can hold
+      // it: binary data has to be there in full, ASCII storage grows past
+      // what the smallest records would fill as vertices are read.
+      uint64_t fits = uint64_t(reader.in.end - reader.in.p) / element.minRecordBytes(reader.format != ply::Ascii);
+      if (reader.format != ply::Ascii && fits < uint64_t(element.count)) {
+        printf("Error: PLY vertex data truncated\n");
+        return false;
+      }
+      int64_t allocated = 0;
+      auto allocate = [&](int64_t n) {
+        V.resize(n * 3);
+        if (attributes) {
+          attributes->resize(layout, n);
+          if (layout.hasColors) std::fill(attributes->colors.begin() + allocated * 4, attributes->colors.end(), 255);
+        }
+        allocated = n;
+      };
+      allocate(std::min<uint64_t>(element.count, fits));
+
+      constexpr ply::Type native = sizeof(Scalar) == 4 ? ply::Float32 : ply::Float64;
+      bool packed = reader.format != ply::Ascii && !reader.swap() && element.properties.size() == 3 &&
+        target[0] == 0 && target[1] == 1 && target[2] == 2 && std::is_floating_point_v<Scalar> &&
+        element.properties[0].type == native && element.properties[1].type == native && element.properties[2].type == native;
+      if (packed) {
+        if (uint64_t(reader.in.end - reader.in.p) < V.size() * sizeof(Scalar)) {
+          printf("Error: PLY vertex data truncated\n");
+          return false;
+        }
+        if (!V.empty()) std::memcpy(V.data(), reader.in.p, V.size() * sizeof(Scalar));
+        reader.in.p += V.size() * sizeof(Scalar);
+        continue;
+      }
+
+      for (int64_t i = 0; i < element.count; i++) {
+        if (i == allocated) allocate(std::min<int64_t>(element.count, allocated * 2 + 1));
+        for (size_t j = 0; j < element.properties.size(); j++) {
+          auto& property = element.properties[j];
+          double value;
+          if (target[j] < 0 || (target[j] >= 3 && !attributes)) {
+            if (reader.skip(property)) continue;
+          }
+          else if (reader.value(property.type, value)) {
+            int k = target[j];
+            if (k < 3) V[i * 3 + k] = Scalar(value);
+            else if (k < 6) { if (layout.hasNormals) attributes->normals[i * 3 + k - 3] = Scalar(value); }
+            else if (layout.hasColors) {
+              if (property.type == ply::Float32 || property.type == ply::Float64) value *= 255.;
+              attributes->colors[i * 4 + k - 6] = uint8_t(std::clamp(value + .5, 0., 255.));
+            }
+            continue;
+          }
+          printf("Error: bad PLY vertex (%lld)\n", (long long)i);
+          V.resize(i * 3);
+          return false;
+        }
+      }
+    }
+    else if (element.name == "face") {
+      int list = element.find("vertex_indices");
+      if (list < 0) list = element.find("vertex_index");
+      if (list < 0 || !element.properties[list].isList()) {
+        printf("Error: PLY face without vertex_indices\n");
+        return false;
+      }
+      const ply::Property& indices = element.properties[list];
+      uint64_t numVertices = V.size() / 3;
+      uint64_t fits = uint64_t(reader.in.end - reader.in.p) / element.minRecordBytes(reader.format != ply::Ascii);
+      if (reader.format != ply::Ascii && fits < uint64_t(element.count)) {
+        printf("Error: PLY face data truncated\n");
+        return false;
+      }
+      F.reserve(std::min<uint64_t>(element.count, fits) * 3);
+      if (attributes) attributes->faceSizes.reserve(std::min<uint64_t>(element.count, fits));
+
+      bool direct = reader.format != ply::Ascii && !reader.swap() && sizeof(Index) == 4 &&
+        element.properties.size() == 1 && indices.countType == ply::Uint8 &&
+        (indices.type == ply::Int32 || indices.type == ply::Uint32);
+      for (int64_t i = 0; i < element.count; i++) {
+        size_t first = F.size();
+        bool ok = true;
+        if (direct && reader.in.p < reader.in.end && uint8_t(*reader.in.p) == 3 && reader.in.end - reader.in.p >= 13) {
+          F.resize(first + 3);
+          std::memcpy(&F[first], reader.in.p + 1, 12);
+          reader.in.p += 13;
+        }
+        else
+          for (size_t j = 0; j < element.properties.size() && ok; j++) {
+            if (int(j) != list) {
+              ok = reader.skip(element.properties[j]);
+              continue;
+            }
+            uint32_t valence = 0;
+            double value;
+            ok = reader.count(indices.countType, valence);
+            // checked before narrowing to Index, which could wrap into range
+            for (uint32_t k = 0; k < valence && ok; k++)
+              if ((ok = reader.value(indices.type, value) && value >= 0 && value < double(numVertices)))
+                F.push_back(Index(int64_t(value)));
+          }
+        for (size_t j = first; direct && j < F.size() && ok; j++) ok = uint64_t(F[j]) < numVertices;
+        if (!ok) {
+          printf("Error: bad PLY face (%lld)\n", (long long)i);
+          return false;
+        }
+        if (attributes) attributes->faceSizes.push_back(F.size() - first);
+      }
+    }
+    else if (!reader.skip(element)) {
+      printf("Error: bad PLY element %s\n", element.name.c_str());
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "hash.hpp"
+#include "mapped_file.hpp"
+#include "read_off.hpp"
+#include "text_scanner.hpp"
+
+// Binary STL: an 80 byte header, a little-endian uint32 triangle count and
+// 50 bytes per triangle (facet normal, three corners as float triples and a
+// uint16 attribute). ASCII STL starts with "solid" and lists "vertex x y z".
+namespace stl {
+  constexpr size_t headerSize = 84;
+  constexpr size_t triangleSize = 50;
+
+  // Binary files may also start with "solid", so the size decides.
+  inline bool isBinary(const char* data, size_t size) {
+    if (size < headerSize) return false;
+    uint32_t count;
+    std::memcpy(&count, data + 80, 4);
+    if constexpr (std::endian::native == std::endian::big) count = __builtin_bswap32(count);
+    return size == headerSize + uint64_t(count) * triangleSize;
+  }
+}
+
+// Merges corners with bit-identical positions (-0 and 0 are equal). P holds
+// `n` corners as xyz triples; V receives the unique positions in order of
+// first use and F one index per corner. Fails when the unique vertices do not
+// fit Index.
+template <typename Scalar, typename Index>
+inline bool weldExact(const Scalar* P, size_t n, std::vector<Scalar>& V, std::vector<Index>& F) {
+  size_t capacity = 16;
+  while (capacity < n * 2) capacity *= 2;
+  constexpr uint32_t empty = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> table(capacity, empty);
+
+  V.clear();
+  V.reserve(n);
+  F.resize(n);
+  for (size_t i = 0; i < n; i++) {
+    Scalar p[3] = { P[i * 3] + Scalar(0), P[i * 3 + 1] + Scalar(0), P[i * 3 + 2] + Scalar(0) };
+    uint64_t h = hash64(p, sizeof(p));
+    size_t slot = h & (capacity - 1);
+    while (table[slot] != empty && std::memcmp(&V[size_t(table[slot]) * 3], p, sizeof(p)) != 0)
+      slot = (slot + 1) & (capacity - 1);
+
+    if (table[slot] == empty) {
+      uint64_t id = V.size() / 3;
+      if (id > uint64_t(std::numeric_limits<Index>::max()) || id >= empty) {
+        printf("Error: welded vertices do not fit the index type\n");
+        return false;
+      }
+      table[slot] = uint32_t(id);
+      V.insert(V.end(), p, p + 3);
+    }
+    F[i] = Index(table[slot]);
+  }
+  V.shrink_to_fit();
+  return true;
+}
+
+// Reads a binary or ASCII STL file into the readOFF layout. STL stores every
+// triangle with its own corners, so duplicates are welded with weldExact;
+// faceSizes are all 3 and facet normals, being per face, are dropped.
+template <typename Scalar, typename Index>
+inline bool readSTL(
+  const std::string file_name,
+  std::vector<Scalar>& V,
+  std::vector<Index>& F,
+  std::type_identity_t<OFFAttributes<Scalar>>* attributes = nullptr)
+{
+  V.clear();
+  F.clear();
+  if (attributes) attributes->resize({}, 0);
+
+  MappedFile file(file_name);
+  if (!file.valid()) {
+    printf("readSTL() failed, cannot open %s\n", file_name.c_str());
+    return false;
+  }
+
+  std::vector<Scalar> corners;
+  if (stl::isBinary(file.data, file.size)) {
+    size_t count = (file.size - stl::headerSize) / stl::triangleSize;
+    corners.resize(count * 9);
+    const char* p = file.data + stl::headerSize;
+    for (size_t t = 0; t < count; t++, p += stl::triangleSize)
+      for (int k = 0; k < 9; k++) {
+        uint32_t bits;
+        std::memcpy(&bits, p + 12 + k * 4, 4);
+        if constexpr (std::endian::native == std::endian::big) bits = __builtin_bswap32(bits);
+        corners[t * 9 + k] = Scalar(std::bit_cast<float>(bits));
+      }
+  }
+  else {
+    TextScanner in{ file.begin(), file.end() };
+    in.skipSpace();
+    if (std::string_view(in.p, std::min<size_t>(5, in.end - in.p)) != "solid") {
+      printf("Error: not an STL file\n");
+      return false;
+    }
+    while (!in.eof()) {
+      in.skipSpace();
+      const char* word = in.p;
+      while (!in.eof() && !TextScanner::isSpace(*in.p) && *in.p != '\n') in.p++;
+      if (std::string_view(word, in.p - word) != "vertex") continue;
+      for (int k = 0; k < 3; k++) {
+        Scalar x;
+        in.skipBlank();
+        if (!in.parseFloat(x)) {
+          printf("Error: bad STL vertex (%lld)\n", (long long)corners.size() / 3);
+          return false;
+        }
+        corners.push_back(x);
+      }
+    }
+    if (corners.size() % 9) {
+      printf("Error: STL facet without three vertices\n");
+      return false;
+    }
+  }
+
+  if (!weldExact(corners.data(), corners.size() / 3, V, F)) return false;
+  if (attributes) attributes->faceSizes.assign(F.size() / 3, 3);
+  return true;
+}
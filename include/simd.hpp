@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Four float lanes on SSE2 and NEON, one plain float elsewhere, so a kernel
+// written once against these helpers runs everywhere. Arithmetic uses the
+// vector extension operators of GCC and Clang; loads and stores are
+// unaligned.
+namespace simd {
+#if defined(__SSE2__)
+  using Float = __m128;
+  constexpr size_t width = 4;
+
+  inline Float splat(float x) { return _mm_set1_ps(x); }
+  inline Float load(const float* p) { return _mm_loadu_ps(p); }
+  inline void store(float* p, Float a) { _mm_storeu_ps(p, a); }
+  inline Float sqrt(Float a) { return _mm_sqrt_ps(a); }
+  inline Float min(Float a, Float b) { return _mm_min_ps(a, b); }
+  inline Float max(Float a, Float b) { return _mm_max_ps(a, b); }
+  inline Float abs(Float a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+  // bit j set where lane j of a <= lane j of b
+  inline int lessEqual(Float a, Float b) { return _mm_movemask_ps(_mm_cmple_ps(a, b)); }
+#elif defined(__ARM_NEON)
+  using Float = float32x4_t;
+  constexpr size_t width = 4;
+
+  inline Float splat(float x) { return vdupq_n_f32(x); }
+  inline Float load(const float* p) { return vld1q_f32(p); }
+  inline void store(float* p, Float a) { vst1q_f32(p, a); }
+  inline Float sqrt(Float a) { return vsqrtq_f32(a); }
+  inline Float min(Float a, Float b) { return vminq_f32(a, b); }
+  inline Float max(Float a, Float b) { return vmaxq_f32(a, b); }
+  inline Float abs(Float a) { return vabsq_f32(a); }
+  inline int lessEqual(Float a, Float b) {
+    const uint32x4_t bits = { 1, 2, 4, 8 };
+    return int(vaddvq_u32(vandq_u32(vcleq_f32(a, b), bits)));
+  }
+#else
+  using Float = float;
+  constexpr size_t width = 1;
+
+  inline Float splat(float x) { return x; }
+  inline Float load(const float* p) { return *p; }
+  inline void store(float* p, Float a) { *p = a; }
+  inline Float sqrt(Float a) { return std::sqrt(a); }
+  inline Float min(Float a, Float b) { return std::min(a, b); }
+  inline Float max(Float a, Float b) { return std::max(a, b); }
+  inline Float abs(Float a) { return std::abs(a); }
+  inline int lessEqual(Float a, Float b) { return a <= b; }
+#endif
+}
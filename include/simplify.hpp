@@ -0,0 +1,507 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+#include "bvh.hpp"
+#include "hash.hpp"
+#include "parallel.hpp"
+#include "vertex_cache.hpp"
+
+// Quadric error simplification (Garland and Heckbert 1997). Edges collapse
+// onto one of their endpoints, so a simplified list indexes the original
+// vertices and a chain of levels shares one vertex buffer. Triangles are
+// sorted along a Morton curve and cut into partitions that are simplified in
+// parallel with the vertices they share locked. The triangles around these
+// seams are then simplified again in partitions eight times larger, and so
+// on until one partition holds them all. The result does not depend on the
+// thread count.
+namespace simplify {
+  constexpr size_t partitionTriangles = 1 << 15;
+
+  // Sum of squared distances to weighted planes, over their total weight.
+  struct Quadric {
+    float a00 = 0, a11 = 0, a22 = 0, a10 = 0, a20 = 0, a21 = 0;
+    float b0 = 0, b1 = 0, b2 = 0, c = 0, w = 0;
+
+    // plane dot(n, p) + d = 0, n of unit length
+    static Quadric plane(const float* n, float d, float w) {
+      return {
+        w * n[0] * n[0], w * n[1] * n[1], w * n[2] * n[2], w * n[1] * n[0], w * n[2] * n[0], w * n[2] * n[1],
+        w * d * n[0], w * d * n[1], w * d * n[2], w * d * d, w
+      };
+    }
+
+    void add(const Quadric& q) {
+      a00 += q.a00, a11 += q.a11, a22 += q.a22, a10 += q.a10, a20 += q.a20, a21 += q.a21;
+      b0 += q.b0, b1 += q.b1, b2 += q.b2, c += q.c, w += q.w;
+    }
+
+    float error(const float* p) const {
+      float x = p[0], y = p[1], z = p[2];
+      float r = a00 * x * x + a11 * y * y + a22 * z * z + 2 * (a10 * x * y + a20 * x * z + a21 * y * z) +
+        2 * (b0 * x + b1 * y + b2 * z) + c;
+      return w > 0 ? std::fabs(r) / w : 0;
+    }
+  };
+
+  // What a partition hands back: its triangles, the quadrics of its locked
+  // vertices to be added to the shared ones, and the largest collapse error.
+  struct Result {
+    std::vector<uint32_t> triangles;
+    std::vector<std::pair<uint32_t, Quadric>> locked;
+    float error = 0;
+  };
+
+  inline void cross(const float* a, const float* b, const float* c, float* n) {
+    float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] }, e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    n[0] = e1[1] * e2[2] - e1[2] * e2[1], n[1] = e1[2] * e2[0] - e1[0] * e2[2], n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+  }
+
+  // Simplifies the `count` triangles of I, over the positions P and quadrics
+  // Q shared by all partitions, down to `target` triangles or until the next
+  // collapse would cost more than `maxError` (a squared distance). Vertices
+  // flagged in `locked` stay, and each on a seam (flagged 1) adds one to the
+  // target. When `init` is set the quadrics are built here from the
+  // triangles, with planes through open edges holding the borders.
+  inline void collapse(const float* P, Quadric* Q, const uint8_t* locked, const uint32_t* I, size_t count,
+    size_t target, float maxError, bool init, Result& out) {
+    // local numbering
+    constexpr uint32_t unused = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> table(std::bit_ceil(std::max<size_t>(count * 2, 64)), unused), vertices, tri(count * 3);
+    size_t mask = table.size() - 1;
+    for (size_t i = 0; i < count * 3; i++) {
+      size_t h = hashMix(I[i]) & mask;
+      while (table[h] != unused && vertices[table[h]] != I[i]) h = (h + 1) & mask;
+      if (table[h] == unused) table[h] = uint32_t(vertices.size()), vertices.push_back(I[i]);
+      tri[i] = table[h];
+    }
+    std::vector<uint32_t>().swap(table);
+    size_t n = vertices.size();
+    std::vector<float> pos(n * 3);
+    std::vector<Quadric> q(n);
+    std::vector<uint8_t> fixed(n);
+    for (size_t i = 0; i < n; i++) {
+      std::copy_n(&P[size_t(vertices[i]) * 3], 3, &pos[i * 3]);
+      fixed[i] = locked[vertices[i]];
+      if (!init && !fixed[i]) q[i] = Q[vertices[i]];
+    }
+    // seams keep their detail until the next phase, and reaching the target
+    // around them would take collapses far costlier than the rest, so every
+    // seam vertex is allowed a triangle more
+    target += std::count(fixed.begin(), fixed.end(), 1);
+
+    // triangles around every vertex
+    std::vector<uint32_t> offsets(n + 1), adjacency;
+    auto connect = [&] {
+      std::fill(offsets.begin(), offsets.end(), 0);
+      for (uint32_t v : tri) offsets[v + 1]++;
+      for (size_t i = 0; i < n; i++) offsets[i + 1] += offsets[i];
+      adjacency.resize(tri.size());
+      std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+      for (size_t i = 0; i < tri.size(); i++) adjacency[fill[tri[i]]++] = uint32_t(i / 3);
+    };
+    // whether a triangle has the half-edge a -> b
+    auto hasEdge = [&](uint32_t a, uint32_t b) {
+      for (uint32_t j = offsets[a]; j < offsets[a + 1]; j++) {
+        const uint32_t* t = &tri[size_t(adjacency[j]) * 3];
+        if ((t[0] == a && t[1] == b) || (t[1] == a && t[2] == b) || (t[2] == a && t[0] == b)) return true;
+      }
+      return false;
+    };
+    connect();
+    // vertices on an open edge, a border of the mesh or a seam with another
+    // partition; edges elsewhere all have a reverse. Around a closed vertex
+    // every neighbour follows it in one triangle and precedes it in another,
+    // so their hashes cancel.
+    std::vector<uint64_t> balance(n);
+    for (size_t i = 0; i < tri.size(); i++) {
+      size_t base = i - i % 3;
+      balance[tri[i]] += hashMix(tri[base + (i + 1) % 3]) - hashMix(tri[base + (i + 2) % 3]);
+    }
+    std::vector<uint8_t> open(n);
+    for (size_t i = 0; i < n; i++) open[i] = balance[i] != 0;
+    std::vector<uint64_t>().swap(balance);
+
+    if (init)
+      for (size_t t = 0; t < count; t++) {
+        const uint32_t* f = &tri[t * 3];
+        float normal[3];
+        cross(&pos[f[0] * 3], &pos[f[1] * 3], &pos[f[2] * 3], normal);
+        float area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (area == 0) continue;
+        for (float& x : normal) x /= area;
+        const float* p0 = &pos[f[0] * 3];
+        Quadric plane = Quadric::plane(normal, -(normal[0] * p0[0] + normal[1] * p0[1] + normal[2] * p0[2]), area);
+        for (int k = 0; k < 3; k++) q[f[k]].add(plane);
+
+        // an open edge with a free end is a border of the mesh and not a
+        // seam between partitions, which only has locked ends
+        for (int k = 0; k < 3; k++) {
+          uint32_t a = f[k], b = f[(k + 1) % 3];
+          if ((fixed[a] && fixed[b]) || !open[a] || !open[b] || hasEdge(b, a)) continue;
+          const float* pa = &pos[a * 3], * pb = &pos[b * 3];
+          float e[3] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+          float m[3] = { e[1] * normal[2] - e[2] * normal[1], e[2] * normal[0] - e[0] * normal[2], e[0] * normal[1] - e[1] * normal[0] };
+          float length = std::sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+          if (length == 0) continue;
+          for (float& x : m) x /= length;
+          Quadric border = Quadric::plane(m, -(m[0] * pa[0] + m[1] * pa[1] + m[2] * pa[2]), 10 * length * length);
+          q[a].add(border), q[b].add(border);
+        }
+      }
+
+    struct Candidate {
+      uint32_t from, to;
+      float error;
+    };
+    std::vector<Candidate> candidates;
+    std::vector<uint32_t> order, start;
+    std::vector<uint32_t> remap(n);
+    std::vector<uint8_t> touched(n), changed(count);
+    size_t live = count;
+    while (live > target) {
+      // every edge once, collapsing its cheaper free end onto the other
+      candidates.clear();
+      for (size_t i = 0; i < tri.size(); i++) {
+        uint32_t a = tri[i], b = tri[i - i % 3 + (i + 1) % 3];
+        if (b < a && (!open[a] || !open[b] || hasEdge(b, a))) continue;
+        float ea = fixed[a] ? INFINITY : q[a].error(&pos[b * 3]), eb = fixed[b] ? INFINITY : q[b].error(&pos[a * 3]);
+        if (ea <= eb && ea <= maxError) candidates.push_back({ a, b, ea });
+        else if (eb < ea && eb <= maxError) candidates.push_back({ b, a, eb });
+      }
+      // a counting sort on the exponent and top 3 mantissa bits orders the
+      // errors to within an eighth of a binade, which is plenty
+      auto bucket = [&](const Candidate& c) { return std::bit_cast<uint32_t>(c.error) >> 20; };
+      start.assign(2049, 0);
+      for (const Candidate& c : candidates) start[bucket(c) + 1]++;
+      for (size_t b = 0; b < 2048; b++) start[b + 1] += start[b];
+      order.resize(candidates.size());
+      for (size_t c = 0; c < candidates.size(); c++) order[start[bucket(candidates[c])]++] = uint32_t(c);
+
+      // cheapest first, up to the triangles still to remove, each vertex and
+      // triangle changed once per pass. A collapse is skipped when it turns
+      // a triangle by more than about 75 degrees: a 90 degree cutoff lets a
+      // series of collapses flip triangles a bit at a time.
+      std::iota(remap.begin(), remap.end(), 0);
+      std::fill(touched.begin(), touched.end(), 0);
+      std::fill(changed.begin(), changed.end(), 0);
+      size_t removed = 0, collapsed = 0;
+      for (uint32_t index : order) {
+        if (live - removed <= target) break;
+        const Candidate& c = candidates[index];
+        if (touched[c.from] || touched[c.to]) continue;
+        // the fan around the moving vertex, to catch triangles that turn
+        // sideways over several passes
+        bool flips = false;
+        float fan[3] = { 0, 0, 0 }, normal[3];
+        for (uint32_t j = offsets[c.from]; j < offsets[c.from + 1] && !flips; j++) {
+          const uint32_t* f = &tri[size_t(adjacency[j]) * 3];
+          flips = changed[adjacency[j]];
+          cross(&pos[f[0] * 3], &pos[f[1] * 3], &pos[f[2] * 3], normal);
+          for (int k = 0; k < 3; k++) fan[k] += normal[k];
+        }
+        size_t dropped = 0;
+        for (uint32_t j = offsets[c.from]; j < offsets[c.from + 1] && !flips; j++) {
+          const uint32_t* f = &tri[size_t(adjacency[j]) * 3];
+          if (f[0] == c.to || f[1] == c.to || f[2] == c.to) {
+            dropped++;
+            continue;
+          }
+          const float* p[3], * moved[3];
+          for (int k = 0; k < 3; k++) p[k] = &pos[f[k] * 3], moved[k] = f[k] == c.from ? &pos[c.to * 3] : p[k];
+          float before[3], after[3];
+          cross(p[0], p[1], p[2], before);
+          cross(moved[0], moved[1], moved[2], after);
+          float dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+          float lengths = (before[0] * before[0] + before[1] * before[1] + before[2] * before[2]) *
+            (after[0] * after[0] + after[1] * after[1] + after[2] * after[2]);
+          flips = dot <= .25f * std::sqrt(lengths) || fan[0] * after[0] + fan[1] * after[1] + fan[2] * after[2] <= 0;
+        }
+        if (flips) continue;
+        touched[c.from] = touched[c.to] = 1;
+        for (uint32_t j = offsets[c.from]; j < offsets[c.from + 1]; j++) changed[adjacency[j]] = 1;
+        remap[c.from] = c.to;
+        q[c.to].add(q[c.from]);
+        out.error = std::max(out.error, c.error);
+        removed += dropped, collapsed++;
+      }
+      if (collapsed == 0) break;
+
+      size_t kept = 0;
+      for (size_t t = 0; t < live; t++) {
+        uint32_t a = remap[tri[t * 3]], b = remap[tri[t * 3 + 1]], c = remap[tri[t * 3 + 2]];
+        if (a == b || b == c || c == a) continue;
+        tri[kept * 3] = a, tri[kept * 3 + 1] = b, tri[kept * 3 + 2] = c;
+        kept++;
+      }
+      live = kept;
+      tri.resize(live * 3);
+      connect();
+    }
+
+    out.triangles.resize(tri.size());
+    for (size_t i = 0; i < tri.size(); i++) out.triangles[i] = vertices[tri[i]];
+    for (size_t i = 0; i < n; i++)
+      if (!fixed[i]) Q[vertices[i]] = q[i];
+      else if (q[i].w > 0) out.locked.push_back({ vertices[i], q[i] });
+  }
+
+  // Spreads the low 10 bits of x to every third bit.
+  inline uint32_t spread(uint32_t x) {
+    x &= 0x3ff;
+    x = (x | x << 16) & 0x30000ff;
+    x = (x | x << 8) & 0x300f00f;
+    x = (x | x << 4) & 0x30c30c3;
+    return (x | x << 2) & 0x9249249;
+  }
+
+  template <typename Index>
+  struct Lod {
+    std::vector<Index> indices;
+    float error = 0; // distance to the full mesh, see buildLods
+  };
+
+  // Coarsest of the levels, ordered fine to coarse, whose error looks at
+  // most `threshold` pixels large from `distance` away through a vertical
+  // field of view `fov` (in radians) onto a viewport `height` pixels tall.
+  inline size_t selectLod(const std::vector<float>& errors, float distance, float fov, float height, float threshold = 1) {
+    float pixels = height / (2 * std::tan(fov / 2) * std::max(distance, 1e-6f));
+    size_t level = 0;
+    for (size_t i = 1; i < errors.size(); i++)
+      if (errors[i] * pixels <= threshold) level = i;
+    return level;
+  }
+}
+
+// Simplifies the triangle list F over the positions V (xyz triples) to at
+// most `targetTriangles` triangles, stopping early where the error of a
+// collapse would exceed `maxError`. The triangles in `out` index V. Returns
+// an error estimate in the units of V: the square root of the largest
+// quadric error collapsed, which is a mean squared distance to the planes
+// around the vertex, weighted by area and by the border planes. It is not a
+// bound on how far the surface moved.
+template <typename Scalar, typename Index>
+inline float simplifyMesh(const std::vector<Scalar>& V, const std::vector<Index>& F, std::vector<Index>& out,
+  size_t targetTriangles, float maxError = std::numeric_limits<float>::max(), ThreadPool& pool = ThreadPool::shared()) {
+  constexpr size_t grain = 1 << 16;
+  size_t n = V.size() / 3, triangles = F.size() / 3;
+  if (triangles <= targetTriangles || n == 0) {
+    out.assign(F.begin(), F.begin() + triangles * 3);
+    return 0;
+  }
+
+  // positions in the unit box keep the float quadrics accurate
+  float lo[3], hi[3];
+  for (int k = 0; k < 3; k++) lo[k] = hi[k] = float(V[k]);
+  for (size_t i = 0; i < n; i++)
+    for (int k = 0; k < 3; k++) lo[k] = std::min(lo[k], float(V[i * 3 + k])), hi[k] = std::max(hi[k], float(V[i * 3 + k]));
+  float extent = std::max({ hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2] });
+  float scale = extent > 0 ? 1 / extent : 0;
+  std::vector<float> P(n * 3);
+  parallelFor(n, grain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++)
+      for (int k = 0; k < 3; k++) P[i * 3 + k] = (float(V[i * 3 + k]) - lo[k]) * scale;
+  }, pool);
+
+  // copies the `count` triangles of I to `out` along a Morton curve of
+  // their centroids, by a radix sort on the 30 bit codes above their ids
+  auto sortAlongCurve = [&](const auto* I, size_t count, std::vector<uint32_t>& out) {
+    std::vector<uint64_t> keys(count), sorted(count);
+    parallelFor(count, grain, [&](size_t begin, size_t end) {
+      for (size_t t = begin; t < end; t++) {
+        uint32_t code = 0;
+        for (int k = 0; k < 3; k++) {
+          float c = (P[size_t(I[t * 3]) * 3 + k] + P[size_t(I[t * 3 + 1]) * 3 + k] + P[size_t(I[t * 3 + 2]) * 3 + k]) / 3;
+          code |= simplify::spread(uint32_t(std::clamp(c, 0.f, 1.f) * 1023)) << k;
+        }
+        keys[t] = uint64_t(code) << 32 | t;
+      }
+    }, pool);
+    for (int shift = 32; shift < 62; shift += 10) {
+      std::vector<size_t> start(1025, 0);
+      for (uint64_t key : keys) start[((key >> shift) & 1023) + 1]++;
+      for (size_t d = 0; d < 1024; d++) start[d + 1] += start[d];
+      for (uint64_t key : keys) sorted[start[(key >> shift) & 1023]++] = key;
+      keys.swap(sorted);
+    }
+    out.resize(count * 3);
+    parallelFor(count, grain, [&](size_t begin, size_t end) {
+      for (size_t t = begin; t < end; t++)
+        for (int k = 0; k < 3; k++) out[t * 3 + k] = uint32_t(I[size_t(uint32_t(keys[t])) * 3 + k]);
+    }, pool);
+  };
+
+  // locked is 1 on the seams between partitions and 2 where the region
+  // being simplified meets the triangles left alone
+  std::vector<simplify::Quadric> Q(n);
+  std::vector<uint8_t> locked(n);
+  std::vector<uint32_t> owner(n), current, region, rest;
+  sortAlongCurve(F.data(), triangles, region);
+  float limit = extent > 0 ? std::min(maxError * scale, 1e18f) : 0, error = 0;
+  for (size_t size = simplify::partitionTriangles, phase = 0;; size *= 8, phase++) {
+    // after the first phase only the triangles around vertices locked in the
+    // last one are simplified again, in larger partitions, until the target
+    // is met or nothing changes
+    if (phase > 0) {
+      if (current.size() / 3 <= targetTriangles) break;
+      std::vector<uint32_t> seams;
+      rest.clear();
+      for (size_t t = 0; t < current.size(); t += 3) {
+        const uint32_t* f = &current[t];
+        auto& to = locked[f[0]] || locked[f[1]] || locked[f[2]] ? seams : rest;
+        to.insert(to.end(), f, f + 3);
+      }
+      if (seams.empty()) break;
+      sortAlongCurve(seams.data(), seams.size() / 3, region);
+    }
+    size_t count = region.size() / 3, kept = rest.size() / 3;
+    size_t parts = std::max<size_t>(1, (count + size - 1) / size);
+    size_t target = targetTriangles > kept ? targetTriangles - kept : 0;
+    auto first = [&](size_t p) { return count * p / parts; };
+
+    constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+    std::fill(owner.begin(), owner.end(), none);
+    std::fill(locked.begin(), locked.end(), 0);
+    for (uint32_t v : rest) owner[v] = uint32_t(parts);
+    for (size_t p = 0; p < parts; p++)
+      for (size_t i = first(p) * 3; i < first(p + 1) * 3; i++) {
+        uint32_t& o = owner[region[i]];
+        if (o == none) o = uint32_t(p);
+        else if (o == parts) locked[region[i]] = 2;
+        else if (o != p) locked[region[i]] = 1;
+      }
+
+    std::vector<simplify::Result> results(parts);
+    pool.run(parts, [&](size_t p, unsigned) {
+      size_t begin = first(p), end = first(p + 1);
+      simplify::collapse(P.data(), Q.data(), locked.data(), &region[begin * 3], end - begin,
+        size_t(double(target) * (end - begin) / count + .5), limit * limit, phase == 0, results[p]);
+    });
+
+    // the triangles left alone, then the partitions in order, whose locked
+    // quadrics are summed in the same order
+    std::vector<size_t> offset(parts + 1, rest.size());
+    for (size_t p = 0; p < parts; p++) offset[p + 1] = offset[p] + results[p].triangles.size();
+    current.swap(rest);
+    current.resize(offset[parts]);
+    pool.run(parts, [&](size_t p, unsigned) {
+      std::copy(results[p].triangles.begin(), results[p].triangles.end(), current.begin() + offset[p]);
+    });
+    for (auto& r : results) {
+      for (auto& [v, q] : r.locked) Q[v].add(q);
+      error = std::max(error, r.error);
+    }
+    if (phase > 0 && current.size() == (count + kept) * 3) break;
+  }
+
+  out.resize(current.size());
+  parallelFor(current.size(), grain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) out[i] = Index(current[i]);
+  }, pool);
+  return std::sqrt(error) * extent;
+}
+
+// Largest distance between the surfaces of the triangle list F and its
+// simplification G over the positions V (xyz triples), with the trees built
+// for each: from the vertices of F to the closest triangle of G, and from
+// the centroid and edge midpoints of every triangle of G to the closest
+// triangle of F. The vertices of G are vertices of F, so this is a
+// two-sided Hausdorff distance measured at those points; a bump of either
+// surface that falls between them can be missed.
+template <typename Scalar, typename Index>
+inline float measureDistance(const std::vector<Scalar>& V, const std::vector<Index>& F, const bvh::Tree& treeF,
+  const std::vector<Index>& G, const bvh::Tree& treeG, ThreadPool& pool = ThreadPool::shared()) {
+  constexpr size_t grain = 1 << 12;
+  size_t n = V.size() / 3;
+  auto position = [&](size_t v, float* p) {
+    for (int k = 0; k < 3; k++) p[k] = float(V[v * 3 + k]);
+  };
+
+  // largest distance from the points of `count` items to the list I, the
+  // points of item i written by points(i, out) which returns how many. Each
+  // point starts from the triangle closest to the point before it, and every
+  // search stops at the first triangle within the largest distance so far,
+  // as closer points cannot raise it.
+  auto farthest = [&](size_t count, const std::vector<Index>& I, const bvh::Tree& tree, auto&& points) {
+    std::vector<float> chunks((count + grain - 1) / grain, 0);
+    parallelFor(count, grain, [&](size_t begin, size_t end) {
+      float largest = 0;
+      bvh::Nearest near;
+      for (size_t i = begin; i < end; i++) {
+        float p[4][3];
+        for (size_t j = 0, m = points(i, p); j < m; j++) {
+          if (near.triangle != bvh::none) {
+            float q[3][3];
+            for (int c = 0; c < 3; c++) position(size_t(I[size_t(near.triangle) * 3 + c]), q[c]);
+            float d = bvh::squaredDistance(p[j], q[0], q[1], q[2]);
+            if (d <= largest * largest) continue;
+            near.distance = std::sqrt(d);
+          }
+          bvh::nearest(tree, V.data(), I.data(), p[j], near, largest);
+          largest = std::max(largest, near.distance);
+        }
+      }
+      chunks[begin / grain] = largest;
+    }, pool);
+    float result = 0;
+    for (float d : chunks) result = std::max(result, d);
+    return result;
+  };
+
+  // the vertices G kept lie on both surfaces
+  std::vector<uint8_t> dropped(n, 0);
+  for (Index v : F) dropped[size_t(v)] = 1;
+  for (Index v : G) dropped[size_t(v)] = 0;
+  float toG = farthest(n, G, treeG, [&](size_t v, float (*out)[3]) {
+    if (!dropped[v]) return 0;
+    position(v, out[0]);
+    return 1;
+  });
+  // an edge shared by two triangles once, from the one where it runs up
+  // from its lower vertex
+  float toF = farthest(G.size() / 3, F, treeF, [&](size_t t, float (*out)[3]) {
+    float p[3][3];
+    for (int c = 0; c < 3; c++) position(size_t(G[t * 3 + c]), p[c]);
+    int m = 1;
+    for (int k = 0; k < 3; k++) out[0][k] = (p[0][k] + p[1][k] + p[2][k]) / 3;
+    for (int c = 0; c < 3; c++)
+      if (G[t * 3 + c] < G[t * 3 + (c + 1) % 3]) {
+        for (int k = 0; k < 3; k++) out[m][k] = (p[c][k] + p[(c + 1) % 3][k]) / 2;
+        m++;
+      }
+    return m;
+  });
+  return std::max(toG, toF);
+}
+
+// Chain of levels of detail of F over V: F itself, then each level
+// simplified from the one before it to `ratios` of the triangles of F and
+// reordered for the vertex cache. A level's error is the distance to F in
+// the units of V, as measureDistance finds it, and no less than the error
+// of the level before it, so the errors grow along the chain.
+template <typename Scalar, typename Index>
+inline std::vector<simplify::Lod<Index>> buildLods(const std::vector<Scalar>& V, const std::vector<Index>& F,
+  const std::vector<float>& ratios = { .5f, .25f, .1f, .02f }, ThreadPool& pool = ThreadPool::shared()) {
+  std::vector<simplify::Lod<Index>> lods(1);
+  lods[0].indices = F;
+  bvh::Tree full;
+  buildBvh(V, F, full, pool);
+  for (float ratio : ratios) {
+    simplify::Lod<Index> lod;
+    const simplify::Lod<Index>& previous = lods.back();
+    simplifyMesh(V, previous.indices, lod.indices, size_t(ratio * (F.size() / 3)), std::numeric_limits<float>::max(), pool);
+    bvh::Tree tree;
+    buildBvh(V, lod.indices, tree, pool);
+    lod.error = std::max(previous.error, measureDistance(V, F, full, lod.indices, tree, pool));
+    optimizeVertexCache(lod.indices, V.size() / 3);
+    lods.push_back(std::move(lod));
+  }
+  return lods;
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "normals.hpp"
+#include "parallel.hpp"
+#include "weld.hpp"
+
+// Tangent frames for normal mapping, following MikkTSpace (Mikkelsen 2008):
+// every corner takes the texture u direction of its triangle, projected onto
+// the plane of the vertex normal and weighted by the corner angle in that
+// plane, and the corners of a vertex are summed per handedness, the sign of
+// the triangle's area in texture space. A vertex used with both, as along a
+// mirrored texture seam, is split in two, which is the only split MikkTSpace
+// makes at its default angular threshold. Corners are summed with
+// normals::sumCorners, in parallel and independent of the thread count.
+// Unlike MikkTSpace, vertices are told apart by index rather than by value,
+// so the index buffer should be welded, and fans that only touch at a vertex
+// are not separated.
+namespace tangent {
+  enum Handedness : uint8_t { Preserving, Reversed, Degenerate };
+
+  // Some unit vector perpendicular to the unit vector n.
+  inline void perpendicular(const float* n, float* t) {
+    int axis = std::abs(n[0]) < std::abs(n[1]) ? (std::abs(n[0]) < std::abs(n[2]) ? 0 : 2) : (std::abs(n[1]) < std::abs(n[2]) ? 1 : 2);
+    float a[3] = { 0, 0, 0 };
+    a[axis] = 1;
+    float d = n[axis];
+    for (int k = 0; k < 3; k++) t[k] = a[k] - n[k] * d;
+    float length = std::sqrt(t[0] * t[0] + t[1] * t[1] + t[2] * t[2]);
+    for (int k = 0; k < 3; k++) t[k] /= length;
+  }
+
+  // v minus its component along the unit vector n, normalized; false when
+  // nothing is left.
+  inline bool project(const float* v, const float* n, float* out) {
+    float d = v[0] * n[0] + v[1] * n[1] + v[2] * n[2];
+    for (int k = 0; k < 3; k++) out[k] = v[k] - n[k] * d;
+    float length = std::sqrt(out[0] * out[0] + out[1] * out[1] + out[2] * out[2]);
+    if (!(length > 0)) return false;
+    for (int k = 0; k < 3; k++) out[k] /= length;
+    return true;
+  }
+
+  inline int8_t snorm8(float x) {
+    return int8_t(std::lround(std::clamp(x, -1.f, 1.f) * 127.f));
+  }
+
+  // Tangents as Snorm8 x 4, for a WGPUVertexFormat_Snorm8x4 buffer.
+  inline void pack(const std::vector<float>& T, std::vector<int8_t>& out, ThreadPool& pool = ThreadPool::shared()) {
+    out.resize(T.size());
+    parallelFor(T.size(), 1 << 16, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) out[i] = snorm8(T[i]);
+    }, pool);
+  }
+}
+
+// Computes tangents T, four floats per vertex: the unit tangent and the sign
+// w of the bitangent, w * cross(normal, tangent), for the triangle list F
+// over the positions V (xyz triples), unit normals N (xyz) and texture
+// coordinates UV (uv pairs). Vertices used with both handednesses are split:
+// the copies are appended after the existing vertices, F is remapped to
+// them (Index must be wide enough), and `splits` gets the source vertex of
+// every copy so that other streams can be extended to match.
+template <typename Scalar, typename Index>
+inline void computeTangents(
+  const std::vector<Scalar>& V,
+  const std::vector<float>& N,
+  const std::vector<float>& UV,
+  std::vector<Index>& F,
+  std::vector<float>& T,
+  std::vector<uint32_t>& splits,
+  ThreadPool& pool = ThreadPool::shared())
+{
+  size_t n = V.size() / 3, triangles = F.size() / 3;
+  std::vector<uint8_t> handedness(triangles);
+  std::vector<float> sums;
+
+  // slot 0 of every vertex sums its preserving corners, slot 1 its reversed
+  // ones; the fourth float counts them
+  normals::sumCorners<4>(F.data(), triangles, n, 1, sums, [&](size_t t, float* out, uint32_t* slot) {
+    const Index* f = &F[t * 3];
+    float p[3][3], uv[3][2];
+    for (int c = 0; c < 3; c++) {
+      for (int k = 0; k < 3; k++) p[c][k] = float(V[size_t(f[c]) * 3 + k]);
+      for (int k = 0; k < 2; k++) uv[c][k] = UV[size_t(f[c]) * 2 + k];
+    }
+    float s1 = uv[1][0] - uv[0][0], t1 = uv[1][1] - uv[0][1], s2 = uv[2][0] - uv[0][0], t2 = uv[2][1] - uv[0][1];
+    float area = s1 * t2 - t1 * s2;
+    uint8_t hand = area > 0 ? tangent::Preserving : area < 0 ? tangent::Reversed : tangent::Degenerate;
+    handedness[t] = hand;
+    // direction of increasing u: (t2 d1 - t1 d2) / area
+    float sign = area < 0 ? -1.f : 1.f, u[3];
+    for (int k = 0; k < 3; k++) u[k] = sign * (t2 * (p[1][k] - p[0][k]) - t1 * (p[2][k] - p[0][k]));
+
+    for (int c = 0; c < 3; c++) {
+      float* o = &out[c * 4];
+      slot[c] = hand == tangent::Reversed;
+      std::fill_n(o, 4, 0.f);
+      if (hand == tangent::Degenerate) continue;
+      o[3] = 1;
+      const float* normal = &N[size_t(f[c]) * 3];
+      float a[3], b[3], ea[3], eb[3], direction[3];
+      for (int k = 0; k < 3; k++) a[k] = p[(c + 1) % 3][k] - p[c][k], b[k] = p[(c + 2) % 3][k] - p[c][k];
+      if (!tangent::project(u, normal, direction) || !tangent::project(a, normal, ea) || !tangent::project(b, normal, eb))
+        continue;
+      float angle = std::acos(std::clamp(ea[0] * eb[0] + ea[1] * eb[1] + ea[2] * eb[2], -1.f, 1.f));
+      for (int k = 0; k < 3; k++) o[k] = direction[k] * angle;
+    }
+  }, pool);
+
+  // a vertex keeps its preserving sum and gets a copy for the reversed one
+  // when it has both
+  std::vector<uint32_t> copy(n);
+  auto used = [&](size_t v, int s) { return sums[(v * 2 + s) * 4 + 3] > 0; };
+  parallelFor(n, 1 << 16, [&](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; v++) copy[v] = used(v, 0) && used(v, 1);
+  }, pool);
+  size_t copies = weld::exclusiveScan(copy.data(), n, pool);
+  splits.resize(copies);
+  T.resize((n + copies) * 4);
+  auto frame = [&](size_t v, int s, float* out) {
+    const float* sum = &sums[(v * 2 + s) * 4];
+    const float* normal = &N[v * 3];
+    if (!tangent::project(sum, normal, out)) tangent::perpendicular(normal, out);
+    out[3] = s == 0 ? 1.f : -1.f;
+  };
+  parallelFor(n, 1 << 16, [&](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; v++) {
+      bool split = used(v, 0) && used(v, 1);
+      frame(v, used(v, 0) || !used(v, 1) ? 0 : 1, &T[v * 4]);
+      if (split) {
+        splits[copy[v]] = uint32_t(v);
+        frame(v, 1, &T[(n + copy[v]) * 4]);
+      }
+    }
+  }, pool);
+
+  parallelFor(triangles, 1 << 16, [&](size_t begin, size_t end) {
+    for (size_t t = begin; t < end; t++) {
+      if (handedness[t] != tangent::Reversed) continue;
+      for (int c = 0; c < 3; c++) {
+        size_t v = F[t * 3 + c];
+        if (used(v, 0)) F[t * 3 + c] = Index(n + copy[v]);
+      }
+    }
+  }, pool);
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+// Number scanner over a non null-terminated character range, e.g. a mapped file.
+struct TextScanner {
+  const char* p;
+  const char* end;
+
+  bool eof() const { return p >= end; }
+
+  static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v'; }
+  static bool isDigit(char c) { return unsigned(c - '0') < 10; }
+
+  // skip blanks on the current line
+  void skipBlank() {
+    while (p < end && isSpace(*p)) p++;
+  }
+
+  // skip blanks, newlines and '#' comments
+  void skipSpace() {
+    while (p < end) {
+      if (isSpace(*p) || *p == '\n') p++;
+      else if (*p == '#') skipLine();
+      else break;
+    }
+  }
+
+  // move past the next newline
+  void skipLine() {
+    const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    p = nl ? nl + 1 : end;
+  }
+
+  bool atLineEnd() {
+    skipBlank();
+    return p >= end || *p == '\n' || *p == '#';
+  }
+
+  template <typename Int>
+  bool parseInt(Int& out) {
+    if (p < end && *p == '+') p++;
+    auto [ptr, ec] = std::from_chars(p, end, out);
+    if (ec != std::errc()) return false;
+    p = ptr;
+    return true;
+  }
+
+  // Clinger's fast path: exact when the mantissa fits in 53 bits and
+  // |exponent| <= 22, otherwise defer to strtod for correct rounding.
+  bool parseDouble(double& out) {
+    static constexpr double pow10[] = {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char* start = p;
+    const char* q = p;
+    bool negative = false;
+    if (q < end && (*q == '-' || *q == '+')) negative = *q++ == '-';
+
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool any = false;
+    for (; q < end && isDigit(*q); q++, any = true) {
+      if (digits < 19) { mantissa = mantissa * 10 + (*q - '0'); if (mantissa) digits++; }
+      else exponent++;
+    }
+    if (q < end && *q == '.') {
+      for (q++; q < end && isDigit(*q); q++, any = true) {
+        if (digits < 19) { mantissa = mantissa * 10 + (*q - '0'); if (mantissa) digits++; exponent--; }
+      }
+    }
+    if (!any) return slowDouble(start, out);
+
+    if (q < end && (*q == 'e' || *q == 'E')) {
+      const char* e = q + 1;
+      bool eNegative = false;
+      if (e < end && (*e == '-' || *e == '+')) eNegative = *e++ == '-';
+      if (e < end && isDigit(*e)) {
+        int value = 0;
+        for (; e < end && isDigit(*e); e++) if (value < 100000) value = value * 10 + (*e - '0');
+        exponent += eNegative ? -value : value;
+        q = e;
+      }
+    }
+
+    if (mantissa > (uint64_t(1) << 53) || exponent < -22 || exponent > 22)
+      return slowDouble(start, out);
+
+    double value = double(mantissa);
+    value = exponent < 0 ? value / pow10[-exponent] : value * pow10[exponent];
+    out = negative ? -value : value;
+    p = q;
+    return true;
+  }
+
+  template <typename Scalar>
+  bool parseFloat(Scalar& out) {
+    double value;
+    if (!parseDouble(value)) return false;
+    out = static_cast<Scalar>(value);
+    return true;
+  }
+
+private:
+  bool slowDouble(const char* start, double& out) {
+    char buf[128];
+    size_t n = 0;
+    while (start + n < end && n < sizeof(buf) - 1 && !isSpace(start[n]) && start[n] != '\n') n++;
+    std::memcpy(buf, start, n);
+    buf[n] = '\0';
+    char* stop;
+    out = std::strtod(buf, &stop);
+    if (stop == buf) return false;
+    p = start + (stop - buf);
+    return true;
+  }
+};
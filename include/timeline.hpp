@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Named time spans recorded from any thread, relative to the creation of the
+// timeline, for looking at how startup work overlaps.
+class Timeline {
+public:
+  struct Span {
+    std::string name;
+    double begin;
+    double end;
+    std::thread::id thread;
+  };
+
+  // Records the enclosing scope as a span.
+  class Scope {
+  public:
+    Scope(const char* name, Timeline& timeline = Timeline::shared())
+      : timeline(timeline), name(name), begin(timeline.now()) {}
+    ~Scope() { timeline.add(name, begin, timeline.now()); }
+
+  private:
+    Timeline& timeline;
+    const char* name;
+    double begin;
+  };
+
+  static Timeline& shared() {
+    static Timeline timeline;
+    return timeline;
+  }
+
+  // seconds since the timeline was created
+  double now() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  void add(const std::string& name, double begin, double end) {
+    std::lock_guard lock(mutex);
+    spans.push_back({ name, begin, end, std::this_thread::get_id() });
+  }
+
+  std::vector<Span> sorted() const {
+    std::lock_guard lock(mutex);
+    std::vector<Span> out = spans;
+    std::sort(out.begin(), out.end(), [](auto& a, auto& b) { return a.begin < b.begin; });
+    return out;
+  }
+
+  // One line per span with a bar on a shared time axis and its thread number.
+  void print(FILE* out = stderr, int width = 50) const {
+    auto all = sorted();
+    double total = 0;
+    std::vector<std::thread::id> threads;
+    for (auto& s : all) {
+      total = std::max(total, s.end);
+      if (std::find(threads.begin(), threads.end(), s.thread) == threads.end()) threads.push_back(s.thread);
+    }
+    for (auto& s : all) {
+      int a = total > 0 ? int(s.begin / total * width) : 0;
+      int b = total > 0 ? std::max(a + 1, int(s.end / total * width)) : 1;
+      std::string bar = std::string(a, ' ') + std::string(b - a, '#') + std::string(std::max(width - b, 0), ' ');
+      long thread = std::find(threads.begin(), threads.end(), s.thread) - threads.begin();
+      fprintf(out, "%-20s |%s| %8.2f - %8.2f ms  thread %ld\n", s.name.c_str(), bar.c_str(), s.begin * 1e3, s.end * 1e3, thread);
+    }
+  }
+
+private:
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  mutable std::mutex mutex;
+  std::vector<Span> spans;
+};
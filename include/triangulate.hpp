@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "parallel.hpp"
+
+// Storage reused by triangulatePolygon across the polygons of a chunk, so
+// only the largest of them allocates.
+struct PolygonScratch {
+  std::vector<double> x, y;
+  std::vector<uint32_t> prev, next;
+};
+
+// Writes the n - 2 triangles of polygon P (n corners indexing V) to T, keeping
+// the winding of the polygon. Quads are split along their shorter diagonal,
+// or the one inside them when they are concave. Other convex polygons are
+// fanned, concave ones are ear clipped in the plane of their Newell normal.
+template <typename Scalar, typename Index>
+inline void triangulatePolygon(const Scalar* V, const Index* P, uint32_t n, Index* T, PolygonScratch& scratch) {
+  if (n < 3) return;
+  if (n == 3) {
+    T[0] = P[0]; T[1] = P[1]; T[2] = P[2];
+    return;
+  }
+
+  if (n == 4) {
+    double p[4][3];
+    for (int i = 0; i < 4; i++)
+      for (int k = 0; k < 3; k++) p[i][k] = V[size_t(P[i]) * 3 + k];
+    double ac[3], bd[3], normal[3];
+    for (int k = 0; k < 3; k++) ac[k] = p[2][k] - p[0][k], bd[k] = p[3][k] - p[1][k];
+    // the area vector of a quad is half the cross product of its diagonals
+    normal[0] = ac[1] * bd[2] - ac[2] * bd[1];
+    normal[1] = ac[2] * bd[0] - ac[0] * bd[2];
+    normal[2] = ac[0] * bd[1] - ac[1] * bd[0];
+    auto turn = [&](int a, int b, int c) {
+      double e1[3], e2[3];
+      for (int k = 0; k < 3; k++) e1[k] = p[b][k] - p[a][k], e2[k] = p[c][k] - p[a][k];
+      return (e1[1] * e2[2] - e1[2] * e2[1]) * normal[0] + (e1[2] * e2[0] - e1[0] * e2[2]) * normal[1] +
+        (e1[0] * e2[1] - e1[1] * e2[0]) * normal[2];
+    };
+    bool insideAC = turn(0, 1, 2) > 0 && turn(0, 2, 3) > 0;
+    bool insideBD = turn(0, 1, 3) > 0 && turn(1, 2, 3) > 0;
+    double lengthAC = ac[0] * ac[0] + ac[1] * ac[1] + ac[2] * ac[2];
+    double lengthBD = bd[0] * bd[0] + bd[1] * bd[1] + bd[2] * bd[2];
+    if (insideAC == insideBD ? lengthAC <= lengthBD : insideAC) {
+      T[0] = P[0]; T[1] = P[1]; T[2] = P[2];
+      T[3] = P[0]; T[4] = P[2]; T[5] = P[3];
+    }
+    else {
+      T[0] = P[0]; T[1] = P[1]; T[2] = P[3];
+      T[3] = P[1]; T[4] = P[2]; T[5] = P[3];
+    }
+    return;
+  }
+
+  double normal[3] = {};
+  for (uint32_t i = 0; i < n; i++) {
+    const Scalar* a = &V[size_t(P[i]) * 3];
+    const Scalar* b = &V[size_t(P[(i + 1) % n]) * 3];
+    normal[0] += (double(a[1]) - b[1]) * (double(a[2]) + b[2]);
+    normal[1] += (double(a[2]) - b[2]) * (double(a[0]) + b[0]);
+    normal[2] += (double(a[0]) - b[0]) * (double(a[1]) + b[1]);
+  }
+  // project onto the plane of the two axes orthogonal to the dominant one,
+  // choosing their order so the polygon is counter-clockwise in 2D
+  int axis = std::abs(normal[0]) > std::abs(normal[1]) ?
+    (std::abs(normal[0]) > std::abs(normal[2]) ? 0 : 2) :
+    (std::abs(normal[1]) > std::abs(normal[2]) ? 1 : 2);
+  int u = (axis + 1) % 3, v = (axis + 2) % 3;
+  if (normal[axis] < 0) std::swap(u, v);
+
+  std::vector<double>& x = scratch.x, & y = scratch.y;
+  x.resize(n), y.resize(n);
+  for (uint32_t i = 0; i < n; i++) {
+    x[i] = V[size_t(P[i]) * 3 + u];
+    y[i] = V[size_t(P[i]) * 3 + v];
+  }
+  auto cross = [&](uint32_t a, uint32_t b, uint32_t c) {
+    return (x[b] - x[a]) * (y[c] - y[a]) - (y[b] - y[a]) * (x[c] - x[a]);
+  };
+
+  bool convex = true;
+  for (uint32_t i = 0; i < n && convex; i++) convex = cross(i, (i + 1) % n, (i + 2) % n) >= 0;
+  if (convex) {
+    for (uint32_t i = 1; i + 1 < n; i++, T += 3) {
+      T[0] = P[0]; T[1] = P[i]; T[2] = P[i + 1];
+    }
+    return;
+  }
+
+  // the corners left form a ring linked through prev and next, so clipping
+  // an ear is constant time and the search goes on from where it was
+  std::vector<uint32_t>& prev = scratch.prev, & next = scratch.next;
+  prev.resize(n), next.resize(n);
+  for (uint32_t i = 0; i < n; i++) prev[i] = (i + n - 1) % n, next[i] = (i + 1) % n;
+  auto inside = [&](uint32_t p, uint32_t a, uint32_t b, uint32_t c) {
+    return cross(a, b, p) >= 0 && cross(b, c, p) >= 0 && cross(c, a, p) >= 0;
+  };
+
+  uint32_t m = n, b = 0;
+  for (uint32_t tried = 0; m > 3 && tried < m;) {
+    uint32_t a = prev[b], c = next[b];
+    bool ear = cross(a, b, c) > 0;
+    for (uint32_t p = next[c]; p != a && ear; p = next[p]) ear = !inside(p, a, b, c);
+    if (!ear) {
+      b = c, tried++;
+      continue;
+    }
+    T[0] = P[a]; T[1] = P[b]; T[2] = P[c];
+    T += 3;
+    next[a] = c, prev[c] = a;
+    b = c, m--, tried = 0;
+  }
+  // the last triangle, or a fan of what is left of a degenerate or
+  // self-intersecting polygon
+  for (uint32_t i = next[b]; next[i] != b; i = next[i], T += 3) {
+    T[0] = P[b]; T[1] = P[i]; T[2] = P[next[i]];
+  }
+}
+
+template <typename Scalar, typename Index>
+inline void triangulatePolygon(const Scalar* V, const Index* P, uint32_t n, Index* T) {
+  PolygonScratch scratch;
+  triangulatePolygon(V, P, n, T, scratch);
+}
+
+// Triangulates the polygons of F (valences in faceSizes) into the triangle
+// list T. The triangles of face f are faceTriangles[f] .. faceTriangles[f + 1];
+// faces with fewer than 3 corners produce none. Faces are processed in
+// chunks on the pool, each chunk writing its own range of T.
+template <typename Scalar, typename Index>
+inline void triangulate(
+  const std::vector<Scalar>& V,
+  const std::vector<Index>& F,
+  const std::vector<uint32_t>& faceSizes,
+  std::vector<Index>& T,
+  std::vector<uint32_t>& faceTriangles,
+  size_t grain = size_t(1) << 16,
+  ThreadPool& pool = ThreadPool::shared())
+{
+  grain = std::max<size_t>(grain, 1);
+  size_t n = faceSizes.size();
+  size_t chunks = (n + grain - 1) / grain;
+
+  std::vector<uint64_t> chunkIndices(chunks + 1, 0), chunkTriangles(chunks + 1, 0);
+  pool.run(chunks, [&](size_t c, unsigned) {
+    uint64_t indices = 0, triangles = 0;
+    for (size_t f = c * grain, end = std::min(n, f + grain); f < end; f++) {
+      indices += faceSizes[f];
+      triangles += faceSizes[f] < 3 ? 0 : faceSizes[f] - 2;
+    }
+    chunkIndices[c + 1] = indices;
+    chunkTriangles[c + 1] = triangles;
+  });
+  for (size_t c = 0; c < chunks; c++) {
+    chunkIndices[c + 1] += chunkIndices[c];
+    chunkTriangles[c + 1] += chunkTriangles[c];
+  }
+
+  T.resize(chunkTriangles[chunks] * 3);
+  faceTriangles.resize(n + 1);
+  faceTriangles[n] = chunkTriangles[chunks];
+  pool.run(chunks, [&](size_t c, unsigned) {
+    uint64_t index = chunkIndices[c], triangle = chunkTriangles[c];
+    PolygonScratch scratch;
+    for (size_t f = c * grain, end = std::min(n, f + grain); f < end; f++) {
+      faceTriangles[f] = triangle;
+      triangulatePolygon(V.data(), F.data() + index, faceSizes[f], T.data() + triangle * 3, scratch);
+      index += faceSizes[f];
+      triangle += faceSizes[f] < 3 ? 0 : faceSizes[f] - 2;
+    }
+  });
+}
+
+// Whether every face is already a triangle.
+inline bool isTriangleMesh(const std::vector<uint32_t>& faceSizes) {
+  for (auto size : faceSizes)
+    if (size != 3) return false;
+  return true;
+}
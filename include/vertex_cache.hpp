@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Reordering of triangle lists for the post-transform vertex cache, and the
+// metrics to see the effect without a GPU. Caches are modelled as FIFOs of
+// `cacheSize` vertices, which is what Tipsify assumes and close to how
+// current GPUs reuse shaded vertices within a batch.
+namespace vcache {
+  struct Statistics {
+    size_t transformed = 0;  // cache misses
+    double acmr = 0;         // misses per triangle, 0.5 at best, 3 at worst
+    double atvr = 0;         // misses per referenced vertex, 1 at best
+  };
+
+  // FIFO cache of `size` vertices that counts misses.
+  struct Fifo {
+    std::vector<uint64_t> entered;
+    uint64_t time;
+    unsigned size;
+
+    Fifo(size_t vertexCount, unsigned size) : entered(vertexCount, 0), time(size + 1), size(size) {}
+
+    // a vertex is cached while time - entered <= size
+    bool miss(size_t v) {
+      if (time - entered[v] <= size) return false;
+      entered[v] = time++;
+      return true;
+    }
+
+    template <typename Index>
+    unsigned misses(const Index* triangle) { return miss(triangle[0]) + miss(triangle[1]) + miss(triangle[2]); }
+
+    void flush() { time += size + 1; }
+  };
+
+  // Simulates a FIFO cache over the `count` indices of I.
+  template <typename Index>
+  inline Statistics analyze(const Index* I, size_t count, size_t vertexCount, unsigned cacheSize = 16) {
+    Statistics stats;
+    if (count == 0) return stats;
+    Fifo cache(vertexCount, cacheSize);
+    std::vector<bool> used(vertexCount, false);
+    size_t referenced = 0;
+    for (size_t i = 0; i < count; i++) {
+      stats.transformed += cache.miss(I[i]);
+      if (!used[I[i]]) used[I[i]] = true, referenced++;
+    }
+    stats.acmr = double(stats.transformed) / (count / 3);
+    stats.atvr = double(stats.transformed) / referenced;
+    return stats;
+  }
+
+  template <typename Index>
+  inline Statistics analyze(const std::vector<Index>& I, size_t vertexCount, unsigned cacheSize = 16) {
+    return analyze(I.data(), I.size(), vertexCount, cacheSize);
+  }
+
+  // Tipsify (Sander, Nehab and Barczak 2007): fans around one vertex at a
+  // time and moves on to the neighbour that is still cached and has the
+  // fewest remaining triangles, in time linear in the index count. Writes
+  // the triangles of I to `out` (which must not alias I) in the new order,
+  // each with its corners in the original order so winding is kept.
+  template <typename Index>
+  inline void tipsify(const Index* I, size_t count, size_t vertexCount, Index* out, unsigned cacheSize = 16) {
+    size_t triangleCount = count / 3;
+    if (triangleCount == 0) return;
+
+    // triangles around every vertex
+    std::vector<uint32_t> live(vertexCount, 0), offsets(vertexCount + 1, 0), adjacency(triangleCount * 3);
+    for (size_t i = 0; i < triangleCount * 3; i++) live[I[i]]++;
+    for (size_t v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + live[v];
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < triangleCount * 3; i++) adjacency[fill[I[i]]++] = uint32_t(i / 3);
+    std::vector<uint32_t>().swap(fill);
+
+    Fifo cache(vertexCount, cacheSize);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnd, candidates;
+    deadEnd.reserve(triangleCount * 3);
+    size_t written = 0, cursor = 0;
+    int64_t fan = I[0];
+
+    while (fan >= 0) {
+      candidates.clear();
+      for (uint32_t a = offsets[fan]; a < offsets[fan + 1]; a++) {
+        uint32_t t = adjacency[a];
+        if (emitted[t]) continue;
+        emitted[t] = true;
+        for (int k = 0; k < 3; k++) {
+          Index v = I[t * 3 + k];
+          out[written++] = v;
+          deadEnd.push_back(uint32_t(v));
+          candidates.push_back(uint32_t(v));
+          live[v]--;
+          cache.miss(v);
+        }
+      }
+
+      // the candidate that stays in the cache through its remaining
+      // triangles and has been there longest
+      fan = -1;
+      int64_t best = -1;
+      for (uint32_t v : candidates) {
+        if (live[v] == 0) continue;
+        int64_t priority = 0;
+        uint64_t age = cache.time - cache.entered[v];
+        if (age + 2 * live[v] <= cacheSize) priority = int64_t(age);
+        if (priority > best) best = priority, fan = v;
+      }
+      if (fan >= 0) continue;
+
+      // a dead end: back to a recent vertex, or on to the next unfinished one
+      while (!deadEnd.empty() && fan < 0) {
+        uint32_t v = deadEnd.back();
+        deadEnd.pop_back();
+        if (live[v] > 0) fan = v;
+      }
+      while (fan < 0 && cursor < vertexCount)
+        if (live[cursor++] > 0) fan = int64_t(cursor - 1);
+    }
+  }
+}
+
+// Reorders the triangle list F over `vertexCount` vertices for vertex reuse.
+template <typename Index>
+inline void optimizeVertexCache(std::vector<Index>& F, size_t vertexCount, unsigned cacheSize = 16) {
+  std::vector<Index> reordered(F.size());
+  vcache::tipsify(F.data(), F.size(), vertexCount, reordered.data(), cacheSize);
+  F.swap(reordered);
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "parallel.hpp"
+#include "read_off.hpp"
+#include "vertex_cache.hpp"
+
+// Vertex order for fetch locality: vertices are renumbered in the order the
+// index buffer first uses them, so that drawing, or any pass walking the
+// triangles, reads the vertex streams nearly sequentially.
+namespace vfetch {
+  struct Statistics {
+    double distance = 0;  // mean distance in vertices between consecutive fetches
+    double overfetch = 0; // bytes read per byte of referenced vertex data, 1 at best
+  };
+
+  // Follows the vertices fetched, those missing a post-transform cache of
+  // `cacheSize` entries. The distance is between each fetch and the one
+  // before; overfetch counts the 64 byte lines read through a 16 KB cache,
+  // with vertices of `stride` bytes. Overfetch is the one to optimize for:
+  // on a regular grid the cache order sweeps bands several rows wide, and
+  // the jump back to the previous band grows with the band in first-use
+  // order, while those vertices are still in cached lines.
+  template <typename Index>
+  inline Statistics analyze(const Index* I, size_t count, size_t vertexCount, size_t stride = 12, unsigned cacheSize = 16) {
+    constexpr size_t line = 64;
+    Statistics stats;
+    vcache::Fifo cache(vertexCount, cacheSize), lines((vertexCount * stride + line - 1) / line + 1, 16384 / line);
+    std::vector<bool> used(vertexCount, false);
+    double sum = 0;
+    size_t fetches = 0, referenced = 0, read = 0;
+    Index last = 0;
+    for (size_t i = 0; i < count; i++) {
+      if (!cache.miss(I[i])) continue;
+      if (fetches++) sum += I[i] > last ? I[i] - last : last - I[i];
+      last = I[i];
+      if (!used[I[i]]) used[I[i]] = true, referenced++;
+      for (size_t l = I[i] * stride / line; l <= (I[i] * stride + stride - 1) / line; l++) read += lines.miss(l);
+    }
+    stats.distance = fetches > 1 ? sum / (fetches - 1) : 0;
+    stats.overfetch = referenced ? double(read * line) / (referenced * stride) : 0;
+    return stats;
+  }
+
+  template <typename Index>
+  inline Statistics analyze(const std::vector<Index>& I, size_t vertexCount, size_t stride = 12, unsigned cacheSize = 16) {
+    return analyze(I.data(), I.size(), vertexCount, stride, cacheSize);
+  }
+
+  // New index of every vertex in first-use order; unused vertices follow in
+  // their old order.
+  template <typename Index>
+  inline std::vector<uint32_t> remap(const Index* I, size_t count, size_t vertexCount) {
+    constexpr uint32_t unused = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> remap(vertexCount, unused);
+    uint32_t next = 0;
+    for (size_t i = 0; i < count; i++)
+      if (remap[I[i]] == unused) remap[I[i]] = next++;
+    for (auto& r : remap)
+      if (r == unused) r = next++;
+    return remap;
+  }
+
+  // Moves element i of a stream of `components` values per vertex to remap[i].
+  template <typename T>
+  inline void permute(std::vector<T>& stream, const std::vector<uint32_t>& remap, size_t components,
+    ThreadPool& pool = ThreadPool::shared()) {
+    if (stream.empty()) return;
+    std::vector<T> permuted(stream.size());
+    parallelFor(remap.size(), 1 << 16, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++)
+        for (size_t k = 0; k < components; k++) permuted[size_t(remap[i]) * components + k] = stream[i * components + k];
+    }, pool);
+    stream.swap(permuted);
+  }
+}
+
+// Renumbers the vertices of F in first-use order, permuting the positions V
+// (xyz triples) and the per-vertex normals and colors in `attributes` to
+// match. The new order is kept only when it lowers the overfetch measured by
+// vfetch::analyze: an index buffer already in cache order over a regular
+// grid can read more lines renumbered than in its input order. Returns
+// whether the vertices were renumbered.
+template <typename Scalar, typename Index>
+inline bool optimizeVertexFetch(
+  std::vector<Index>& F,
+  std::vector<Scalar>& V,
+  std::type_identity_t<OFFAttributes<Scalar>>* attributes = nullptr,
+  ThreadPool& pool = ThreadPool::shared())
+{
+  size_t n = V.size() / 3;
+  std::vector<uint32_t> remap = vfetch::remap(F.data(), F.size(), n);
+  std::vector<Index> R(F.size());
+  parallelFor(F.size(), 1 << 16, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) R[i] = Index(remap[F[i]]);
+  }, pool);
+  if (vfetch::analyze(R, n).overfetch >= vfetch::analyze(F, n).overfetch) return false;
+
+  F.swap(R);
+  vfetch::permute(V, remap, 3, pool);
+  if (attributes) {
+    vfetch::permute(attributes->normals, remap, 3, pool);
+    vfetch::permute(attributes->colors, remap, 4, pool);
+  }
+  return true;
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "hash.hpp"
+#include "parallel.hpp"
+#include "read_off.hpp"
+
+// Merges vertices closer than an epsilon. Positions are binned into a hash
+// grid of 2 epsilon cells, so every neighbour within epsilon is in one of at
+// most 8 cells, and close pairs are joined in a lock-free union-find whose
+// roots are the lowest vertex index. Every phase runs in parallel and the
+// result does not depend on the thread count.
+namespace weld {
+  struct Stats {
+    size_t vertices = 0; // before
+    size_t welded = 0;   // after
+
+    size_t removed() const { return vertices - welded; }
+    double ratio() const { return vertices ? double(welded) / vertices : 1.; }
+  };
+
+  // Replaces a[i] by the sum of a[0..i) and returns the total.
+  inline uint64_t exclusiveScan(uint32_t* a, size_t n, ThreadPool& pool) {
+    constexpr size_t grain = 1 << 16;
+    std::vector<uint64_t> sums((n + grain - 1) / grain);
+    parallelFor(n, grain, [&](size_t begin, size_t end) {
+      uint64_t sum = 0;
+      for (size_t i = begin; i < end; i++) sum += a[i];
+      sums[begin / grain] = sum;
+    }, pool);
+    uint64_t total = 0;
+    for (auto& s : sums) total += std::exchange(s, total);
+    parallelFor(n, grain, [&](size_t begin, size_t end) {
+      uint64_t sum = sums[begin / grain];
+      for (size_t i = begin; i < end; i++) {
+        uint64_t v = a[i];
+        a[i] = uint32_t(sum);
+        sum += v;
+      }
+    }, pool);
+    return total;
+  }
+
+  class UnionFind {
+  public:
+    // Elements are ordered by key[x], which must be unique.
+    UnionFind(size_t n, const uint32_t* key) : parent(n), key(key) {
+      for (size_t i = 0; i < n; i++) parent[i].store(uint32_t(i), std::memory_order_relaxed);
+    }
+
+    uint32_t find(uint32_t x) {
+      for (;;) {
+        uint32_t p = parent[x].load(std::memory_order_relaxed);
+        if (p == x) return x;
+        uint32_t g = parent[p].load(std::memory_order_relaxed);
+        if (g != p) parent[x].compare_exchange_weak(p, g, std::memory_order_relaxed);
+        x = g;
+      }
+    }
+
+    // Links the larger root under the smaller one, so every set ends up
+    // rooted at its lowest key whatever the order of the calls.
+    void unite(uint32_t a, uint32_t b) {
+      for (;;) {
+        a = find(a), b = find(b);
+        if (a == b) return;
+        if (key[a] < key[b]) std::swap(a, b);
+        uint32_t expected = a;
+        if (parent[a].compare_exchange_strong(expected, b)) return;
+      }
+    }
+
+  private:
+    std::vector<std::atomic<uint32_t>> parent;
+    const uint32_t* key;
+  };
+
+  // Integer cell of a coordinate; an epsilon of 0 keys on the exact value
+  // with -0 equal to 0.
+  inline int64_t cell(double x, double inverse) {
+    return inverse > 0 ? int64_t(std::floor(x * inverse)) : std::bit_cast<int64_t>(x + 0.);
+  }
+
+  inline uint64_t cellHash(int64_t x, int64_t y, int64_t z) {
+    // mixed one coordinate at a time; a plain xor of products would map
+    // mirrored exact keys, which differ in sign bits only, together
+    return hashMix(hashMix(hashMix(uint64_t(x)) ^ uint64_t(y)) ^ uint64_t(z));
+  }
+}
+
+// Welds the positions in V (xyz triples) that lie within `epsilon` of each
+// other, transitively, keeping the first vertex of every cluster. V and the
+// per-vertex normals and colors in `attributes` are compacted in order, F is
+// remapped; faces that collapse are left for the caller to drop.
+template <typename Scalar, typename Index>
+inline weld::Stats weldVertices(
+  std::vector<Scalar>& V,
+  std::vector<Index>& F,
+  std::type_identity_t<Scalar> epsilon = 0,
+  std::type_identity_t<OFFAttributes<Scalar>>* attributes = nullptr,
+  ThreadPool& pool = ThreadPool::shared())
+{
+  constexpr size_t grain = 1 << 16;
+  size_t n = V.size() / 3;
+  weld::Stats stats{ n, n };
+  if (n < 2) return stats;
+
+  double inverse = epsilon > 0 ? .5 / double(epsilon) : 0, eps2 = double(epsilon) * epsilon;
+
+  // bin every vertex by the bucket of its cell: a stable partition on the top
+  // 8 bucket bits, then a counting sort of each partition, so that neither
+  // pass writes to more than a few hundred places at a time
+  constexpr size_t partitions = 256;
+  size_t buckets = std::max(std::bit_ceil(n), partitions), shift = std::countr_zero(buckets) - 8;
+  size_t chunks = (n + grain - 1) / grain;
+  std::vector<uint32_t> bucket(n), start(chunks * partitions);
+  parallelFor(n, grain, [&](size_t begin, size_t end) {
+    uint32_t* count = &start[begin / grain * partitions];
+    for (size_t i = begin; i < end; i++) {
+      int64_t c[3];
+      for (int k = 0; k < 3; k++) c[k] = weld::cell(V[i * 3 + k], inverse);
+      bucket[i] = uint32_t(weld::cellHash(c[0], c[1], c[2]) & (buckets - 1));
+      count[bucket[i] >> shift]++;
+    }
+  }, pool);
+  std::vector<uint32_t> partitionStart(partitions + 1, uint32_t(n));
+  uint32_t sum = 0;
+  for (size_t p = 0; p < partitions; p++) {
+    partitionStart[p] = sum;
+    for (size_t c = 0; c < chunks; c++) sum += std::exchange(start[c * partitions + p], sum);
+  }
+  struct Entry {
+    uint32_t id, bucket;
+    Scalar p[3];
+  };
+  std::vector<Entry> partitioned(n);
+  parallelFor(n, grain, [&](size_t begin, size_t end) {
+    uint32_t* cursor = &start[begin / grain * partitions];
+    for (size_t i = begin; i < end; i++) {
+      Entry& e = partitioned[cursor[bucket[i] >> shift]++];
+      e.id = uint32_t(i), e.bucket = bucket[i];
+      std::copy_n(&V[i * 3], 3, e.p);
+    }
+  }, pool);
+  std::vector<uint32_t>().swap(start);
+  std::vector<uint32_t>().swap(bucket);
+
+  // positions are copied next to their ids so that probing a bucket reads
+  // contiguous memory
+  std::vector<uint32_t> offsets(buckets + 1, uint32_t(n)), ids(n);
+  std::vector<Scalar> binned(n * 3);
+  pool.run(partitions, [&](size_t p, unsigned) {
+    uint32_t* offset = &offsets[p << shift];
+    size_t size = size_t(1) << shift;
+    std::fill_n(offset, size, 0);
+    for (uint32_t s = partitionStart[p]; s < partitionStart[p + 1]; s++) offset[partitioned[s].bucket & (size - 1)]++;
+    uint32_t sum = partitionStart[p];
+    for (size_t b = 0; b < size; b++) sum += std::exchange(offset[b], sum);
+    for (uint32_t s = partitionStart[p]; s < partitionStart[p + 1]; s++) {
+      const Entry& e = partitioned[s];
+      uint32_t slot = offset[e.bucket & (size - 1)]++;
+      ids[slot] = e.id;
+      std::copy_n(e.p, 3, &binned[size_t(slot) * 3]);
+    }
+    // every offset now ends its bucket, which is where the next one starts
+    std::copy_backward(offset, offset + size - 1, offset + size);
+    offset[0] = partitionStart[p];
+  });
+  std::vector<Entry>().swap(partitioned);
+
+  // walk the bins in order and join every vertex with the close ones before
+  // it in its own bucket and with all close ones in the neighbouring cells
+  // that sort after its own; since closeness is symmetric this sees every
+  // pair at least once
+  weld::UnionFind sets(n, ids.data());
+  parallelFor(n, grain, [&](size_t begin, size_t end) {
+    uint64_t probed[27];
+    for (size_t s = begin; s < end; s++) {
+      const Scalar* p = &binned[s * 3];
+      auto join = [&](size_t t) {
+        const Scalar* q = &binned[t * 3];
+        double dx = double(p[0]) - q[0], dy = double(p[1]) - q[1], dz = double(p[2]) - q[2];
+        if (dx * dx + dy * dy + dz * dz <= eps2) sets.unite(uint32_t(s), uint32_t(t));
+      };
+      int64_t c[3], lo[3], hi[3];
+      for (int k = 0; k < 3; k++) {
+        c[k] = weld::cell(p[k], inverse);
+        lo[k] = weld::cell(double(p[k]) - epsilon, inverse);
+        hi[k] = weld::cell(double(p[k]) + epsilon, inverse);
+      }
+      uint64_t own = weld::cellHash(c[0], c[1], c[2]) & (buckets - 1);
+      for (size_t t = offsets[own]; t < s; t++) join(t);
+
+      int count = 0;
+      for (int64_t x = lo[0]; x <= hi[0]; x++)
+        for (int64_t y = lo[1]; y <= hi[1]; y++)
+          for (int64_t z = lo[2]; z <= hi[2]; z++) {
+            if (std::tie(x, y, z) <= std::tie(c[0], c[1], c[2])) continue;
+            uint64_t b = weld::cellHash(x, y, z) & (buckets - 1);
+            if (b == own || std::find(probed, probed + count, b) != probed + count) continue;
+            probed[count++] = b;
+            for (size_t t = offsets[b], e = offsets[b + 1]; t < e; t++) join(t);
+          }
+    }
+  }, pool);
+  std::vector<Scalar>().swap(binned);
+  std::vector<uint32_t>().swap(offsets);
+
+  // sets are of bin slots, rooted at the slot of their first vertex; roots
+  // keep their order and get consecutive ids
+  std::vector<uint32_t> root(n), remap(n);
+  parallelFor(n, grain, [&](size_t begin, size_t end) {
+    for (size_t s = begin; s < end; s++) root[ids[s]] = ids[sets.find(uint32_t(s))];
+  }, pool);
+  parallelFor(n, grain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) remap[i] = root[i] == i;
+  }, pool);
+  stats.welded = weld::exclusiveScan(remap.data(), n, pool);
+  if (stats.welded == n) return stats;
+
+  std::vector<Scalar> welded(stats.welded * 3);
+  OFFAttributes<Scalar> compact;
+  bool normals = attributes && !attributes->normals.empty(), colors = attributes && !attributes->colors.empty();
+  if (normals) compact.normals.resize(stats.welded * 3);
+  if (colors) compact.colors.resize(stats.welded * 4);
+  parallelFor(n, grain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      if (root[i] != i) continue;
+      size_t j = remap[i];
+      std::copy_n(&V[i * 3], 3, &welded[j * 3]);
+      if (normals) std::copy_n(&attributes->normals[i * 3], 3, &compact.normals[j * 3]);
+      if (colors) std::copy_n(&attributes->colors[i * 4], 4, &compact.colors[j * 4]);
+    }
+  }, pool);
+  parallelFor(F.size(), grain, [&](size_t begin, size_t end) {
+    for (size_t f = begin; f < end; f++) F[f] = Index(remap[root[F[f]]]);
+  }, pool);
+
+  V = std::move(welded);
+  if (normals) attributes->normals = std::move(compact.normals);
+  if (colors) attributes->colors = std::move(compact.colors);
+  return stats;
+}
@@ -6,6 +6,7 @@
 #include <webgpu.h>
 #include <wgpu.h>
 #include "sdl3webgpu.h"
+#include "timeline.hpp"
 
 void LogOutputFunction(void* userdata, int category, SDL_LogPriority priority, const char* message) {
   const char* priority_name = NULL;
@@ -80,10 +81,13 @@ namespace WGPU {
     Context(int w, int h, WGPUTextureFormat surfaceFormat = WGPUTextureFormat_BGRA8UnormSrgb)
       : surfaceFormat(surfaceFormat), aspect(float(w) / float(h)) {
       SDL_SetLogOutputFunction(LogOutputFunction, nullptr);
-      if (!SDL_Init(SDL_INIT_VIDEO)) throw std::runtime_error("SDL_Init failed");
+      {
+        Timeline::Scope scope("window");
+        if (!SDL_Init(SDL_INIT_VIDEO)) throw std::runtime_error("SDL_Init failed");
 
-      window = SDL_CreateWindow("Window", w, h, SDL_WINDOW_METAL);
-      if (window == nullptr) throw std::runtime_error("SDL_CreateWindow failed");
+        window = SDL_CreateWindow("Window", w, h, SDL_WINDOW_METAL);
+        if (window == nullptr) throw std::runtime_error("SDL_CreateWindow failed");
+      }
 
       int bbwidth, bbheight;
       SDL_GetWindowSizeInPixels(window, &bbwidth, &bbheight);
@@ -93,9 +97,16 @@ namespace WGPU {
       WGPUInstanceDescriptor descriptor{};
       WGPUInstance instance = wgpuCreateInstance(&descriptor);
       surface = SDL_GetWGPUSurface(instance, window);
-      WGPUAdapter adapter = requestAdapter(surface, instance);
+      WGPUAdapter adapter;
+      {
+        Timeline::Scope scope("adapter");
+        adapter = requestAdapter(surface, instance);
+      }
       wgpuInstanceRelease(instance);
-      device = requestDevice(adapter);
+      {
+        Timeline::Scope scope("device");
+        device = requestDevice(adapter);
+      }
       wgpuAdapterRelease(adapter);
 
       WGPUSurfaceConfiguration config{
@@ -407,6 +418,7 @@ namespace WGPU {
     WGPUPrimitiveState primitive;
     std::vector<VertexBuffer> vertexBuffers;
     WGPU::Buffer& indexBuffer;
+    WGPUIndexFormat indexFormat = WGPUIndexFormat_Uint16;
     uint32_t count;
   };
 
@@ -440,7 +452,7 @@ namespace WGPU {
         auto& buf = geom.vertexBuffers[i].buffer;
         wgpuRenderPassEncoderSetVertexBuffer(handle, i, buf.handle, 0, buf.size);
       }
-      wgpuRenderPassEncoderSetIndexBuffer(handle, geom.indexBuffer.handle, WGPUIndexFormat_Uint16, 0, geom.indexBuffer.size);
+      wgpuRenderPassEncoderSetIndexBuffer(handle, geom.indexBuffer.handle, geom.indexFormat, 0, geom.indexBuffer.size);
       wgpuRenderPassEncoderDrawIndexed(handle, geom.count, instanceCount, firstIndex, baseVertex, firstInstance);
     }
 
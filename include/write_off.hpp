@@ -0,0 +1,173 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "parallel.hpp"
+#include "read_off.hpp"
+
+// Growable output buffer that numbers are formatted into with to_chars.
+struct TextWriter {
+  std::vector<char> buf;
+  size_t size = 0;
+
+  void reserve(size_t bytes) {
+    if (size + bytes > buf.size()) buf.resize(std::max(buf.size() * 2, size + bytes));
+  }
+
+  template <typename Number>
+  void number(Number x) {
+    reserve(32);
+    size = std::to_chars(buf.data() + size, buf.data() + buf.size(), x).ptr - buf.data();
+  }
+
+  void put(char c) {
+    reserve(1);
+    buf[size++] = c;
+  }
+
+  void put(const void* data, size_t bytes) {
+    reserve(bytes);
+    std::memcpy(buf.data() + size, data, bytes);
+    size += bytes;
+  }
+
+  void bigEndian32(uint32_t x) {
+    char b[4] = { char(x >> 24), char(x >> 16), char(x >> 8), char(x) };
+    put(b, 4);
+  }
+
+  void bigEndianFloat(float x) {
+    uint32_t bits;
+    std::memcpy(&bits, &x, 4);
+    bigEndian32(bits);
+  }
+};
+
+// Formats `n` records in chunks of `grain` on the pool and writes the chunks
+// to the file in order. Only a couple of chunks per thread are held at once.
+template <typename Format>
+inline bool writeOFFChunks(FILE* file, size_t n, size_t grain, Format&& format, ThreadPool& pool) {
+  size_t chunks = (n + grain - 1) / grain;
+  size_t batch = pool.size() * 2;
+  std::vector<TextWriter> out(std::min(batch, chunks));
+  for (size_t first = 0; first < chunks; first += batch) {
+    size_t count = std::min(batch, chunks - first);
+    pool.run(count, [&](size_t i, unsigned) {
+      size_t begin = (first + i) * grain;
+      out[i].size = 0;
+      format(begin, std::min(begin + grain, n), out[i]);
+    });
+    for (size_t i = 0; i < count; i++)
+      if (fwrite(out[i].buf.data(), 1, out[i].size, file) != out[i].size) return false;
+  }
+  return true;
+}
+
+// Writes V and F as OFF, or as big-endian binary OFF when `binary` is set.
+// Attributes, when given, add normals (NOFF), colors (COFF) and polygon
+// valences; without valences every face is a triangle. Numbers are written
+// in their shortest round-trip form, so readOFF gives back the same values.
+template <typename Scalar, typename Index>
+inline bool writeOFF(
+  const std::string file_name,
+  const std::vector<Scalar>& V,
+  const std::vector<Index>& F,
+  const std::type_identity_t<OFFAttributes<Scalar>>* attributes = nullptr,
+  bool binary = false,
+  size_t grain = size_t(1) << 16,
+  ThreadPool& pool = ThreadPool::shared())
+{
+  bool hasNormals = attributes && !attributes->normals.empty();
+  bool hasColors = attributes && !attributes->colors.empty();
+  const std::vector<uint32_t>* faceSizes = attributes && !attributes->faceSizes.empty() ? &attributes->faceSizes : nullptr;
+
+  int64_t numVertices = V.size() / 3;
+  int64_t numFaces = faceSizes ? faceSizes->size() : F.size() / 3;
+  if (faceSizes && std::accumulate(faceSizes->begin(), faceSizes->end(), uint64_t(0)) != F.size()) {
+    printf("writeOFF() failed, face sizes do not add up to %zu indices\n", F.size());
+    return false;
+  }
+  if ((hasNormals && attributes->normals.size() != V.size()) || (hasColors && attributes->colors.size() != V.size() / 3 * 4)) {
+    printf("writeOFF() failed, normals or colors do not match %lld vertices\n", (long long)numVertices);
+    return false;
+  }
+  grain = std::max<size_t>(grain, 1);
+
+  FILE* file = fopen(file_name.c_str(), "wb");
+  if (!file) {
+    printf("writeOFF() failed, cannot open %s\n", file_name.c_str());
+    return false;
+  }
+
+  TextWriter header;
+  std::string keyword = std::string(hasColors ? "C" : "") + (hasNormals ? "N" : "") + "OFF";
+  header.put(keyword.data(), keyword.size());
+  if (binary) {
+    header.put(" BINARY\n", 8);
+    header.bigEndian32(numVertices);
+    header.bigEndian32(numFaces);
+    header.bigEndian32(0);
+  }
+  else {
+    header.put('\n');
+    header.number(numVertices);
+    header.put(' ');
+    header.number(numFaces);
+    header.put(" 0\n", 3);
+  }
+  bool ok = fwrite(header.buf.data(), 1, header.size, file) == header.size;
+
+  ok = ok && writeOFFChunks(file, numVertices, grain, [&](size_t begin, size_t end, TextWriter& out) {
+    for (size_t i = begin; i < end; i++) {
+      const Scalar* v = &V[i * 3];
+      if (binary) {
+        for (int k = 0; k < 3; k++) out.bigEndianFloat(v[k]);
+        if (hasNormals) for (int k = 0; k < 3; k++) out.bigEndianFloat(attributes->normals[i * 3 + k]);
+        if (hasColors) for (int k = 0; k < 4; k++) out.bigEndianFloat(attributes->colors[i * 4 + k] / 255.f);
+        continue;
+      }
+      out.number(v[0]); out.put(' '); out.number(v[1]); out.put(' '); out.number(v[2]);
+      if (hasNormals)
+        for (int k = 0; k < 3; k++) out.put(' '), out.number(attributes->normals[i * 3 + k]);
+      if (hasColors)
+        for (int k = 0; k < 4; k++) out.put(' '), out.number(int(attributes->colors[i * 4 + k]));
+      out.put('\n');
+    }
+  }, pool);
+
+  // index offset of the first face of every chunk
+  size_t chunks = (numFaces + grain - 1) / grain;
+  std::vector<size_t> offsets(chunks + 1, 0);
+  for (size_t c = 0; c < chunks; c++) {
+    size_t begin = c * grain, end = std::min<size_t>(begin + grain, numFaces), count = 0;
+    if (faceSizes) for (size_t f = begin; f < end; f++) count += (*faceSizes)[f];
+    else count = (end - begin) * 3;
+    offsets[c + 1] = offsets[c] + count;
+  }
+
+  ok = ok && writeOFFChunks(file, numFaces, grain, [&](size_t begin, size_t end, TextWriter& out) {
+    size_t index = offsets[begin / grain];
+    for (size_t f = begin; f < end; f++) {
+      uint32_t valence = faceSizes ? (*faceSizes)[f] : 3;
+      if (binary) {
+        out.bigEndian32(valence);
+        for (uint32_t j = 0; j < valence; j++) out.bigEndian32(F[index++]);
+        out.bigEndian32(0);
+        continue;
+      }
+      out.number(valence);
+      for (uint32_t j = 0; j < valence; j++) out.put(' '), out.number(uint64_t(F[index++]));
+      out.put('\n');
+    }
+  }, pool);
+
+  ok = fclose(file) == 0 && ok;
+  if (!ok) printf("writeOFF() failed, cannot write %s\n", file_name.c_str());
+  return ok;
+}
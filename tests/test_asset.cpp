@@ -0,0 +1,40 @@
+#include <catch2/catch_test_macros.hpp>
+#include <stdexcept>
+#include <thread>
+#include "asset.hpp"
+#include "mesh_cache.hpp"
+#include "read_off.hpp"
+
+#define DATA_DIR "../../data"
+
+TEST_CASE("asset loads on a worker thread", "") {
+  Timeline timeline;
+  auto caller = std::this_thread::get_id();
+  std::thread::id worker;
+  Asset<std::vector<float>> asset("load", [&] {
+    Timeline::Scope scope("parse", timeline);
+    worker = std::this_thread::get_id();
+    std::vector<float> V;
+    std::vector<uint32_t> F;
+    readOFF(DATA_DIR "/screwdriver.off", V, F);
+    return V;
+  });
+  {
+    Timeline::Scope scope("device", timeline);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  auto V = asset.get();
+  REQUIRE(!V.empty());
+  REQUIRE(worker != caller);
+
+  auto spans = timeline.sorted();
+  REQUIRE(spans.size() == 2);
+  REQUIRE(spans[0].begin <= spans[1].begin);
+  for (auto& s : spans) REQUIRE(s.begin <= s.end);
+}
+
+TEST_CASE("asset rethrows loader errors", "") {
+  Asset<MeshCache> asset("fail", []() -> MeshCache { throw std::runtime_error("readOFF failed"); });
+  REQUIRE_THROWS_AS(asset.get(), std::runtime_error);
+}
@@ -0,0 +1,161 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstring>
+#include "bvh.hpp"
+#include "generate.hpp"
+#include "hash.hpp"
+
+// Every triangle, for reference.
+static bvh::Hit bruteForce(const std::vector<float>& V, const std::vector<uint32_t>& F, const bvh::Ray& ray) {
+  bvh::Hit hit;
+  for (uint32_t t = 0; t < F.size() / 3; t++) {
+    float distance, u, v;
+    if (bvh::intersectTriangle(ray.origin, ray.direction, &V[F[t * 3] * 3], &V[F[t * 3 + 1] * 3], &V[F[t * 3 + 2] * 3], distance, u, v) &&
+      distance < hit.distance)
+      hit = { t, distance, u, v };
+  }
+  return hit;
+}
+
+static float random(uint64_t i) { return float(hashMix(i) % 20001) / 10000 - 1; }
+
+TEST_CASE("buildBvh", "") {
+  // large enough to be split in parallel at the top
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  prim::generate(prim::Sphere{ 80 }, V, F);
+  REQUIRE(F.size() / 3 > bvh::parallelTriangles);
+
+  ThreadPool pool(3);
+  bvh::Tree tree;
+  buildBvh(V, F, tree, pool);
+
+  // every triangle in one leaf, inside the box of its slot
+  std::vector<int> seen(F.size() / 3, 0);
+  for (const bvh::Node& node : tree.nodes)
+    for (size_t c = 0; c < bvh::arity; c++) {
+      REQUIRE(node.count[c] <= bvh::maxLeaf);
+      for (uint32_t j = node.first[c]; j < node.first[c] + node.count[c]; j++) {
+        uint32_t t = tree.triangles[j];
+        seen[t]++;
+        for (int corner = 0; corner < 3; corner++)
+          for (int k = 0; k < 3; k++) {
+            REQUIRE(V[F[t * 3 + corner] * 3 + k] >= node.min[k][c]);
+            REQUIRE(V[F[t * 3 + corner] * 3 + k] <= node.max[k][c]);
+          }
+      }
+    }
+  REQUIRE(std::count(seen.begin(), seen.end(), 1) == int(seen.size()));
+
+  // the same hits as testing every triangle, from outside and from inside
+  for (uint64_t i = 0; i < 200; i++) {
+    bvh::Ray ray;
+    float scale = i % 2 ? 3.f : .5f;
+    for (int k = 0; k < 3; k++) {
+      ray.origin[k] = random(i * 6 + k) * scale;
+      ray.direction[k] = random(i * 6 + 3 + k) - ray.origin[k] * .5f;
+    }
+    bvh::Hit hit, expected = bruteForce(V, F, ray);
+    bool found = bvh::intersect(tree, V.data(), F.data(), ray, hit);
+    REQUIRE(found == (expected.triangle != bvh::none));
+    REQUIRE(bvh::occluded(tree, V.data(), F.data(), ray) == found);
+    if (!found) continue;
+    REQUIRE(hit.distance == expected.distance);
+    // the barycentrics give back the point on the ray
+    const float* p[3] = { &V[F[hit.triangle * 3] * 3], &V[F[hit.triangle * 3 + 1] * 3], &V[F[hit.triangle * 3 + 2] * 3] };
+    for (int k = 0; k < 3; k++) {
+      float x = p[0][k] * (1 - hit.u - hit.v) + p[1][k] * hit.u + p[2][k] * hit.v;
+      REQUIRE(std::abs(x - (ray.origin[k] + ray.direction[k] * hit.distance)) < 1e-4f);
+    }
+  }
+
+  // straight at the center from outside, and away from the sphere
+  bvh::Ray ray{ { 0, 0, 4 }, { 0, 0, -2 } };
+  bvh::Hit hit;
+  REQUIRE(bvh::intersect(tree, V.data(), F.data(), ray, hit));
+  REQUIRE(std::abs(hit.distance - 1.5f) < 1e-3f);
+  ray.tmax = 1;
+  REQUIRE_FALSE(bvh::intersect(tree, V.data(), F.data(), ray, hit));
+  REQUIRE_FALSE(bvh::occluded(tree, V.data(), F.data(), ray));
+  ray.direction[2] = 2;
+  REQUIRE_FALSE(bvh::intersect(tree, V.data(), F.data(), ray, hit));
+  REQUIRE(hit.triangle == bvh::none);
+
+  // independent of the thread count
+  ThreadPool single(1);
+  bvh::Tree other;
+  buildBvh(V, F, other, single);
+  REQUIRE(other.triangles == tree.triangles);
+  REQUIRE(other.nodes.size() == tree.nodes.size());
+  REQUIRE(std::memcmp(other.nodes.data(), tree.nodes.data(), tree.nodes.size() * sizeof(bvh::Node)) == 0);
+}
+
+TEST_CASE("buildBvh small", "") {
+  // a single leaf, and nothing at all
+  std::vector<float> V = { 0, 0, 0, 1, 0, 0, 0, 1, 0 };
+  std::vector<uint32_t> F = { 0, 1, 2 };
+  bvh::Tree tree;
+  buildBvh(V, F, tree);
+  REQUIRE(tree.nodes.size() == 1);
+  bvh::Ray ray{ { .25f, .25f, -1 }, { 0, 0, 1 } };
+  bvh::Hit hit;
+  REQUIRE(bvh::intersect(tree, V.data(), F.data(), ray, hit));
+  REQUIRE(hit.triangle == 0);
+  REQUIRE(hit.distance == 1);
+  REQUIRE(hit.u == .25f);
+  REQUIRE(hit.v == .25f);
+
+  F.clear();
+  buildBvh(V, F, tree);
+  REQUIRE(tree.nodes.empty());
+  REQUIRE_FALSE(bvh::intersect(tree, V.data(), F.data(), ray, hit));
+}
+
+TEST_CASE("bvh::nearest", "") {
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  prim::generate(prim::Sphere{ 16 }, V, F);
+  bvh::Tree tree;
+  buildBvh(V, F, tree);
+
+  // the same distance as every triangle, inside, outside and on the surface
+  bvh::Nearest near;
+  for (uint64_t i = 0; i < 200; i++) {
+    float p[3];
+    float scale = i % 2 ? 3.f : .5f;
+    for (int k = 0; k < 3; k++) p[k] = random(i * 3 + k) * scale;
+    float expected = bvh::inf;
+    for (size_t t = 0; t < F.size(); t += 3)
+      expected = std::min(expected, bvh::squaredDistance(p, &V[F[t] * 3], &V[F[t + 1] * 3], &V[F[t + 2] * 3]));
+    near = {};
+    REQUIRE(bvh::nearest(tree, V.data(), F.data(), p, near));
+    REQUIRE(near.distance == std::sqrt(expected));
+    const uint32_t* f = &F[near.triangle * 3];
+    REQUIRE(bvh::squaredDistance(p, &V[f[0] * 3], &V[f[1] * 3], &V[f[2] * 3]) == expected);
+    // from a triangle further away, the same
+    near = { 0, std::sqrt(bvh::squaredDistance(p, &V[F[0] * 3], &V[F[1] * 3], &V[F[2] * 3])) };
+    REQUIRE(bvh::nearest(tree, V.data(), F.data(), p, near));
+    REQUIRE(near.distance == std::sqrt(expected));
+    // stopped early, still within what was asked
+    near = {};
+    REQUIRE(bvh::nearest(tree, V.data(), F.data(), p, near, 10));
+    REQUIRE(near.distance <= 10);
+  }
+  near = {};
+  REQUIRE(bvh::nearest(tree, V.data(), F.data(), &V[30], near));
+  REQUIRE(near.distance == 0);
+
+  // the regions of one triangle: its face, edges and corners
+  float a[3] = { 0, 0, 0 }, b[3] = { 1, 0, 0 }, c[3] = { 0, 1, 0 };
+  float face[3] = { .25f, .25f, 2 }, edge[3] = { .5f, -1, 0 }, hypotenuse[3] = { 1, 1, 0 }, corner[3] = { -1, -1, 0 };
+  REQUIRE(bvh::squaredDistance(face, a, b, c) == 4);
+  REQUIRE(bvh::squaredDistance(edge, a, b, c) == 1);
+  REQUIRE(std::abs(bvh::squaredDistance(hypotenuse, a, b, c) - .5f) < 1e-6f);
+  REQUIRE(bvh::squaredDistance(corner, a, b, c) == 2);
+
+  F.clear();
+  buildBvh(V, F, tree);
+  near = {};
+  REQUIRE_FALSE(bvh::nearest(tree, V.data(), F.data(), a, near));
+  REQUIRE(near.triangle == bvh::none);
+}
@@ -0,0 +1,72 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <filesystem>
+#include "generate.hpp"
+#include "read_off.hpp"
+
+// Signed volume enclosed by the triangles, positive when they face outwards.
+static double volume(const std::vector<float>& V, const std::vector<uint32_t>& F) {
+  double sum = 0;
+  for (size_t f = 0; f < F.size(); f += 3) {
+    const float* a = &V[F[f] * 3], * b = &V[F[f + 1] * 3], * c = &V[F[f + 2] * 3];
+    sum += a[0] * (double(b[1]) * c[2] - double(b[2]) * c[1]) -
+      a[1] * (double(b[0]) * c[2] - double(b[2]) * c[0]) +
+      a[2] * (double(b[0]) * c[1] - double(b[1]) * c[0]);
+  }
+  return sum / 6;
+}
+
+TEST_CASE("prim surfaces", "") {
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+
+  auto sphere = prim::Sphere::withTriangles(60000);
+  REQUIRE(sphere.triangleCount() == 6 * 2 * 71 * 71);
+  prim::generate(sphere, V, F);
+  REQUIRE(V.size() == sphere.vertexCount() * 3);
+  for (size_t i = 0; i < V.size(); i += 3)
+    REQUIRE(std::abs(V[i] * V[i] + V[i + 1] * V[i + 1] + V[i + 2] * V[i + 2] - 1) < 1e-5);
+  REQUIRE(std::abs(volume(V, F) - 4 * M_PI / 3) < 1e-2);
+
+  prim::Torus torus{ { 300, 100, true, true } };
+  prim::generate(torus, V, F);
+  REQUIRE(F.size() == 300 * 100 * 2 * 3);
+  for (auto i : F) REQUIRE(i < torus.vertexCount());
+  REQUIRE(std::abs(volume(V, F) - 2 * M_PI * M_PI * torus.radius * torus.tube * torus.tube) < 1e-2);
+
+  auto grid = prim::Grid::withTriangles(20000);
+  REQUIRE(grid.lattice.nx == 101);
+  prim::generate(grid, V, F);
+  for (size_t f = 0; f < F.size(); f += 3) {
+    const float* a = &V[F[f] * 3], * b = &V[F[f + 1] * 3], * c = &V[F[f + 2] * 3];
+    // facing +y
+    REQUIRE((c[0] - a[0]) * (b[2] - a[2]) - (c[2] - a[2]) * (b[0] - a[0]) > 0);
+  }
+
+  auto terrain = prim::Terrain::withTriangles(20000);
+  std::vector<float> T;
+  prim::generate(terrain, T, F);
+  float lo = 0, hi = 0;
+  for (size_t i = 0; i < T.size(); i += 3) {
+    REQUIRE(T[i] == V[i]);
+    lo = std::min(lo, T[i + 1]), hi = std::max(hi, T[i + 1]);
+  }
+  REQUIRE(hi - lo > terrain.height * .5f);
+  REQUIRE(hi - lo < terrain.height * 4);
+}
+
+TEST_CASE("prim writeOFF streams the surface", "") {
+  auto torus = prim::Torus::withTriangles(100000);
+  std::vector<float> V, R;
+  std::vector<uint32_t> F, G;
+  prim::generate(torus, V, F);
+
+  ThreadPool pool(3);
+  std::string path = (std::filesystem::temp_directory_path() / "torus.off").string();
+  for (bool binary : { false, true }) {
+    REQUIRE(prim::writeOFF(path, torus, binary, 1000, pool));
+    REQUIRE(readOFF(path, R, G));
+    REQUIRE(R == V);
+    REQUIRE(G == F);
+  }
+}
@@ -0,0 +1,94 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include "mesh_cache.hpp"
+#include "read_off.hpp"
+
+#define DATA_DIR "../../data"
+
+TEST_CASE("meshcache round trip", "") {
+  std::vector<float> V;
+  std::vector<uint16_t> F;
+  REQUIRE(readOFF(DATA_DIR "/screwdriver.off", V, F));
+
+  std::string path = (std::filesystem::temp_directory_path() / "screwdriver.mesh").string();
+  meshcache::Source source;
+  REQUIRE(meshcache::Source::of(DATA_DIR "/screwdriver.off", source));
+  REQUIRE(meshcache::write(path, source, {
+    {.semantic = meshcache::Position, .format = meshcache::Float32, .components = 3, .data = V.data(), .count = V.size() / 3 },
+    {.semantic = meshcache::Index, .format = meshcache::Uint16, .components = 1, .data = F.data(), .count = F.size() },
+    }));
+
+  MeshCache cache;
+  REQUIRE(cache.open(path));
+  REQUIRE(cache.verify());
+  REQUIRE(cache.header->vertexCount == 3395);
+  REQUIRE(cache.header->indexCount == 6786 * 3);
+  REQUIRE(cache.isFresh(DATA_DIR "/screwdriver.off"));
+
+  auto position = cache.find(meshcache::Position);
+  REQUIRE(position != nullptr);
+  REQUIRE(position->stride == 12);
+  REQUIRE(position->offset % meshcache::alignment == 0);
+  REQUIRE(std::memcmp(cache.data(*position), V.data(), position->size) == 0);
+
+  auto index = cache.find(meshcache::Index);
+  REQUIRE(index != nullptr);
+  REQUIRE(index->size == F.size() * 2);
+  REQUIRE(std::memcmp(cache.data(*index), F.data(), index->size) == 0);
+  REQUIRE(cache.find(meshcache::Normal) == nullptr);
+
+  for (int k = 0; k < 3; k++) {
+    float lo = V[k], hi = V[k];
+    for (size_t i = k; i < V.size(); i += 3) lo = std::min(lo, V[i]), hi = std::max(hi, V[i]);
+    REQUIRE(cache.header->boundsMin[k] == lo);
+    REQUIRE(cache.header->boundsMax[k] == hi);
+  }
+  REQUIRE(cache.header->pipeline == 0);
+
+  // the pipeline version passes through
+  REQUIRE(meshcache::write(path, source, {
+    {.semantic = meshcache::Position, .format = meshcache::Float32, .components = 3, .data = V.data(), .count = V.size() / 3 },
+    }, 7));
+  REQUIRE(cache.open(path));
+  REQUIRE(cache.header->pipeline == 7);
+}
+
+TEST_CASE("meshcache invalidation", "") {
+  auto dir = std::filesystem::temp_directory_path();
+  std::string sourcePath = (dir / "source.off").string();
+  std::string path = (dir / "source.mesh").string();
+  std::ofstream(sourcePath) << "OFF\n3 1 0\n0 0 0\n1 0 0\n0 1 0\n3 0 1 2\n";
+
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  REQUIRE(readOFF(sourcePath, V, F));
+  meshcache::Source source;
+  REQUIRE(meshcache::Source::of(sourcePath, source));
+  REQUIRE(meshcache::write(path, source, {
+    {.semantic = meshcache::Position, .format = meshcache::Float32, .components = 3, .data = V.data(), .count = 3 },
+    {.semantic = meshcache::Index, .format = meshcache::Uint32, .components = 1, .data = F.data(), .count = 3 },
+    }));
+
+  MeshCache cache;
+  REQUIRE(cache.open(path));
+  REQUIRE(cache.isFresh(sourcePath));
+
+  // touched but identical content
+  auto mtime = std::filesystem::last_write_time(sourcePath);
+  std::filesystem::last_write_time(sourcePath, mtime + std::chrono::seconds(10));
+  REQUIRE(cache.isFresh(sourcePath));
+
+  // same size, different content
+  std::ofstream(sourcePath) << "OFF\n3 1 0\n0 0 0\n2 0 0\n0 1 0\n3 0 1 2\n";
+  std::filesystem::last_write_time(sourcePath, mtime + std::chrono::seconds(20));
+  REQUIRE_FALSE(cache.isFresh(sourcePath));
+
+  // different size
+  std::ofstream(sourcePath) << "OFF\n3 1 0\n0 0 0\n1 0 0\n0 1 0\n3 0 2 1\n\n";
+  REQUIRE_FALSE(cache.isFresh(sourcePath));
+
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 16);
+  REQUIRE_FALSE(cache.open(path));
+  REQUIRE_FALSE(cache.open((dir / "missing.mesh").string()));
+}
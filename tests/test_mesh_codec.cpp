@@ -0,0 +1,104 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <filesystem>
+#include "mesh_codec.hpp"
+#include "read_off.hpp"
+
+#define DATA_DIR "../../data"
+
+TEST_CASE("meshcodec positions within half a step", "") {
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  REQUIRE(readOFF(DATA_DIR "/screwdriver.off", V, F));
+  size_t n = V.size() / 3;
+
+  auto b = meshcodec::bounds(V.data(), n);
+  std::vector<uint16_t> Q(n * 3);
+  meshcodec::quantizePositions(V.data(), n, b, Q.data());
+  std::vector<float> D(n * 3);
+  meshcodec::dequantizePositions(Q.data(), n, b, D.data());
+  for (size_t i = 0; i < D.size(); i++)
+    REQUIRE(std::abs(D[i] - V[i]) <= meshcodec::step(b, i % 3) * .5f + 1e-7f);
+
+  // a flat axis quantizes to its single value
+  std::vector<float> flat{ 1, 2, 3, 4, 2, 5, 7, 2, 6, 8, 2, 9, 10, 2, 11 };
+  b = meshcodec::bounds(flat.data(), 5);
+  Q.resize(15);
+  D.resize(15);
+  meshcodec::quantizePositions(flat.data(), 5, b, Q.data());
+  meshcodec::dequantizePositions(Q.data(), 5, b, D.data());
+  for (size_t i = 1; i < 15; i += 3) REQUIRE(D[i] == 2.f);
+}
+
+TEST_CASE("meshcodec octahedral normals", "") {
+  std::vector<float> N;
+  for (int i = 0; i < 64; i++)
+    for (int j = 0; j <= 32; j++) {
+      float phi = i * 2 * M_PI / 64, theta = j * M_PI / 32;
+      N.insert(N.end(), { std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta) });
+    }
+  size_t n = N.size() / 3;
+  std::vector<int16_t> Q(n * 2);
+  std::vector<float> D(n * 3);
+  meshcodec::octEncode(N.data(), n, Q.data());
+  meshcodec::octDecode(Q.data(), n, D.data());
+  for (size_t i = 0; i < n; i++) {
+    float dot = N[i * 3] * D[i * 3] + N[i * 3 + 1] * D[i * 3 + 1] + N[i * 3 + 2] * D[i * 3 + 2];
+    REQUIRE(dot > std::cos(1e-3f)); // under 0.06 degrees
+  }
+}
+
+TEST_CASE("meshcodec index round trip", "") {
+  std::vector<uint32_t> I;
+  for (uint32_t i = 0; i < 100000; i++) I.push_back((i * 7919u) % 70001u);
+  std::vector<uint8_t> encoded;
+  meshcodec::encodeIndices(I.data(), I.size(), encoded);
+  REQUIRE(encoded.size() < I.size() * 4);
+
+  std::vector<uint32_t> D(I.size());
+  REQUIRE(meshcodec::decodeIndices(encoded.data(), encoded.size(), I.size(), 70001, D.data()));
+  REQUIRE(D == I);
+
+  REQUIRE(!meshcodec::decodeIndices(encoded.data(), encoded.size(), I.size(), 70000, D.data()));
+  REQUIRE(!meshcodec::decodeIndices(encoded.data(), encoded.size() - 1, I.size(), 70001, D.data()));
+  REQUIRE(!meshcodec::decodeIndices(encoded.data(), encoded.size(), I.size() - 1, 70001, D.data()));
+
+  meshcodec::encodeIndices(I.data(), 0, encoded);
+  REQUIRE(meshcodec::decodeIndices(encoded.data(), encoded.size(), 0, 1, D.data()));
+}
+
+TEST_CASE("meshcodec encoded cache", "") {
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  REQUIRE(readOFF(DATA_DIR "/screwdriver.off", V, F));
+  size_t n = V.size() / 3;
+  std::vector<float> N(V.size());
+  for (size_t i = 0; i < n; i++) {
+    float l = std::sqrt(V[i * 3] * V[i * 3] + V[i * 3 + 1] * V[i * 3 + 1] + V[i * 3 + 2] * V[i * 3 + 2]);
+    for (int k = 0; k < 3; k++) N[i * 3 + k] = V[i * 3 + k] / l;
+  }
+
+  meshcodec::Encoded encoded;
+  meshcodec::encode(V.data(), n, N.data(), F.data(), F.size(), encoded);
+  std::string path = (std::filesystem::temp_directory_path() / "screwdriver.encoded.mesh").string();
+  meshcache::Source source;
+  REQUIRE(meshcache::Source::of(DATA_DIR "/screwdriver.off", source));
+  REQUIRE(meshcache::write(path, source, encoded.streams()));
+
+  MeshCache cache;
+  REQUIRE(cache.open(path));
+  REQUIRE(cache.verify());
+  REQUIRE(cache.header->vertexCount == n);
+  REQUIRE(cache.header->indexCount == F.size());
+  REQUIRE(cache.header->boundsMin[0] == encoded.bounds.v[0]);
+  REQUIRE(cache.file.size < n * 24 + F.size() * 2);
+
+  meshcodec::Decoded decoded;
+  REQUIRE(meshcodec::decode(cache, decoded));
+  REQUIRE(!decoded.indices.isWide());
+  for (size_t i = 0; i < F.size(); i++) REQUIRE(decoded.indices[i] == F[i]);
+  for (size_t i = 0; i < V.size(); i++) {
+    REQUIRE(std::abs(decoded.positions[i] - V[i]) <= meshcodec::step(encoded.bounds, i % 3));
+    REQUIRE(std::abs(decoded.normals[i] - N[i]) < 1e-3f);
+  }
+}
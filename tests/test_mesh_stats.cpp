@@ -0,0 +1,96 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstring>
+#include "generate.hpp"
+#include "hash.hpp"
+#include "mesh_stats.hpp"
+
+TEST_CASE("computeMeshStats", "") {
+  // several chunks and a vertex count that leaves a short tail of lanes
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  prim::generate(prim::Torus::withTriangles(300000), V, F);
+  V.insert(V.end(), { 5, -7, .5f });
+  size_t n = V.size() / 3;
+  REQUIRE(n > meshstats::chunkVertices * 2);
+  REQUIRE(n % 4 != 0);
+  std::vector<float> A(n), B(n * 2), C(n * 4);
+  for (size_t i = 0; i < n; i++) A[i] = float(hashMix(i) % 1000) - 300;
+  for (size_t i = 0; i < B.size(); i++) B[i] = float(hashMix(i + n) % 1000) / 7;
+  for (size_t i = 0; i < C.size(); i++) C[i] = float(i % 5) - float(i % 3) * .5f;
+
+  ThreadPool pool(3);
+  std::vector<meshstats::Stream> attributes{ { A.data(), 1 }, { B.data(), 2 }, { C.data(), 4 } };
+  MeshStats stats = computeMeshStats(V, attributes, pool);
+  REQUIRE(stats.vertexCount == n);
+  REQUIRE(stats.attributes.size() == 3);
+
+  auto check = [&](const meshstats::Range& range, const float* data, uint32_t c) {
+    for (uint32_t k = 0; k < c; k++) {
+      float min = data[k], max = data[k];
+      double sum = 0;
+      for (size_t i = 0; i < n; i++) {
+        min = std::min(min, data[i * c + k]), max = std::max(max, data[i * c + k]);
+        sum += data[i * c + k];
+      }
+      REQUIRE(range.min[k] == min);
+      REQUIRE(range.max[k] == max);
+      REQUIRE(std::abs(range.mean[k] - sum / n) < 1e-5 * (1 + std::abs(sum / n)));
+    }
+    for (uint32_t k = c; k < meshstats::maxComponents; k++) REQUIRE(range.min[k] == 0);
+  };
+  check(stats.positions, V.data(), 3);
+  check(stats.attributes[0], A.data(), 1);
+  check(stats.attributes[1], B.data(), 2);
+  check(stats.attributes[2], C.data(), 4);
+
+  // the sphere holds every vertex and is not much larger than the box
+  const auto& s = stats.sphere;
+  for (size_t i = 0; i < n; i++) {
+    float d2 = 0;
+    for (int k = 0; k < 3; k++) d2 += (V[i * 3 + k] - s.center[k]) * (V[i * 3 + k] - s.center[k]);
+    REQUIRE(std::sqrt(d2) <= s.radius);
+  }
+  float diagonal = 0;
+  for (int k = 0; k < 3; k++) diagonal += std::pow(stats.positions.max[k] - stats.positions.min[k], 2.f);
+  REQUIRE(s.radius < std::sqrt(diagonal) / 2 * 1.1f);
+
+  // independent of the thread count
+  ThreadPool single(1);
+  MeshStats other = computeMeshStats(V, attributes, single);
+  REQUIRE(std::memcmp(&other.positions, &stats.positions, sizeof(meshstats::Range)) == 0);
+  REQUIRE(std::memcmp(&other.sphere, &stats.sphere, sizeof(meshstats::Sphere)) == 0);
+  for (size_t a = 0; a < 3; a++)
+    REQUIRE(std::memcmp(&other.attributes[a], &stats.attributes[a], sizeof(meshstats::Range)) == 0);
+}
+
+TEST_CASE("computeMeshStats sphere", "") {
+  // close to the unit sphere around the vertices of a sphere, after
+  // normalizing as well
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  prim::generate(prim::Sphere{ 80 }, V, F);
+  for (size_t i = 0; i < V.size(); i++) V[i] = V[i] * 2 + 1;
+  MeshStats stats = computeMeshStats(V);
+  REQUIRE(stats.attributes.empty());
+  REQUIRE(stats.sphere.radius >= 2);
+  REQUIRE(stats.sphere.radius < 2 * 1.02f);
+
+  float offset[3] = { 1, 1, 1 };
+  stats.normalize(offset, 2);
+  for (size_t i = 0; i < V.size(); i++) V[i] = (V[i] - offset[i % 3]) / 2;
+  MeshStats normalized = computeMeshStats(V);
+  for (int k = 0; k < 3; k++) {
+    REQUIRE(stats.positions.min[k] == normalized.positions.min[k]);
+    REQUIRE(stats.positions.max[k] == normalized.positions.max[k]);
+    REQUIRE(std::abs(stats.positions.mean[k] - normalized.positions.mean[k]) < 1e-6f);
+    REQUIRE(std::abs(stats.sphere.center[k]) < .02f);
+  }
+  REQUIRE(stats.sphere.radius >= 1);
+  REQUIRE(stats.sphere.radius < 1.02f);
+
+  // nothing to measure
+  MeshStats empty = computeMeshStats({});
+  REQUIRE(empty.vertexCount == 0);
+  REQUIRE(empty.sphere.radius == 0);
+}
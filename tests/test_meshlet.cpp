@@ -0,0 +1,71 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include "generate.hpp"
+#include "meshlet.hpp"
+#include "vertex_cache.hpp"
+
+TEST_CASE("buildMeshlets", "") {
+  // more than one chunk of triangles
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  prim::generate(prim::Sphere{ 80 }, V, F);
+  REQUIRE(F.size() / 3 > meshlet::chunkTriangles);
+  optimizeVertexCache(F, V.size() / 3);
+
+  ThreadPool pool(3);
+  meshlet::Meshlets out;
+  buildMeshlets(V, F, out, 64, 124, pool);
+  REQUIRE(out.bounds.size() == out.meshlets.size());
+
+  // the triangles come back in order
+  size_t t = 0, cones = 0;
+  for (size_t i = 0; i < out.meshlets.size(); i++) {
+    const auto& m = out.meshlets[i];
+    REQUIRE(m.vertexCount <= 64);
+    REQUIRE(m.triangleCount <= 124);
+    REQUIRE(size_t(m.triangleOffset) * 3 == t);
+    for (uint32_t j = 0; j < m.triangleCount * 3; j++, t++) {
+      uint8_t local = out.triangles[size_t(m.triangleOffset) * 3 + j];
+      REQUIRE(local < m.vertexCount);
+      REQUIRE(out.vertices[m.vertexOffset + local] == F[t]);
+    }
+
+    const auto& b = out.bounds[i];
+    for (uint32_t j = 0; j < m.vertexCount; j++) {
+      const float* p = &V[out.vertices[m.vertexOffset + j] * 3];
+      float d[3] = { p[0] - b.center[0], p[1] - b.center[1], p[2] - b.center[2] };
+      REQUIRE(d[0] * d[0] + d[1] * d[1] + d[2] * d[2] <= b.radius * b.radius * (1 + 1e-5f));
+    }
+    // an eye behind the apex sees every triangle from the back
+    if (b.cutoff == 1) continue;
+    cones++;
+    float eye[3] = { b.apex[0] - b.axis[0], b.apex[1] - b.axis[1], b.apex[2] - b.axis[2] };
+    REQUIRE(b.backfacing(eye));
+    float front[3] = { b.center[0] + b.axis[0], b.center[1] + b.axis[1], b.center[2] + b.axis[2] };
+    REQUIRE(!b.backfacing(front));
+    for (uint32_t j = 0; j < m.triangleCount; j++) {
+      const float* p[3];
+      for (int k = 0; k < 3; k++) p[k] = &V[out.vertices[m.vertexOffset + out.triangles[(m.triangleOffset + j) * 3 + k]] * 3];
+      float e1[3], e2[3];
+      for (int k = 0; k < 3; k++) e1[k] = p[1][k] - p[0][k], e2[k] = p[2][k] - p[0][k];
+      float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+      REQUIRE(n[0] * (p[0][0] - eye[0]) + n[1] * (p[0][1] - eye[1]) + n[2] * (p[0][2] - eye[2]) >= 0);
+    }
+  }
+  REQUIRE(t == F.size());
+  // a sphere is smooth enough for nearly every cone to cull
+  REQUIRE(cones > out.meshlets.size() * .9);
+
+  auto stats = out.statistics(V.size() / 3);
+  REQUIRE(stats.meshlets == out.meshlets.size());
+  REQUIRE(stats.vertexFill > .9);
+  REQUIRE(stats.triangleFill > .7);
+
+  // the same on one thread
+  ThreadPool single(1);
+  meshlet::Meshlets serial;
+  buildMeshlets(V, F, serial, 64, 124, single);
+  REQUIRE(serial.vertices == out.vertices);
+  REQUIRE(serial.triangles == out.triangles);
+  REQUIRE(std::memcmp(serial.bounds.data(), out.bounds.data(), out.bounds.size() * sizeof(meshlet::Bounds)) == 0);
+}
@@ -0,0 +1,94 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include "generate.hpp"
+#include "normals.hpp"
+#include "weld.hpp"
+
+TEST_CASE("computeNormals", "") {
+  // a closed sphere over several chunks: normals point out
+  std::vector<float> V, N;
+  std::vector<uint32_t> F;
+  prim::generate(prim::Sphere{ 80 }, V, F);
+  weldVertices(V, F);
+  REQUIRE(F.size() / 3 > normals::chunkTriangles);
+
+  ThreadPool pool(3);
+  for (auto weighting : { normals::Area, normals::Angle }) {
+    computeNormals(V, F, N, weighting, pool);
+    REQUIRE(N.size() == V.size());
+    float minDot = 1;
+    for (size_t i = 0; i < V.size(); i += 3)
+      minDot = std::min(minDot, N[i] * V[i] + N[i + 1] * V[i + 1] + N[i + 2] * V[i + 2]);
+    REQUIRE(minDot > .999f);
+
+    // independent of the thread count
+    ThreadPool single(1);
+    std::vector<float> M;
+    computeNormals(V, F, M, weighting, single);
+    REQUIRE(M == N);
+
+    // vertices numbered at random leave every chunk sharing most of them
+    std::vector<uint32_t> remap(V.size() / 3), G(F.size());
+    std::vector<float> W(V.size());
+    for (uint32_t i = 0; i < remap.size(); i++) remap[i] = i;
+    for (size_t i = remap.size(); i > 1; i--) std::swap(remap[i - 1], remap[hashMix(i) % i]);
+    for (size_t i = 0; i < remap.size(); i++) std::copy_n(&V[i * 3], 3, &W[remap[i] * 3]);
+    for (size_t i = 0; i < F.size(); i++) G[i] = remap[F[i]];
+    computeNormals(W, G, M, weighting, pool);
+    float maxError = 0;
+    for (size_t i = 0; i < remap.size(); i++)
+      for (int k = 0; k < 3; k++) maxError = std::max(maxError, std::abs(M[remap[i] * 3 + k] - N[i * 3 + k]));
+    REQUIRE(maxError < 1e-5f);
+    // summed in stripes then, still independent of the thread count
+    std::vector<float> L;
+    computeNormals(W, G, L, weighting, single);
+    REQUIRE(L == M);
+
+    // on the calling thread, in triangle order
+    computeNormalsSerial(V, F, M, weighting);
+    REQUIRE(M.size() == N.size());
+    maxError = 0;
+    for (size_t i = 0; i < N.size(); i++) maxError = std::max(maxError, std::abs(M[i] - N[i]));
+    REQUIRE(maxError < 1e-5f);
+  }
+}
+
+TEST_CASE("computeNormals flat", "") {
+  // a grid of 6 triangles, which do not fill the last group of SIMD lanes,
+  // and an unused vertex
+  std::vector<float> V, N;
+  std::vector<uint32_t> F;
+  prim::generate(prim::Grid{ { 4, 2 } }, V, F);
+  REQUIRE(F.size() == 18);
+  V.insert(V.end(), { 5, 5, 5 });
+  computeNormals(V, F, N);
+  size_t n = V.size() / 3;
+  for (size_t i = 0; i + 1 < n; i++) {
+    REQUIRE(std::abs(N[i * 3]) < 1e-6f);
+    REQUIRE(std::abs(N[i * 3 + 1] - 1) < 1e-6f);
+    REQUIRE(std::abs(N[i * 3 + 2]) < 1e-6f);
+  }
+  REQUIRE(N[(n - 1) * 3] == 0);
+  REQUIRE(N[(n - 1) * 3 + 1] == 0);
+  REQUIRE(N[(n - 1) * 3 + 2] == 0);
+}
+
+TEST_CASE("computeNormals weighting", "") {
+  // a cube of 8 shared corners: every face adds a right angle to each of
+  // its corners, however it is split, but an area that depends on the split
+  std::vector<float> V = { -1, -1, -1, 1, -1, -1, -1, 1, -1, 1, 1, -1, -1, -1, 1, 1, -1, 1, -1, 1, 1, 1, 1, 1 };
+  std::vector<uint32_t> F = {
+    0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4,
+    2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5,
+  };
+  std::vector<float> N;
+  computeNormals(V, F, N, normals::Angle);
+  for (size_t i = 0; i < V.size(); i++) REQUIRE(std::abs(N[i] - V[i] / std::sqrt(3.f)) < 1e-4f);
+
+  computeNormals(V, F, N, normals::Area);
+  float minDot = 1;
+  for (size_t i = 0; i < V.size(); i += 3)
+    minDot = std::min(minDot, (N[i] * V[i] + N[i + 1] * V[i + 1] + N[i + 2] * V[i + 2]) / std::sqrt(3.f));
+  REQUIRE(minDot > .9f);
+  REQUIRE(minDot < .999f);
+}
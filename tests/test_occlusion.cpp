@@ -0,0 +1,83 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include "generate.hpp"
+#include "normals.hpp"
+#include "occlusion.hpp"
+
+TEST_CASE("bakeOcclusion", "") {
+  // a grid under a much wider one, the first `n` vertices
+  std::vector<float> V, W;
+  std::vector<uint32_t> F, G;
+  prim::generate(prim::Grid{ { 65, 65 } }, V, F);
+  prim::Grid cover{ { 9, 9 }, 100 };
+  prim::generate(cover, W, G);
+  std::vector<float> N;
+  computeNormals(V, F, N);
+  size_t n = V.size() / 3;
+  // the cover faces the grid, whichever way the grid faces
+  float up = N[1] > 0 ? 1 : -1;
+  for (size_t i = 0; i < W.size(); i += 3) W[i + 1] = up * .05f;
+  for (uint32_t i : G) F.push_back(uint32_t(i + n));
+  V.insert(V.end(), W.begin(), W.end());
+  N.resize(V.size(), 0);
+
+  ThreadPool pool(3);
+  bvh::Tree tree;
+  buildBvh(V, F, tree, pool);
+  std::vector<float> AO;
+  bakeOcclusion(V, N, F, tree, AO, 32, 1.f, pool);
+  REQUIRE(AO.size() == V.size() / 3);
+  for (size_t v = 0; v < n; v++) REQUIRE(AO[v] == 0);
+  // vertices without a normal are open
+  for (size_t v = n; v < AO.size(); v++) REQUIRE(AO[v] == 1);
+
+  // rays shorter than the gap all leave
+  std::vector<float> open;
+  bakeOcclusion(V, N, F, tree, open, 32, .04f, pool);
+  for (size_t v = 0; v < n; v++) REQUIRE(open[v] == 1);
+
+  // a sphere sees nothing of itself from outside, and all of itself from
+  // inside
+  std::vector<float> S, M;
+  std::vector<uint32_t> T;
+  prim::generate(prim::Sphere{ 24 }, S, T);
+  computeNormals(S, T, M);
+  buildBvh(S, T, tree, pool);
+  bakeOcclusion(S, M, T, tree, AO, 32, 4.f, pool);
+  for (float ao : AO) REQUIRE(ao == 1);
+  for (float& m : M) m = -m;
+  bakeOcclusion(S, M, T, tree, AO, 32, 4.f, pool);
+  for (float ao : AO) REQUIRE(ao == 0);
+
+  // independent of the thread count
+  ThreadPool single(1);
+  std::vector<float> one, three;
+  bakeOcclusion(V, N, F, tree, three, 16, .5f, pool);
+  bakeOcclusion(V, N, F, tree, one, 16, .5f, single);
+  REQUIRE(one == three);
+}
+
+TEST_CASE("occlusion cache", "") {
+  std::vector<float> V, N;
+  std::vector<uint32_t> F;
+  prim::generate(prim::Sphere{ 8 }, V, F);
+  computeNormals(V, F, N);
+  uint64_t key = occlusion::key(V, N, F, 32, 1.f);
+  // any change to the geometry or the settings changes the key
+  REQUIRE(key != occlusion::key(V, N, F, 16, 1.f));
+  REQUIRE(key != occlusion::key(V, N, F, 32, .5f));
+  std::vector<uint32_t> G = F;
+  std::swap(G[0], G[1]);
+  REQUIRE(key != occlusion::key(V, N, G, 32, 1.f));
+
+  std::string path = (std::filesystem::temp_directory_path() / "test_occlusion.ao").string();
+  std::filesystem::remove(path);
+  std::vector<float> AO(V.size() / 3), read;
+  for (size_t i = 0; i < AO.size(); i++) AO[i] = float(i % 7) / 6;
+  REQUIRE_FALSE(occlusion::read(path, key, read));
+  REQUIRE(occlusion::write(path, key, AO));
+  REQUIRE(occlusion::read(path, key, read));
+  REQUIRE(read == AO);
+  REQUIRE_FALSE(occlusion::read(path, key + 1, read));
+  std::filesystem::remove(path);
+}
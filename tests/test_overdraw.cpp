@@ -0,0 +1,53 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <array>
+#include "generate.hpp"
+#include "overdraw.hpp"
+#include "read_off.hpp"
+
+#define DATA_DIR "../../data"
+
+TEST_CASE("overdraw analyze", "") {
+  // a square made of two triangles, seen from +z and -z
+  std::vector<float> V{ 0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0 };
+  std::vector<uint32_t> F{ 0, 1, 2, 2, 1, 3 };
+  auto stats = overdraw::analyze(V, F, 64);
+  REQUIRE(stats.covered == 64 * 64);
+  REQUIRE(stats.shaded == 64 * 64);
+  REQUIRE(overdraw::analyze(V, F, 64, false).covered == 2 * 64 * 64);
+
+  // the same square twice is drawn once more wherever the depth test passes
+  F.insert(F.end(), { 0, 1, 2, 2, 1, 3 });
+  REQUIRE(overdraw::analyze(V, F, 64).overdraw == 2);
+}
+
+TEST_CASE("optimizeOverdraw draws occluders first", "") {
+  // a small sphere inside a large one, the inner one first
+  std::vector<float> V, outer;
+  std::vector<uint32_t> F, G;
+  prim::Sphere sphere{ 16 };
+  prim::generate(sphere, V, F);
+  prim::generate(sphere, outer, G);
+  for (auto& x : V) x *= .5f;
+  for (auto& i : G) i += uint32_t(sphere.vertexCount());
+  V.insert(V.end(), outer.begin(), outer.end());
+  F.insert(F.end(), G.begin(), G.end());
+  optimizeVertexCache(F, V.size() / 3);
+
+  auto before = overdraw::analyze(V, F);
+  auto cacheBefore = vcache::analyze(F, V.size() / 3);
+  std::vector<uint32_t> R = F;
+  optimizeOverdraw(R, V);
+  auto after = overdraw::analyze(V, R);
+  REQUIRE(before.overdraw > 1.2);
+  REQUIRE(after.overdraw < before.overdraw * .9);
+  REQUIRE(vcache::analyze(R, V.size() / 3).acmr < cacheBefore.acmr * 1.1);
+
+  auto triangles = [](const std::vector<uint32_t>& F) {
+    std::vector<std::array<uint32_t, 3>> T;
+    for (size_t f = 0; f < F.size(); f += 3) T.push_back({ F[f], F[f + 1], F[f + 2] });
+    std::sort(T.begin(), T.end());
+    return T;
+  };
+  REQUIRE(triangles(R) == triangles(F));
+}
@@ -0,0 +1,100 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <filesystem>
+#include "generate.hpp"
+#include "normals.hpp"
+#include "quantize.hpp"
+
+TEST_CASE("quantizeVertices", "") {
+  // several chunks of a terrain, colored by position
+  std::vector<float> V, N;
+  std::vector<uint32_t> F;
+  prim::generate(prim::Terrain::withTriangles(300000), V, F);
+  computeNormals(V, F, N);
+  size_t n = V.size() / 3;
+  REQUIRE(n > quantize::chunkVertices * 2);
+  auto bounds = meshcodec::bounds(V.data(), n);
+  std::vector<float> C(n * 3);
+  for (size_t i = 0; i < C.size(); i++)
+    C[i] = (V[i] - bounds.v[i % 3]) / std::max(bounds.v[i % 3 + 3] - bounds.v[i % 3], 1e-6f);
+
+  ThreadPool pool(3);
+  quantize::Packed packed;
+  quantizeVertices(V, bounds, N, C, 3, packed, pool);
+  REQUIRE(packed.stride() == 16);
+
+  // positions through the dequantization matrix, as the vertex shader sees
+  // them, within half a step
+  float m[16], bound = 0;
+  quantize::dequantization(bounds, m);
+  for (int k = 0; k < 3; k++) bound = std::max(bound, meshcodec::step(bounds, k) * .5f);
+  REQUIRE(packed.error.position > 0);
+  REQUIRE(packed.error.position <= bound * 1.001f);
+  float largest = 0;
+  for (size_t i = 0; i < n; i++) {
+    REQUIRE(packed.positions[i * 4 + 3] == 0);
+    for (int k = 0; k < 3; k++) {
+      float x = m[k * 5] * (packed.positions[i * 4 + k] / 65535.f) + m[12 + k];
+      largest = std::max(largest, std::abs(x - V[i * 3 + k]));
+    }
+  }
+  REQUIRE(largest <= bound * 1.01f);
+
+  // normals within a few hundredths of a degree
+  std::vector<float> D(n * 3);
+  meshcodec::octDecode(packed.normals.data(), n, D.data());
+  REQUIRE(packed.error.normal < 1e-3f);
+  for (size_t i = 0; i < n; i++) {
+    float dot = N[i * 3] * D[i * 3] + N[i * 3 + 1] * D[i * 3 + 1] + N[i * 3 + 2] * D[i * 3 + 2];
+    REQUIRE(std::acos(std::min(dot, 1.f)) <= packed.error.normal + 1e-6f);
+  }
+
+  // colors within half a step of 8 bits, opaque
+  REQUIRE(packed.error.color <= .5f / 255 + 1e-6f);
+  for (size_t i = 0; i < n; i++) REQUIRE(packed.colors[i * 4 + 3] == 255);
+
+  // independent of the thread count
+  ThreadPool single(1);
+  quantize::Packed other;
+  quantizeVertices(V, bounds, N, C, 3, other, single);
+  REQUIRE(other.positions == packed.positions);
+  REQUIRE(other.normals == packed.normals);
+  REQUIRE(other.colors == packed.colors);
+  REQUIRE(other.error.position == packed.error.position);
+  REQUIRE(other.error.normal == packed.error.normal);
+
+  // read back from a cache like the encoded streams
+  IndexStream indices;
+  indices.assign(std::vector<uint32_t>(F), n);
+  auto streams = packed.streams();
+  REQUIRE(streams.size() == 3);
+  streams.push_back({ .semantic = meshcache::Index, .format = meshcache::Uint32, .components = 1, .data = F.data(), .count = F.size() });
+  std::string path = (std::filesystem::temp_directory_path() / "test_quantize.mesh").string();
+  meshcache::Source source;
+  REQUIRE(meshcache::write(path, source, streams));
+  MeshCache cache;
+  REQUIRE(cache.open(path));
+  REQUIRE(cache.find(meshcache::Position)->stride == 8);
+  meshcodec::Decoded decoded;
+  REQUIRE(meshcodec::decode(cache, decoded));
+  for (size_t i = 0; i < V.size(); i++) REQUIRE(std::abs(decoded.positions[i] - V[i]) <= bound * 1.01f);
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("quantizeVertices attributes", "") {
+  // only positions, and colors with alpha
+  std::vector<float> V = { 0, 0, 0, 1, 2, 3, .5f, 1, -1 }, C = { 0, .25f, 1, .5f, 1, 0, .1f, .9f, 2, -1, .5f, .5f };
+  quantize::Packed packed;
+  quantizeVertices(V, meshcodec::bounds(V.data(), 3), {}, {}, 0, packed);
+  REQUIRE(packed.normals.empty());
+  REQUIRE(packed.colors.empty());
+  REQUIRE(packed.streams().size() == 1);
+  REQUIRE(packed.stride() == 8);
+  REQUIRE(packed.positions[4] == 65535);
+  REQUIRE(packed.positions[0] == 0);
+
+  quantizeVertices(V, meshcodec::bounds(V.data(), 3), {}, C, 4, packed);
+  REQUIRE(packed.colors == std::vector<uint8_t>{ 0, 64, 255, 128, 255, 0, 26, 230, 255, 0, 128, 128 });
+  // out of range channels are clamped before they are measured
+  REQUIRE(packed.error.color <= .5f / 255 + 1e-6f);
+}
@@ -0,0 +1,214 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include "read_mesh.hpp"
+
+#define DATA_DIR "../../data"
+
+static std::string writeTemp(const char* name, const std::string& content) {
+  std::string path = (std::filesystem::temp_directory_path() / name).string();
+  std::ofstream(path, std::ios::binary) << content;
+  return path;
+}
+
+template <typename T>
+static void append(std::string& out, T value, bool bigEndian = false) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  if (bigEndian) std::reverse(bytes, bytes + sizeof(T));
+  out.append(bytes, sizeof(T));
+}
+
+// screwdriver.off as binary PLY, with packed float positions and uchar/int faces
+static std::string screwdriverPLY(const std::vector<float>& V, const std::vector<uint32_t>& F) {
+  std::string out = "ply\nformat binary_little_endian 1.0\ncomment converted\n";
+  out += "element vertex " + std::to_string(V.size() / 3) + "\n";
+  out += "property float x\nproperty float y\nproperty float z\n";
+  out += "element face " + std::to_string(F.size() / 3) + "\n";
+  out += "property list uchar int vertex_indices\nend_header\n";
+  out.append(reinterpret_cast<const char*>(V.data()), V.size() * sizeof(float));
+  for (size_t i = 0; i < F.size(); i += 3) {
+    append<uint8_t>(out, 3);
+    for (int k = 0; k < 3; k++) append<int32_t>(out, F[i + k]);
+  }
+  return out;
+}
+
+TEST_CASE("readMesh dispatches by content", "") {
+  std::vector<float> V, V2;
+  std::vector<uint32_t> F, F2;
+  REQUIRE(sniffMeshFormat(DATA_DIR "/screwdriver.off") == MeshFormat::OFF);
+  REQUIRE(readOFF(DATA_DIR "/screwdriver.off", V, F));
+  REQUIRE(readMesh(DATA_DIR "/screwdriver.off", V2, F2));
+  REQUIRE(V2 == V);
+  REQUIRE(F2 == F);
+
+  // the extension does not matter
+  std::string path = writeTemp("screwdriver.off.bin", screwdriverPLY(V, F));
+  REQUIRE(sniffMeshFormat(path) == MeshFormat::PLY);
+  MeshAttributes<float> attributes;
+  REQUIRE(readMesh(path, V2, F2, &attributes));
+  REQUIRE(V2 == V);
+  REQUIRE(F2 == F);
+  REQUIRE(attributes.faceSizes == std::vector<uint32_t>(F.size() / 3, 3));
+
+  REQUIRE(sniffMeshFormat(writeTemp("comment.off", "# made by hand\nOFF\n0 0 0\n")) == MeshFormat::OFF);
+  REQUIRE(!readMesh(writeTemp("unknown.txt", "hello\n"), V2, F2));
+}
+
+TEST_CASE("readPLY ascii with attributes and extra elements", "") {
+  std::string path = writeTemp("quad.ply",
+    "ply\n"
+    "format ascii 1.0\n"
+    "comment a quad and a triangle\n"
+    "element vertex 5\n"
+    "property double x\nproperty double y\nproperty double z\n"
+    "property float nx\nproperty float ny\nproperty float nz\n"
+    "property uchar red\nproperty uchar green\nproperty uchar blue\n"
+    "property float quality\n"
+    "element face 2\n"
+    "property list uchar uint vertex_indices\n"
+    "property int flags\n"
+    "element edge 1\n"
+    "property int vertex1\nproperty int vertex2\n"
+    "end_header\n"
+    "0 0 0 0 0 1 255 0 0 .5\n"
+    "1 0 0 0 0 1 0 255 0 .5\n"
+    "1 1 0 0 0 1 0 0 255 .5\n"
+    "0 1 0 0 0 1 10 20 30 .5\n"
+    "2 2 0.25 0 0 1 1 2 3 .5\n"
+    "4 0 1 2 3 7\n"
+    "3 2 4 3\n 0\n"
+    "0 1\n");
+
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  MeshAttributes<float> attributes;
+  REQUIRE(readPLY(path, V, F, &attributes));
+  REQUIRE(V.size() == 15);
+  REQUIRE(V[14] == .25f);
+  REQUIRE(F == std::vector<uint32_t>{ 0, 1, 2, 3, 2, 4, 3 });
+  REQUIRE(attributes.faceSizes == std::vector<uint32_t>{ 4, 3 });
+  REQUIRE(attributes.normals.size() == 15);
+  REQUIRE(attributes.normals[2] == 1.f);
+  REQUIRE(attributes.colors.size() == 20);
+  REQUIRE(attributes.colors[12] == 10);
+  REQUIRE(attributes.colors[13] == 20);
+  REQUIRE(attributes.colors[15] == 255); // alpha defaults to opaque
+
+  // without attributes the extra properties are skipped
+  std::vector<float> V2;
+  std::vector<uint32_t> F2;
+  REQUIRE(readPLY(path, V2, F2));
+  REQUIRE(V2 == V);
+  REQUIRE(F2 == F);
+}
+
+TEST_CASE("readPLY binary byte orders", "") {
+  for (bool bigEndian : { false, true }) {
+    std::string data = std::string("ply\nformat ") + (bigEndian ? "binary_big_endian" : "binary_little_endian") + " 1.0\n"
+      "element vertex 3\n"
+      "property float x\nproperty float y\nproperty float z\nproperty float red\nproperty float green\nproperty float blue\n"
+      "element face 1\n"
+      "property list uchar ushort vertex_index\n"
+      "end_header\n";
+    for (int i = 0; i < 3; i++) {
+      append<float>(data, i, bigEndian);
+      append<float>(data, i * 2, bigEndian);
+      append<float>(data, -i, bigEndian);
+      for (int k = 0; k < 3; k++) append<float>(data, k == i ? 1.f : 0.f, bigEndian);
+    }
+    append<uint8_t>(data, 3);
+    for (uint16_t i : { 2, 1, 0 }) append<uint16_t>(data, i, bigEndian);
+
+    std::vector<double> V;
+    std::vector<uint16_t> F;
+    MeshAttributes<double> attributes;
+    REQUIRE(readMesh(writeTemp("triangle.ply", data), V, F, &attributes));
+    REQUIRE(V == std::vector<double>{ 0, 0, 0, 1, 2, -1, 2, 4, -2 });
+    REQUIRE(F == std::vector<uint16_t>{ 2, 1, 0 });
+    REQUIRE(attributes.colors == std::vector<uint8_t>{ 255, 0, 0, 255, 0, 255, 0, 255, 0, 0, 255, 255 });
+  }
+}
+
+TEST_CASE("readPLY errors", "") {
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  const char* header =
+    "ply\nformat binary_little_endian 1.0\nelement vertex 2\n"
+    "property float x\nproperty float y\nproperty float z\n"
+    "element face 1\nproperty list uchar int vertex_indices\nend_header\n";
+  std::string truncated = std::string(header) + std::string(20, '\0');
+  REQUIRE(!readPLY(writeTemp("truncated.ply", truncated), V, F));
+
+  std::string range = std::string(header) + std::string(24, '\0');
+  append<uint8_t>(range, 3);
+  for (int32_t i : { 0, 1, 2 }) append<int32_t>(range, i);
+  REQUIRE(!readPLY(writeTemp("range.ply", range), V, F));
+
+  // indices that would wrap into range once narrowed to 16 bits
+  std::vector<uint16_t> narrow;
+  std::string ascii = "ply\nformat ascii 1.0\nelement vertex 3\nproperty float x\nproperty float y\nproperty float z\n"
+    "element face 1\nproperty list uchar int vertex_indices\nend_header\n0 0 0\n1 0 0\n0 1 0\n";
+  REQUIRE(readPLY(writeTemp("narrow.ply", ascii + "3 0 1 2\n"), V, narrow));
+  REQUIRE(!readPLY(writeTemp("wrap.ply", ascii + "3 0 1 65538\n"), V, narrow));
+  REQUIRE(!readPLY(writeTemp("negative.ply", ascii + "3 -65535 1 2\n"), V, narrow));
+
+  // huge counts in a short file fail without allocating for them
+  OFFAttributes<float> attributes;
+  for (const char* format : { "ascii", "binary_little_endian" }) {
+    std::string huge = std::string("ply\nformat ") + format + " 1.0\nelement vertex 4000000000\n"
+      "property float x\nproperty float y\nproperty float z\nproperty uchar red\nproperty uchar green\nproperty uchar blue\n"
+      "element face 4000000000\nproperty list uchar int vertex_indices\nend_header\n0 0 0 1 2 3\n";
+    REQUIRE(!readPLY(writeTemp("huge.ply", huge), V, F, &attributes));
+    REQUIRE(V.capacity() < 1024);
+  }
+  std::string hugeFaces = "ply\nformat binary_little_endian 1.0\nelement vertex 0\nproperty float x\nproperty float y\nproperty float z\n"
+    "element face 4000000000\nproperty list uchar int vertex_indices\nend_header\n" + std::string(13, '\0');
+  REQUIRE(!readPLY(writeTemp("huge_faces.ply", hugeFaces), V, F, &attributes));
+  REQUIRE(F.capacity() < 1024);
+
+  REQUIRE(!readPLY(writeTemp("noformat.ply", "ply\nelement vertex 0\nend_header\n"), V, F));
+  REQUIRE(!readPLY(writeTemp("noxyz.ply", "ply\nformat ascii 1.0\nelement vertex 1\nproperty float x\nend_header\n0\n"), V, F));
+}
+
+TEST_CASE("readSTL welds corners", "") {
+  // two triangles of a quad, sharing an edge, one corner at -0
+  float triangles[2][9] = {
+    { 0, 0, 0, 1, 0, 0, 1, 1, 0 },
+    { -0.f, 0, 0, 1, 1, 0, 0, 1, 0 },
+  };
+  std::string binary = "solid but actually binary";
+  binary.resize(80, ' ');
+  append<uint32_t>(binary, 2);
+  for (auto& t : triangles) {
+    for (int k = 0; k < 3; k++) append<float>(binary, k == 2 ? 1.f : 0.f);
+    for (float x : t) append<float>(binary, x);
+    append<uint16_t>(binary, 0);
+  }
+
+  std::string ascii =
+    "solid quad\n"
+    "facet normal 0 0 1\n outer loop\n  vertex 0 0 0\n  vertex 1 0 0\n  vertex 1 1 0\n endloop\nendfacet\n"
+    "facet normal 0 0 1\n outer loop\n  vertex -0 0 0\n  vertex 1 1 0\n  vertex 0 1 0\n endloop\nendfacet\n"
+    "endsolid quad\n";
+
+  for (auto& content : { binary, ascii }) {
+    std::string path = writeTemp("quad.stl", content);
+    REQUIRE(sniffMeshFormat(path) == MeshFormat::STL);
+
+    std::vector<float> V;
+    std::vector<uint32_t> F;
+    MeshAttributes<float> attributes;
+    REQUIRE(readMesh(path, V, F, &attributes));
+    REQUIRE(V == std::vector<float>{ 0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0 });
+    REQUIRE(F == std::vector<uint32_t>{ 0, 1, 2, 0, 2, 3 });
+    REQUIRE(attributes.faceSizes == std::vector<uint32_t>{ 3, 3 });
+  }
+
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  REQUIRE(!readSTL(writeTemp("short.stl", "solid\nfacet\nvertex 0 0 0\nendsolid\n"), V, F));
+}
@@ -1,4 +1,8 @@
 #include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
 #include "read_off.hpp"
 
 #define DATA_DIR "../../data"
@@ -47,4 +51,233 @@ TEST_CASE("readOFF", "") {
   size_t nF = F.size();
   for (int i = 0, n = fLast.size(); i < n; i++)
     REQUIRE(std::abs(F[nF - n + i] - fLast[i]) < 1e-5);
-}
\ No newline at end of file
+}
+static std::string writeTemp(const char* name, const std::string& content) {
+  std::string path = (std::filesystem::temp_directory_path() / name).string();
+  std::ofstream(path, std::ios::binary) << content;
+  return path;
+}
+
+TEST_CASE("readOFF comments and inline counts", "") {
+  std::string path = writeTemp("inline.off",
+    "OFF 4 2 0\n"
+    "# a comment\n"
+    "0 0 0\n"
+    "1.5e0 -2 +3\n"
+    "\n"
+    "# another comment\n"
+    "  .25 1e-3 -0\n"
+    "1 1 1 0.5 0.5 0.5 1\n"
+    "3 0 1 2\n"
+    "4 0 1 2 3 255 0 0\n");
+
+  std::vector<double> V;
+  std::vector<uint32_t> F;
+  REQUIRE(readOFF(path, V, F));
+  REQUIRE(V == std::vector<double>{ 0, 0, 0, 1.5, -2, 3, .25, 1e-3, -0., 1, 1, 1 });
+  REQUIRE(F == std::vector<uint32_t>{ 0, 1, 2, 0, 1, 2, 3 });
+}
+
+TEST_CASE("readOFF matches strtod", "") {
+  const char* numbers[] = {
+    "0.1", "-0.007131", "3.14159265358979323846", "1e-30", "12345678901234567890", "6.02214076e23", "-4.9e-324"
+  };
+  std::string content = "OFF\n7 0 0\n";
+  for (auto s : numbers) content += std::string(s) + " 0 0\n";
+  std::string path = writeTemp("strtod.off", content);
+
+  std::vector<double> V;
+  std::vector<int> F;
+  REQUIRE(readOFF(path, V, F));
+  for (int i = 0; i < 7; i++)
+    REQUIRE(V[i * 3] == std::strtod(numbers[i], nullptr));
+}
+
+TEST_CASE("readOFF errors", "") {
+  std::vector<float> V;
+  std::vector<uint16_t> F;
+  REQUIRE_FALSE(readOFF(DATA_DIR "/missing.off", V, F));
+  REQUIRE_FALSE(readOFF(writeTemp("bad_header.off", "PLY\n1 0 0\n0 0 0\n"), V, F));
+  REQUIRE_FALSE(readOFF(writeTemp("truncated.off", "OFF\n2 0 0\n0 0 0\n"), V, F));
+  REQUIRE_FALSE(readOFF(writeTemp("bad_face.off", "OFF\n3 1 0\n0 0 0\n0 0 0\n0 0 0\n3 0 x 2\n"), V, F));
+}
+
+TEST_CASE("readOFF huge counts in a short file", "") {
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  OFFAttributes<float> attributes;
+  REQUIRE_FALSE(readOFF(writeTemp("huge.off", "OFF\n2000000000 2000000000 0\n0 0 0\n"), V, F, &attributes));
+  REQUIRE(V.capacity() < 1024);
+  REQUIRE(F.capacity() < 1024);
+
+  std::string counts("\x77\x35\x94\x00\x77\x35\x94\x00\x00\x00\x00\x00", 12);
+  REQUIRE_FALSE(readOFF(writeTemp("huge_binary.off", "OFF BINARY\n" + counts), V, F, &attributes));
+  REQUIRE_FALSE(readOFF(writeTemp("huge_faces_binary.off", "OFF BINARY\n" + counts.substr(8, 4) + counts.substr(4, 8)), V, F, &attributes));
+}
+
+TEST_CASE("readOFFParallel matches readOFF", "") {
+  ThreadPool pool(4);
+  std::vector<float> V0, V1;
+  std::vector<uint16_t> F0, F1;
+  REQUIRE(readOFF(DATA_DIR "/screwdriver.off", V0, F0));
+  for (size_t chunkBytes : { 64, 4096, 1 << 16 }) {
+    REQUIRE(readOFFParallel(DATA_DIR "/screwdriver.off", V1, F1, nullptr, chunkBytes, pool));
+    REQUIRE(V0 == V1);
+    REQUIRE(F0 == F1);
+  }
+
+  std::string path = writeTemp("multiline.off",
+    "OFF\n4 2 0\n0 0 0\n# comment\n1 0 0\n\n0 1 0\n0 0 1\n3 0 1\n 2\n4 0 1 2 3\n");
+  REQUIRE(readOFF(path, V0, F0));
+  REQUIRE(readOFFParallel(path, V1, F1, nullptr, 8, pool));
+  REQUIRE(V0 == V1);
+  REQUIRE(F0 == F1);
+}
+
+TEST_CASE("ThreadPool rethrows task errors", "") {
+  ThreadPool pool(4);
+  std::atomic<int> ran = 0;
+  for (size_t thrower : { size_t(0), size_t(37) }) {
+    bool caught = false;
+    try {
+      pool.run(1000, [&](size_t task, unsigned) {
+        if (task == thrower) throw std::runtime_error("task");
+        ran++;
+      });
+    } catch (const std::runtime_error&) {
+      caught = true;
+    }
+    REQUIRE(caught);
+  }
+  ran = 0;
+  pool.run(1000, [&](size_t, unsigned) { ran++; });
+  REQUIRE(ran == 1000);
+}
+
+TEST_CASE("OFFStreamReader matches readOFF", "") {
+  std::vector<float> V0;
+  std::vector<uint16_t> F0;
+  REQUIRE(readOFF(DATA_DIR "/screwdriver.off", V0, F0));
+
+  for (size_t bufferBytes : { 64, 1000, 1 << 20 }) {
+    OFFStreamReader<float, uint16_t> reader(bufferBytes);
+    REQUIRE(reader.open(DATA_DIR "/screwdriver.off"));
+    REQUIRE(reader.header.numVertices == 3395);
+
+    std::vector<float> V, chunkV;
+    while (!reader.verticesDone()) {
+      REQUIRE(reader.nextVertices(chunkV, 100));
+      REQUIRE(chunkV.size() <= 300);
+      V.insert(V.end(), chunkV.begin(), chunkV.end());
+    }
+    std::vector<uint16_t> F, chunkF;
+    while (!reader.facesDone()) {
+      REQUIRE(reader.nextFaces(chunkF, 100));
+      F.insert(F.end(), chunkF.begin(), chunkF.end());
+    }
+    REQUIRE(V == V0);
+    REQUIRE(F == F0);
+    REQUIRE(reader.bufferCapacity() == std::max<size_t>(bufferBytes, 64));
+  }
+
+  std::string path = writeTemp("stream.off",
+    "OFF\n3 2 0\n0 0 0\n# a comment that is longer than the window of the reader\n1 0 0\n0 1 0\n3 0\n1 2\n3 2 1 0");
+  OFFStreamReader<double, int> reader(8);
+  REQUIRE(reader.open(path));
+  std::vector<double> V;
+  std::vector<int> F;
+  REQUIRE(reader.nextVertices(V, 10));
+  REQUIRE(V == std::vector<double>{ 0, 0, 0, 1, 0, 0, 0, 1, 0 });
+  REQUIRE(reader.nextFaces(F, 10));
+  REQUIRE(F == std::vector<int>{ 0, 1, 2, 2, 1, 0 });
+  REQUIRE(reader.facesDone());
+
+  // a bad record fails where it is instead of pulling in the rest of the file
+  std::string bad = "OFF\n1000 0 0\n0 0 0\n0 x 0\n";
+  for (int i = 0; i < 998; i++) bad += "0 0 0\n";
+  OFFStreamReader<float, int> badReader(64);
+  REQUIRE(badReader.open(writeTemp("stream_bad.off", bad)));
+  std::vector<float> badV;
+  REQUIRE_FALSE(badReader.nextVertices(badV, 1000));
+  REQUIRE(badV.size() == 3);
+  REQUIRE(badReader.bufferCapacity() == 64);
+
+  int64_t vertices = 0, faces = 0;
+  REQUIRE(streamOFF<float, uint32_t>(DATA_DIR "/screwdriver.off", 1000,
+    [&](const std::vector<float>& V, int64_t first) { REQUIRE(first == vertices); vertices += V.size() / 3; },
+    [&](const std::vector<uint32_t>& F, int64_t first) { REQUIRE(first == faces); faces += F.size() / 3; }));
+  REQUIRE(vertices == 3395);
+  REQUIRE(faces == 6786);
+}
+
+TEST_CASE("readOFF normals and colors", "") {
+  std::string path = writeTemp("cnoff.off",
+    "CNOFF\n3 1 0\n"
+    "0 0 0 0 0 1 255 0 0\n"
+    "1 0 0 0 1 0 0.0 1.0 0.5 0.5\n"
+    "0 1 0 1 0 0 10 20 30 40\n"
+    "3 0 1 2\n");
+
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  OFFAttributes<float> attributes;
+  REQUIRE(readOFF(path, V, F, &attributes));
+  REQUIRE(V == std::vector<float>{ 0, 0, 0, 1, 0, 0, 0, 1, 0 });
+  REQUIRE(attributes.normals == std::vector<float>{ 0, 0, 1, 0, 1, 0, 1, 0, 0 });
+  REQUIRE(attributes.colors == std::vector<uint8_t>{ 255, 0, 0, 255, 0, 255, 128, 128, 10, 20, 30, 40 });
+
+  ThreadPool pool(3);
+  OFFAttributes<float> parallel;
+  REQUIRE(readOFFParallel(path, V, F, &parallel, 16, pool));
+  REQUIRE(parallel.normals == attributes.normals);
+  REQUIRE(parallel.colors == attributes.colors);
+
+  REQUIRE(readOFF(writeTemp("noff.off", "NOFF\n1 0 0\n1 2 3 0 0 -1\n"), V, F, &attributes));
+  REQUIRE(V == std::vector<float>{ 1, 2, 3 });
+  REQUIRE(attributes.normals == std::vector<float>{ 0, 0, -1 });
+  REQUIRE(attributes.colors.empty());
+
+  REQUIRE(readOFF(DATA_DIR "/screwdriver.off", V, F, &attributes));
+  REQUIRE(attributes.normals.empty());
+  REQUIRE(attributes.colors.empty());
+
+  REQUIRE_FALSE(readOFF(writeTemp("short_normal.off", "NOFF\n1 0 0\n1 2 3 0 0\n"), V, F, &attributes));
+}
+
+TEST_CASE("readOFF index width", "") {
+  // 300 x 300 grid: 90000 vertices, beyond 16-bit indices
+  const int n = 300;
+  std::string content = "OFF\n" + std::to_string(n * n) + " " + std::to_string((n - 1) * (n - 1)) + " 0\n";
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < n; i++) content += std::to_string(i) + " " + std::to_string(j) + " 0\n";
+  for (int j = 0; j < n - 1; j++)
+    for (int i = 0; i < n - 1; i++) {
+      int a = j * n + i;
+      content += "4 " + std::to_string(a) + " " + std::to_string(a + 1) + " " + std::to_string(a + n + 1) + " " + std::to_string(a + n) + "\n";
+    }
+  std::string path = writeTemp("grid.off", content);
+
+  std::vector<float> V;
+  std::vector<uint16_t> F16;
+  REQUIRE_FALSE(readOFF(path, V, F16));
+  ThreadPool pool(2);
+  REQUIRE_FALSE(readOFFParallel(path, V, F16, nullptr, 4096, pool));
+
+  IndexStream indices;
+  REQUIRE(readOFF(path, V, indices));
+  REQUIRE(indices.isWide());
+  REQUIRE(indices.stride() == 4);
+  REQUIRE(indices.size() == (n - 1) * (n - 1) * 4);
+  REQUIRE(indices[indices.size() - 2] == n * n - 1);
+
+  REQUIRE(readOFF(DATA_DIR "/screwdriver.off", V, indices));
+  REQUIRE_FALSE(indices.isWide());
+  REQUIRE(indices.stride() == 2);
+  REQUIRE(indices.size() == 6786 * 3);
+  REQUIRE(indices.bytes() == 6786 * 3 * 2);
+  REQUIRE(indices[0] == 1414);
+
+  std::vector<uint32_t> F32;
+  REQUIRE_FALSE(readOFF(writeTemp("out_of_range.off", "OFF\n3 1 0\n0 0 0\n1 0 0\n0 1 0\n3 0 1 3\n"), V, F32));
+  REQUIRE_FALSE(readOFF(writeTemp("negative.off", "OFF\n3 1 0\n0 0 0\n1 0 0\n0 1 0\n3 0 -1 2\n"), V, F32));
+}
@@ -0,0 +1,126 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include "generate.hpp"
+#include "simplify.hpp"
+#include "weld.hpp"
+
+static double volume(const std::vector<float>& V, const std::vector<uint32_t>& F) {
+  double sum = 0;
+  for (size_t t = 0; t < F.size(); t += 3) {
+    const float* a = &V[F[t] * 3], * b = &V[F[t + 1] * 3], * c = &V[F[t + 2] * 3];
+    sum += a[0] * (double(b[1]) * c[2] - double(b[2]) * c[1]) - a[1] * (double(b[0]) * c[2] - double(b[2]) * c[0]) +
+      a[2] * (double(b[0]) * c[1] - double(b[1]) * c[0]);
+  }
+  return sum / 6;
+}
+
+TEST_CASE("simplifyMesh", "") {
+  // a closed sphere over several partitions
+  std::vector<float> V;
+  std::vector<uint32_t> F, G;
+  prim::generate(prim::Sphere{ 80 }, V, F);
+  weldVertices(V, F);
+  REQUIRE(F.size() / 3 > simplify::partitionTriangles);
+
+  ThreadPool pool(3);
+  size_t target = F.size() / 3 / 10;
+  float error = simplifyMesh(V, F, G, target, std::numeric_limits<float>::max(), pool);
+  REQUIRE(G.size() / 3 <= target);
+  REQUIRE(G.size() / 3 > target * 9 / 10);
+  REQUIRE(error > 0);
+  REQUIRE(error < .02f);
+
+  // no triangle turns inside out, though a sliver may stand on its side,
+  // and the shape is kept
+  for (size_t t = 0; t < G.size(); t += 3) {
+    const float* a = &V[G[t] * 3], * b = &V[G[t + 1] * 3], * c = &V[G[t + 2] * 3];
+    float n[3], m[3] = { a[0] + b[0] + c[0], a[1] + b[1] + c[1], a[2] + b[2] + c[2] };
+    simplify::cross(a, b, c, n);
+    float cosine = (n[0] * m[0] + n[1] * m[1] + n[2] * m[2]) /
+      std::sqrt((n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) * (m[0] * m[0] + m[1] * m[1] + m[2] * m[2]));
+    REQUIRE(cosine > -.1f);
+  }
+  REQUIRE(volume(V, G) / volume(V, F) > .97);
+
+  // independent of the thread count
+  ThreadPool single(1);
+  std::vector<uint32_t> H;
+  REQUIRE(simplifyMesh(V, F, H, target, std::numeric_limits<float>::max(), single) == error);
+  REQUIRE(H == G);
+
+  // an error bound stops early
+  std::vector<uint32_t> bounded;
+  REQUIRE(simplifyMesh(V, F, bounded, target, error / 100, pool) <= error / 100);
+  REQUIRE(bounded.size() > G.size());
+}
+
+TEST_CASE("simplifyMesh flat", "") {
+  // a flat square collapses to a few triangles with its border kept
+  std::vector<float> V;
+  std::vector<uint32_t> F, G;
+  prim::generate(prim::Grid{ { 33, 33 } }, V, F);
+  float error = simplifyMesh(V, F, G, 8);
+  REQUIRE(G.size() / 3 <= 8);
+  REQUIRE(error < 1e-4f);
+
+  double area = 0;
+  for (size_t t = 0; t < G.size(); t += 3) {
+    const float* a = &V[G[t] * 3], * b = &V[G[t + 1] * 3], * c = &V[G[t + 2] * 3];
+    area += ((b[2] - a[2]) * (c[0] - a[0]) - (b[0] - a[0]) * (c[2] - a[2])) / 2.;
+  }
+  REQUIRE(std::abs(area - 4) < 1e-4);
+}
+
+TEST_CASE("buildLods", "") {
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  prim::generate(prim::Torus::withTriangles(20000), V, F);
+  auto lods = buildLods(V, F);
+  REQUIRE(lods.size() == 5);
+  REQUIRE(lods[0].indices == F);
+  REQUIRE(lods[0].error == 0);
+  std::vector<float> errors;
+  for (size_t i = 0; i < lods.size(); i++) {
+    errors.push_back(lods[i].error);
+    if (i == 0) continue;
+    REQUIRE(lods[i].indices.size() < lods[i - 1].indices.size());
+    REQUIRE(lods[i].error >= lods[i - 1].error);
+  }
+  REQUIRE(lods[4].indices.size() / 3 <= F.size() / 3 / 50);
+
+  // further away, coarser
+  float fov = 45 * float(M_PI) / 180;
+  REQUIRE(simplify::selectLod(errors, 0, fov, 720) == 0);
+  REQUIRE(simplify::selectLod(errors, 1e6f, fov, 720) == 4);
+  size_t previous = 0;
+  for (float distance = .5f; distance < 1000; distance *= 2) {
+    size_t level = simplify::selectLod(errors, distance, fov, 720);
+    REQUIRE(level >= previous);
+    REQUIRE(errors[level] * 720 / (2 * std::tan(fov / 2) * distance) <= 1);
+    previous = level;
+  }
+
+  // no point of a level, nor of F, farther from the other than the error,
+  // at points spread over every triangle more densely than it samples them
+  auto farthest = [&](const std::vector<uint32_t>& from, const std::vector<uint32_t>& to) {
+    bvh::Tree tree;
+    buildBvh(V, to, tree);
+    float largest = 0;
+    for (size_t t = 0; t < from.size(); t += 3)
+      for (int i = 0; i <= 4; i++)
+        for (int j = 0; i + j <= 4; j++) {
+          float p[3];
+          for (int k = 0; k < 3; k++)
+            p[k] = (V[from[t] * 3 + k] * (4 - i - j) + V[from[t + 1] * 3 + k] * i + V[from[t + 2] * 3 + k] * j) / 4;
+          bvh::Nearest near;
+          bvh::nearest(tree, V.data(), to.data(), p, near);
+          largest = std::max(largest, near.distance);
+        }
+    return largest;
+  };
+  for (size_t i = 1; i < lods.size(); i++) {
+    float measured = std::max(farthest(F, lods[i].indices), farthest(lods[i].indices, F));
+    REQUIRE(lods[i].error > 0);
+    REQUIRE(measured <= lods[i].error * 1.05f);
+  }
+}
@@ -0,0 +1,91 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include "generate.hpp"
+#include "tangents.hpp"
+
+// Texture coordinates of a lattice surface: (i / nx, j / ny), which jump
+// back to 0 across the seams of a wrapping lattice.
+static std::vector<float> latticeUV(const prim::Lattice& lattice) {
+  std::vector<float> UV(lattice.vertexCount() * 2);
+  for (uint64_t i = 0; i < lattice.vertexCount(); i++) {
+    UV[i * 2] = float(i % lattice.nx) / lattice.nx;
+    UV[i * 2 + 1] = float(i / lattice.nx) / lattice.ny;
+  }
+  return UV;
+}
+
+TEST_CASE("computeTangents flat", "") {
+  // u along x and v along z everywhere
+  auto grid = prim::Grid{ { 33, 33 } };
+  std::vector<float> V, N, T;
+  std::vector<uint32_t> F, splits;
+  prim::generate(grid, V, F);
+  std::vector<float> UV = latticeUV(grid.lattice);
+  computeNormals(V, F, N);
+  computeTangents(V, N, UV, F, T, splits);
+  REQUIRE(splits.empty());
+  REQUIRE(T.size() == V.size() / 3 * 4);
+  for (size_t v = 0; v < V.size() / 3; v++) {
+    const float* t = &T[v * 4];
+    REQUIRE(std::abs(t[0] - 1) < 1e-5f);
+    REQUIRE(std::abs(t[1]) < 1e-5f);
+    REQUIRE(std::abs(t[2]) < 1e-5f);
+    // the bitangent, w * cross(n, t), runs along +z with v
+    const float* n = &N[v * 3];
+    REQUIRE(t[3] * (n[0] * t[1] - n[1] * t[0]) > .999f);
+  }
+
+  std::vector<int8_t> packed;
+  tangent::pack(T, packed);
+  REQUIRE(packed.size() == T.size());
+  REQUIRE(packed[0] == 127);
+  REQUIRE(packed[1] == 0);
+  REQUIRE(packed[3] == T[3] * 127);
+}
+
+TEST_CASE("computeTangents seams", "") {
+  // the wrapping seams of a torus over several chunks reverse their
+  // triangles in texture space, so the two rows and two columns of vertices
+  // along each seam are split
+  auto torus = prim::Torus::withTriangles(200000);
+  std::vector<float> V, N, T;
+  std::vector<uint32_t> F, splits;
+  prim::generate(torus, V, F);
+  REQUIRE(F.size() / 3 > normals::chunkTriangles);
+  std::vector<float> UV = latticeUV(torus.lattice);
+  computeNormals(V, F, N);
+  std::vector<uint32_t> G = F;
+
+  ThreadPool pool(3);
+  computeTangents(V, N, UV, G, T, splits, pool);
+  size_t n = V.size() / 3;
+  REQUIRE(splits.size() == 2 * (torus.lattice.nx + torus.lattice.ny) - 4);
+  REQUIRE(T.size() == (n + splits.size()) * 4);
+
+  // unit tangents in the plane of the normal, with the handedness of every
+  // triangle using them
+  for (size_t v = 0; v < n + splits.size(); v++) {
+    const float* t = &T[v * 4], * normal = &N[(v < n ? v : splits[v - n]) * 3];
+    REQUIRE(std::abs(t[0] * t[0] + t[1] * t[1] + t[2] * t[2] - 1) < 1e-5f);
+    REQUIRE(std::abs(t[0] * normal[0] + t[1] * normal[1] + t[2] * normal[2]) < 1e-5f);
+  }
+  for (size_t i = 0; i < G.size(); i += 3) {
+    const float* uv[3];
+    for (int c = 0; c < 3; c++) {
+      uint32_t source = G[i + c] < n ? G[i + c] : splits[G[i + c] - n];
+      REQUIRE(source == F[i + c]);
+      uv[c] = &UV[source * 2];
+    }
+    float area = (uv[1][0] - uv[0][0]) * (uv[2][1] - uv[0][1]) - (uv[1][1] - uv[0][1]) * (uv[2][0] - uv[0][0]);
+    for (int c = 0; c < 3; c++) REQUIRE(T[G[i + c] * 4 + 3] == (area > 0 ? 1 : -1));
+  }
+
+  // independent of the thread count
+  ThreadPool single(1);
+  std::vector<float> T1;
+  std::vector<uint32_t> G1 = F, splits1;
+  computeTangents(V, N, UV, G1, T1, splits1, single);
+  REQUIRE(T1 == T);
+  REQUIRE(G1 == G);
+  REQUIRE(splits1 == splits);
+}
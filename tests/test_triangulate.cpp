@@ -0,0 +1,110 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include "read_off.hpp"
+#include "triangulate.hpp"
+
+#define DATA_DIR "../../data"
+
+// Signed area of triangle (a, b, c) in the xy plane.
+static double area(const std::vector<float>& V, uint32_t a, uint32_t b, uint32_t c) {
+  return .5 * ((V[b * 3] - V[a * 3]) * (V[c * 3 + 1] - V[a * 3 + 1]) - (V[b * 3 + 1] - V[a * 3 + 1]) * (V[c * 3] - V[a * 3]));
+}
+
+TEST_CASE("triangulate polygons", "") {
+  std::string path = (std::filesystem::temp_directory_path() / "polygons.off").string();
+  std::ofstream(path) <<
+    "OFF\n10 4 0\n"
+    "0 0 0\n1 0 0\n1 1 0\n0 1 0\n" // square
+    "2 0 0\n4 0 0\n4 1 0\n3 1 0\n3 3 0\n2 3 0\n" // L shape, concave at 7
+    "4 0 1 2 3\n"
+    "6 4 5 6 7 8 9\n"
+    "2 0 1\n"
+    "3 2 1 0\n";
+
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  OFFAttributes<float> attributes;
+  REQUIRE(readOFF(path, V, F, &attributes));
+  REQUIRE(attributes.faceSizes == std::vector<uint32_t>{ 4, 6, 2, 3 });
+  REQUIRE_FALSE(isTriangleMesh(attributes.faceSizes));
+
+  std::vector<uint32_t> T, faceTriangles;
+  triangulate(V, F, attributes.faceSizes, T, faceTriangles);
+  REQUIRE(faceTriangles == std::vector<uint32_t>{ 0, 2, 6, 6, 7 });
+  REQUIRE(T.size() == 7 * 3);
+
+  double square = 0, shape = 0;
+  for (uint32_t t = 0; t < 2; t++) {
+    REQUIRE(area(V, T[t * 3], T[t * 3 + 1], T[t * 3 + 2]) > 0);
+    square += area(V, T[t * 3], T[t * 3 + 1], T[t * 3 + 2]);
+  }
+  for (uint32_t t = 2; t < 6; t++) {
+    REQUIRE(area(V, T[t * 3], T[t * 3 + 1], T[t * 3 + 2]) > 0);
+    shape += area(V, T[t * 3], T[t * 3 + 1], T[t * 3 + 2]);
+  }
+  REQUIRE(square == 1);
+  REQUIRE(shape == 4);
+  REQUIRE(std::vector<uint32_t>(T.end() - 3, T.end()) == std::vector<uint32_t>{ 2, 1, 0 });
+
+  // concave polygon winding clockwise in the xy plane keeps its winding
+  std::vector<uint32_t> reversed{ 9, 8, 7, 6, 5, 4 }, R(12);
+  triangulatePolygon(V.data(), reversed.data(), 6, R.data());
+  double total = 0;
+  for (int t = 0; t < 4; t++) {
+    REQUIRE(area(V, R[t * 3], R[t * 3 + 1], R[t * 3 + 2]) < 0);
+    total += area(V, R[t * 3], R[t * 3 + 1], R[t * 3 + 2]);
+  }
+  REQUIRE(total == -4);
+}
+
+TEST_CASE("triangulate quads and long concave polygons", "") {
+  // a kite longer along x than along y, and a dart concave at corner 6,
+  // whose diagonal through it is the longer one
+  std::vector<float> V{ 0, 0, 0, 2, -.5f, 0, 4, 0, 0, 2, .5f, 0, 0, 0, 0, 10, -1, 0, 9, 0, 0, 10, 1, 0 };
+  std::vector<uint32_t> kite{ 0, 1, 2, 3 }, dart{ 4, 5, 6, 7 }, T(6);
+  triangulatePolygon(V.data(), kite.data(), 4, T.data());
+  REQUIRE(T == std::vector<uint32_t>{ 0, 1, 3, 1, 2, 3 });
+  triangulatePolygon(V.data(), dart.data(), 4, T.data());
+  REQUIRE(T == std::vector<uint32_t>{ 4, 5, 6, 4, 6, 7 });
+  for (int t = 0; t < 2; t++) REQUIRE(area(V, T[t * 3], T[t * 3 + 1], T[t * 3 + 2]) > 0);
+
+  // a comb of 100 teeth, concave at every gap, twice through one scratch
+  V = { 0, 0, 0, 100, 0, 0 };
+  for (int i = 99; i >= 0; i--) V.insert(V.end(), { i + 1.f, 1, 0, i + .5f, 2, 0 });
+  V.insert(V.end(), { 0, 1, 0 });
+  uint32_t n = V.size() / 3;
+  std::vector<uint32_t> comb(n);
+  for (uint32_t i = 0; i < n; i++) comb[i] = i;
+  PolygonScratch scratch;
+  for (int pass = 0; pass < 2; pass++) {
+    T.assign((n - 2) * 3, 0);
+    triangulatePolygon(V.data(), comb.data(), n, T.data(), scratch);
+    double total = 0;
+    for (uint32_t t = 0; t < n - 2; t++) {
+      REQUIRE(area(V, T[t * 3], T[t * 3 + 1], T[t * 3 + 2]) > 0);
+      total += area(V, T[t * 3], T[t * 3 + 1], T[t * 3 + 2]);
+    }
+    REQUIRE(std::abs(total - 150) < 1e-9);
+  }
+}
+
+TEST_CASE("triangulate in parallel", "") {
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  OFFAttributes<float> attributes;
+  REQUIRE(readOFF(DATA_DIR "/screwdriver.off", V, F, &attributes));
+  REQUIRE(isTriangleMesh(attributes.faceSizes));
+
+  ThreadPool pool(4);
+  std::vector<uint32_t> T0, T1, T2, map0, map1, map2;
+  triangulate(V, F, attributes.faceSizes, T0, map0, 1 << 20, pool);
+  triangulate(V, F, attributes.faceSizes, T1, map1, 100, pool);
+  triangulate(V, F, attributes.faceSizes, T2, map2, 0, pool);
+  REQUIRE(T0 == F);
+  REQUIRE(T1 == F);
+  REQUIRE(T2 == F);
+  REQUIRE(map0 == map1);
+  REQUIRE(map0 == map2);
+  REQUIRE(map0.back() == 6786);
+}
@@ -0,0 +1,50 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <array>
+#include "generate.hpp"
+#include "read_off.hpp"
+#include "vertex_cache.hpp"
+
+#define DATA_DIR "../../data"
+
+static std::vector<std::array<uint32_t, 3>> triangles(const std::vector<uint32_t>& F) {
+  std::vector<std::array<uint32_t, 3>> T;
+  for (size_t f = 0; f < F.size(); f += 3) T.push_back({ F[f], F[f + 1], F[f + 2] });
+  std::sort(T.begin(), T.end());
+  return T;
+}
+
+TEST_CASE("vcache analyze", "") {
+  std::vector<uint32_t> one{ 0, 1, 2 }, quad{ 0, 1, 2, 2, 1, 3 }, far{ 0, 1, 2, 3, 4, 5, 0, 1, 2 };
+  REQUIRE(vcache::analyze(one, 3).acmr == 3);
+  REQUIRE(vcache::analyze(quad, 4).acmr == 2);
+  REQUIRE(vcache::analyze(quad, 4).atvr == 1);
+  REQUIRE(vcache::analyze(far, 6, 6).transformed == 6);
+  REQUIRE(vcache::analyze(far, 6, 5).transformed == 9);
+}
+
+TEST_CASE("optimizeVertexCache keeps the triangles", "") {
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  REQUIRE(readOFF(DATA_DIR "/screwdriver.off", V, F));
+  size_t n = V.size() / 3;
+
+  // shuffled like a scan, then reordered
+  for (size_t f = F.size() / 3 - 1; f > 0; f--) {
+    size_t g = hashMix(f) % (f + 1);
+    std::swap_ranges(&F[f * 3], &F[f * 3 + 3], &F[g * 3]);
+  }
+  auto before = vcache::analyze(F, n);
+  std::vector<uint32_t> G = F;
+  optimizeVertexCache(G, n);
+  auto after = vcache::analyze(G, n);
+  REQUIRE(triangles(G) == triangles(F));
+  REQUIRE(after.acmr < before.acmr * .5);
+  REQUIRE(after.acmr < .8);
+
+  // a regular grid reaches close to the 0.5 limit
+  std::vector<float> P;
+  prim::generate(prim::Grid{ { 101, 101 } }, P, F);
+  optimizeVertexCache(F, 101 * 101);
+  REQUIRE(vcache::analyze(F, 101 * 101).acmr < .7);
+}
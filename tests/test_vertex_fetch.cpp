@@ -0,0 +1,74 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include "generate.hpp"
+#include "read_off.hpp"
+#include "vertex_cache.hpp"
+#include "vertex_fetch.hpp"
+
+#define DATA_DIR "../../data"
+
+TEST_CASE("vfetch analyze", "") {
+  // cached vertices are not fetched again
+  std::vector<uint32_t> I{ 0, 1, 2, 2, 1, 3, 0, 5, 9 };
+  REQUIRE(vfetch::analyze(I, 10).distance == 1.8);
+  REQUIRE(vfetch::analyze(I, 10, 12, 2).distance == 2.5);
+  // 6 vertices of 12 bytes on 2 lines
+  REQUIRE(vfetch::analyze(I, 10).overfetch == 64. * 2 / (6 * 12));
+  REQUIRE(vfetch::analyze(I.data(), 1, 10).distance == 0);
+}
+
+TEST_CASE("optimizeVertexFetch renumbers in first-use order", "") {
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  OFFAttributes<float> attributes;
+  REQUIRE(readOFF(DATA_DIR "/screwdriver.off", V, F));
+  size_t n = V.size() / 3;
+  optimizeVertexCache(F, n);
+  // one unused vertex, which must be kept
+  V.insert(V.end(), { 7, 8, 9 });
+  attributes.normals = V;
+  for (size_t i = 0; i <= n; i++) attributes.colors.insert(attributes.colors.end(), { uint8_t(i), uint8_t(i >> 8), 0, 255 });
+
+  std::vector<float> W = V;
+  std::vector<uint32_t> G = F;
+  auto colors = attributes.colors;
+  REQUIRE(optimizeVertexFetch(G, W, &attributes));
+  REQUIRE(W.size() == V.size());
+  REQUIRE(vfetch::analyze(G, n).distance < vfetch::analyze(F, n).distance);
+  REQUIRE(vfetch::analyze(G, n).overfetch < vfetch::analyze(F, n).overfetch * .5);
+  REQUIRE(std::equal(W.end() - 3, W.end(), V.end() - 3));
+
+  uint32_t next = 0;
+  for (size_t i = 0; i < G.size(); i++) {
+    REQUIRE(G[i] <= next);
+    if (G[i] == next) next++;
+    for (int k = 0; k < 3; k++) REQUIRE(W[G[i] * 3 + k] == V[F[i] * 3 + k]);
+    for (int k = 0; k < 4; k++) REQUIRE(attributes.colors[G[i] * 4 + k] == colors[F[i] * 4 + k]);
+  }
+  REQUIRE(attributes.normals == W);
+}
+
+TEST_CASE("optimizeVertexFetch keeps an order it cannot improve", "") {
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  prim::generate(prim::Sphere::withTriangles(20000), V, F);
+  size_t n = V.size() / 3;
+  optimizeVertexCache(F, n);
+  REQUIRE(vfetch::analyze(F, n).overfetch > 1);
+
+  std::vector<float> W = V;
+  std::vector<uint32_t> G = F;
+  bool renumbered = optimizeVertexFetch(G, W);
+  REQUIRE(vfetch::analyze(G, n).overfetch <= vfetch::analyze(F, n).overfetch);
+  if (!renumbered) {
+    REQUIRE(G == F);
+    REQUIRE(W == V);
+  }
+
+  // generated in row order, which first use cannot beat
+  prim::generate(prim::Sphere::withTriangles(20000), V, F);
+  W = V, G = F;
+  REQUIRE_FALSE(optimizeVertexFetch(G, W));
+  REQUIRE(G == F);
+  REQUIRE(W == V);
+}
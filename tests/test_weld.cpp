@@ -0,0 +1,64 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include "generate.hpp"
+#include "weld.hpp"
+
+TEST_CASE("weldVertices merges repeated positions", "") {
+  // cube sphere faces repeat the vertices along the cube edges
+  prim::Sphere sphere{ 40 };
+  std::vector<float> V;
+  std::vector<uint32_t> F;
+  prim::generate(sphere, V, F);
+  std::vector<float> original = V;
+  std::vector<uint32_t> faces = F;
+
+  OFFAttributes<float> attributes;
+  attributes.normals = V;
+  attributes.colors.resize(V.size() / 3 * 4, 7);
+
+  auto stats = weldVertices(V, F, 0.f, &attributes);
+  REQUIRE(stats.vertices == sphere.vertexCount());
+  REQUIRE(stats.welded == 6 * 40 * 40 + 2);
+  REQUIRE(V.size() == stats.welded * 3);
+  REQUIRE(attributes.normals == V);
+  REQUIRE(attributes.colors.size() == stats.welded * 4);
+  for (size_t f = 0; f < F.size(); f++)
+    for (int k = 0; k < 3; k++) REQUIRE(V[F[f] * 3 + k] == original[faces[f] * 3 + k]);
+
+  // nothing left to merge
+  REQUIRE(weldVertices(V, F).removed() == 0);
+}
+
+TEST_CASE("weldVertices within epsilon", "") {
+  // clusters of 4 jittered copies, well apart from each other
+  std::vector<float> V;
+  std::vector<uint16_t> F;
+  uint64_t state = 1;
+  auto jitter = [&] { return float(hashMix(state++) >> 40) / float(1 << 24) * 1e-3f - .5e-3f; };
+  for (int i = 0; i < 2000; i++)
+    for (int copy = 0; copy < 4; copy++) {
+      V.insert(V.end(), { i % 20 + jitter(), i / 20 % 10 + jitter(), i / 200 + jitter() });
+      F.push_back(uint16_t(copy * 2000 + i));
+    }
+  std::vector<float> original = V;
+
+  ThreadPool pool(4);
+  std::vector<float> W = V;
+  std::vector<uint16_t> G = F;
+  auto stats = weldVertices(W, G, 2e-3f, nullptr, pool);
+  REQUIRE(stats.welded == 2000);
+  REQUIRE(stats.ratio() == .25);
+  for (size_t i = 0; i < F.size(); i++)
+    for (int k = 0; k < 3; k++) REQUIRE(std::abs(W[G[i] * 3 + k] - original[F[i] * 3 + k]) <= 1e-3f);
+
+  // the same result on one thread
+  ThreadPool single(1);
+  std::vector<uint16_t> H = F;
+  weldVertices(V, H, 2e-3f, nullptr, single);
+  REQUIRE(V == W);
+  REQUIRE(H == G);
+
+  // too small an epsilon merges nothing
+  V = original;
+  REQUIRE(weldVertices(V, F, 1e-6f).removed() == 0);
+}
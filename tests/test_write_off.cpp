@@ -0,0 +1,104 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include "read_off.hpp"
+#include "write_off.hpp"
+
+#define DATA_DIR "../../data"
+
+static std::string tempPath(const char* name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+static std::string contents(const std::string& path) {
+  std::stringstream ss;
+  ss << std::ifstream(path, std::ios::binary).rdbuf();
+  return ss.str();
+}
+
+TEST_CASE("writeOFF round trip", "") {
+  std::vector<float> V0, V1;
+  std::vector<uint32_t> F0, F1;
+  REQUIRE(readOFF(DATA_DIR "/screwdriver.off", V0, F0));
+
+  for (bool binary : { false, true }) {
+    std::string path = tempPath(binary ? "roundtrip_binary.off" : "roundtrip.off");
+    REQUIRE(writeOFF(path, V0, F0, nullptr, binary));
+    REQUIRE(readOFF(path, V1, F1));
+    REQUIRE(V0 == V1);
+    REQUIRE(F0 == F1);
+  }
+
+  std::vector<double> D0{ 0.1, -1e-300, 3.141592653589793, 1e22, 5e-324, -0. }, D1;
+  std::vector<int> T{ 0, 1, 0 };
+  REQUIRE(writeOFF(tempPath("doubles.off"), D0, T));
+  REQUIRE(readOFF(tempPath("doubles.off"), D1, T));
+  REQUIRE(D0 == D1);
+}
+
+TEST_CASE("writeOFF attributes", "") {
+  std::vector<float> V{ 0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, .5f, 2, 0 };
+  std::vector<uint32_t> F{ 0, 1, 2, 3, 3, 2, 4 };
+  OFFAttributes<float> attributes;
+  attributes.normals = { 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, -1 };
+  attributes.colors = { 255, 0, 0, 255, 0, 255, 0, 255, 0, 0, 255, 128, 1, 2, 3, 4, 10, 20, 30, 40 };
+  attributes.faceSizes = { 4, 3 };
+
+  for (bool binary : { false, true }) {
+    std::string path = tempPath(binary ? "attributes_binary.off" : "attributes.off");
+    REQUIRE(writeOFF(path, V, F, &attributes, binary));
+    REQUIRE(contents(path).compare(0, 5, "CNOFF") == 0);
+
+    std::vector<float> V1;
+    std::vector<uint32_t> F1;
+    OFFAttributes<float> read;
+    REQUIRE(readOFF(path, V1, F1, &read));
+    REQUIRE(V1 == V);
+    REQUIRE(F1 == F);
+    REQUIRE(read.normals == attributes.normals);
+    REQUIRE(read.colors == attributes.colors);
+    REQUIRE(read.faceSizes == attributes.faceSizes);
+  }
+}
+
+TEST_CASE("writeOFF in parallel chunks", "") {
+  std::vector<float> V;
+  std::vector<uint16_t> F;
+  REQUIRE(readOFF(DATA_DIR "/screwdriver.off", V, F));
+
+  ThreadPool pool(4);
+  for (bool binary : { false, true }) {
+    REQUIRE(writeOFF(tempPath("serial.off"), V, F, nullptr, binary, 1 << 20, pool));
+    REQUIRE(writeOFF(tempPath("chunked.off"), V, F, nullptr, binary, 100, pool));
+    REQUIRE(contents(tempPath("serial.off")) == contents(tempPath("chunked.off")));
+  }
+  REQUIRE_FALSE(writeOFF(tempPath("missing/dir.off"), V, F));
+}
+
+TEST_CASE("writeOFF rejects mismatched face sizes", "") {
+  std::vector<float> V{ 0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0 };
+  std::vector<uint32_t> F{ 0, 1, 2, 3 };
+  OFFAttributes<float> attributes;
+  for (auto sizes : { std::vector<uint32_t>{ 3, 3 }, std::vector<uint32_t>{ 3 } }) {
+    attributes.faceSizes = sizes;
+    REQUIRE_FALSE(writeOFF(tempPath("mismatched.off"), V, F, &attributes));
+  }
+  attributes.faceSizes = { 4 };
+  REQUIRE(writeOFF(tempPath("quad.off"), V, F, &attributes, false, 0));
+}
+
+TEST_CASE("writeOFF rejects mismatched normals and colors", "") {
+  std::vector<float> V{ 0, 0, 0, 1, 0, 0, 0, 1, 0 };
+  std::vector<uint32_t> F{ 0, 1, 2 };
+  for (bool binary : { false, true }) {
+    OFFAttributes<float> attributes;
+    attributes.normals = { 0, 0, 1, 0, 0, 1 };
+    REQUIRE_FALSE(writeOFF(tempPath("short_normals.off"), V, F, &attributes, binary));
+    attributes.normals.insert(attributes.normals.end(), { 0, 0, 1 });
+    attributes.colors = { 255, 0, 0, 255, 0, 255, 0, 255 };
+    REQUIRE_FALSE(writeOFF(tempPath("short_colors.off"), V, F, &attributes, binary));
+    attributes.colors.insert(attributes.colors.end(), { 0, 0, 255, 255 });
+    REQUIRE(writeOFF(tempPath("matched.off"), V, F, &attributes, binary));
+  }
+}